@@ -0,0 +1,14 @@
+#version 450
+
+// Copies the lit G-buffer into the swap chain pass, with its depth, so what draws forward
+// afterwards (skybox, blended meshes, light billboards) is tested against the deferred geometry
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D litImage;
+layout(set = 0, binding = 1) uniform sampler2D depthImage;
+
+void main() {
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	outColor = vec4(texelFetch(litImage, pixel, 0).rgb, 1.0);
+	gl_FragDepth = texelFetch(depthImage, pixel, 0).r;
+}
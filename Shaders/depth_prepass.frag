@@ -0,0 +1,18 @@
+#version 450
+
+// Depth prepass with LOD cross-fade on: drops the same dithered pixels as the shading pass, so
+// both LODs of a fade leave their depth where they are drawn. Without cross-fade the prepass
+// has no fragment shader at all.
+layout(location = 4) flat in float fragLodFade;
+
+// 4x4 ordered dither, a threshold in (0, 1) per pixel
+float ditherThreshold() {
+	const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+	ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+	return (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+}
+
+void main(){
+	if (fragLodFade > 0.0 && ditherThreshold() < fragLodFade) discard;
+	if (fragLodFade < 0.0 && ditherThreshold() >= -fragLodFade) discard;
+}
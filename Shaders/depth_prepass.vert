@@ -0,0 +1,64 @@
+#version 450
+#ifdef VERTEX_PULLING
+#extension GL_EXT_buffer_reference : require
+#endif
+
+// Depth prepass: the position only, transformed exactly like the shading vertex shaders do it
+// (all of them declare gl_Position invariant), so their EQUAL depth test passes on the same
+// pixels. Compiled a second time with -DVERTEX_PULLING for pipelines without vertex input.
+
+#ifdef VERTEX_PULLING
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer VertexData {
+	float values[];
+};
+
+// LveModel::Vertex: position, color, normal, uv as 11 tightly packed floats
+const uint VERTEX_FLOATS = 11;
+#else
+layout(location = 0) in vec3 position;
+#endif
+
+layout(location = 4) flat out float fragLodFade; // read by the dithered prepass fragment shader
+
+invariant gl_Position;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projection;
+    mat4 view;
+	mat4 inverseView;
+	//vec3 directionToLight;
+	vec4 ambientLightColor;
+	uvec4 clusterGrid; // clusters along x, y and depth, w is the light count
+	vec4 clusterSlicing; // x,y tile size in pixels, z,w scale and bias of the log depth slices
+} ubo;
+
+// One entry per draw (or per instance), written by SimpleRenderSystem every frame
+struct ObjectData {
+	vec4 modelRows[3]; // 3x4 model matrix by rows, the last row is 0 0 0 1
+	vec4 normalScale;  // inverse squared scale per axis, so mat3(model) * scale is the normal matrix; LOD cross-fade in w
+};
+
+layout(set = 2, binding = 0) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+} objectBuffer;
+
+layout(push_constant) uniform Push{
+	uint textureIndex; // unused here
+#ifdef VERTEX_PULLING
+	VertexData vertices; // device address of the mesh's vertex buffer
+#endif
+} push;
+
+void main(){
+#ifdef VERTEX_PULLING
+	uint base = uint(gl_VertexIndex) * VERTEX_FLOATS;
+	vec3 position = vec3(push.vertices.values[base], push.vertices.values[base + 1], push.vertices.values[base + 2]);
+#endif
+	ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+
+	vec4 localPosition = vec4(position, 1.0f);
+	vec3 positionWorld = vec3(dot(object.modelRows[0], localPosition), dot(object.modelRows[1], localPosition), dot(object.modelRows[2], localPosition));
+	gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0f);
+
+	fragLodFade = object.normalScale.w;
+}
@@ -0,0 +1,54 @@
+#version 450
+
+// G-buffer pass of deferred shading: albedo and the world space normal, lit afterwards by
+// tiled_lighting.comp. Compiled plain, with -DLOD_DITHER and with -DALPHA_TEST, like simple_shader.frag.
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec3 fragPosWorld;
+layout(location = 2) in vec3 fragNormalWorld;
+layout(location = 3) in vec2 fragUV;
+#ifdef LOD_DITHER
+layout(location = 4) flat in float fragLodFade;
+#endif
+
+layout(location = 0) out vec4 outAlbedo;
+layout(location = 1) out vec2 outNormal;
+
+layout(set = 1, binding = 0) uniform sampler2D diffTex;
+
+layout(push_constant) uniform Push{
+	uint textureIndex; // bindless texture slot, unused by this shader
+}push;
+
+#ifdef LOD_DITHER
+// 4x4 ordered dither, a threshold in (0, 1) per pixel
+float ditherThreshold() {
+	const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+	ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+	return (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+}
+#endif
+
+// Octahedral encoding: the unit normal projected onto |x| + |y| + |z| = 1, with the lower half
+// folded over the upper one, leaves two components in [-1, 1]
+vec2 encodeNormal(vec3 n) {
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	if (n.z < 0.0) {
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return n.xy;
+}
+
+const float ALPHA_CUTOFF = 0.5;
+
+void main(){
+	vec4 texDiff = texture(diffTex, fragUV);
+#ifdef ALPHA_TEST
+	if (texDiff.a < ALPHA_CUTOFF) discard;
+#endif
+#ifdef LOD_DITHER
+	if (fragLodFade > 0.0 && ditherThreshold() < fragLodFade) discard;
+	if (fragLodFade < 0.0 && ditherThreshold() >= -fragLodFade) discard;
+#endif
+	outAlbedo = vec4(texDiff.rgb, 1.0);
+	outNormal = encodeNormal(normalize(fragNormalWorld));
+}
@@ -11,19 +11,14 @@ const vec2 OFFSETS[6] = vec2[](
 
 layout (location = 0) out vec2 fragOffset;
 
-struct Light{
-	vec4 position;
-	vec4 color;
-};
-
 layout(set = 0, binding = 0) uniform GlobalUbo {
 	mat4 projection;
     mat4 view;
 	mat4 inverseView;
 	//vec3 directionToLight;
 	vec4 ambientLightColor;
-	Light lights[10];
-	int numLights;
+	uvec4 clusterGrid; // clusters along x, y and depth, w is the light count
+	vec4 clusterSlicing; // x,y tile size in pixels, z,w scale and bias of the log depth slices
 } ubo;
 
 layout (push_constant) uniform Push{
@@ -9,11 +9,9 @@ layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec2 fragUV;
+layout(location = 4) flat out float fragLodFade; // LOD cross-fade, read by the dithered fragment shaders
 
-struct Light{
-	vec4 position;
-	vec4 color;
-};
+invariant gl_Position; // the same as in the depth prepass, whose depth is tested for EQUAL
 
 layout(set = 0, binding = 0) uniform GlobalUbo {
 	mat4 projection;
@@ -21,21 +19,37 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
 	mat4 inverseView;
 	//vec3 directionToLight;
 	vec4 ambientLightColor;
-	Light lights[10];
-	int numLights;
+	uvec4 clusterGrid; // clusters along x, y and depth, w is the light count
+	vec4 clusterSlicing; // x,y tile size in pixels, z,w scale and bias of the log depth slices
 } ubo;
 
+// One entry per draw (or per instance), written by SimpleRenderSystem every frame
+struct ObjectData {
+	vec4 modelRows[3]; // 3x4 model matrix by rows, the last row is 0 0 0 1
+	vec4 normalScale;  // inverse squared scale per axis, so mat3(model) * scale is the normal matrix; LOD cross-fade in w
+};
+
+layout(set = 2, binding = 0) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+} objectBuffer;
+
 layout(push_constant) uniform Push{
-	mat4 modelMatrix;
-	mat4 normalMatrix;
+	uint textureIndex; // bindless texture slot, read by the fragment shader
 } push;
 
 void main(){
-	vec4 positionWorld = push.modelMatrix * vec4(position, 1.0f); 
-	gl_Position = ubo.projection * ubo.view * positionWorld;
+	// gl_InstanceIndex includes the draw's firstInstance, which points at its entry (instanced
+	// draws at the first entry of the model's group)
+	ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+
+	vec4 localPosition = vec4(position, 1.0f);
+	vec3 positionWorld = vec3(dot(object.modelRows[0], localPosition), dot(object.modelRows[1], localPosition), dot(object.modelRows[2], localPosition));
+	gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0f);
 
-	fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
-	fragPosWorld = positionWorld.xyz;
+	vec3 scaledNormal = normal * object.normalScale.xyz;
+	fragNormalWorld = normalize(vec3(dot(object.modelRows[0].xyz, scaledNormal), dot(object.modelRows[1].xyz, scaledNormal), dot(object.modelRows[2].xyz, scaledNormal)));
+	fragPosWorld = positionWorld;
 	fragColor = color;
 	fragUV = uv;
+	fragLodFade = object.normalScale.w;
 }
\ No newline at end of file
@@ -0,0 +1,127 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec3 fragPosWorld;
+layout(location = 2) in vec3 fragNormalWorld;
+layout(location = 3) in vec2 fragUV;
+#ifdef LOD_DITHER
+layout(location = 4) flat in float fragLodFade;
+#endif
+
+
+layout(location = 0) out vec4 outColor;
+
+struct PointLight{
+	vec4 position; // w is the range, where the light has faded out
+	vec4 color; // w is the intensity
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projection;
+    mat4 view;
+	mat4 inverseView;
+	//vec3 directionToLight;
+	vec4 ambientLightColor;
+	uvec4 clusterGrid; // clusters along x, y and depth, w is the light count
+	vec4 clusterSlicing; // x,y tile size in pixels, z,w scale and bias of the log depth slices
+} ubo;
+
+// Clustered lights, binned by LveLightClusters: each cluster has an offset and a count into lightIndices
+layout(set = 0, binding = 2) readonly buffer LightBuffer {
+	PointLight lights[];
+} lightBuffer;
+
+layout(set = 0, binding = 3) readonly buffer ClusterBuffer {
+	uvec2 clusters[];
+} clusterBuffer;
+
+layout(set = 0, binding = 4) readonly buffer LightIndexBuffer {
+	uint lightIndices[];
+} lightIndexBuffer;
+
+layout(set = 1, binding = 0) uniform sampler2D textures[]; // bindless table, partially bound
+
+layout(push_constant) uniform Push{
+	uint textureIndex; // slot of the diffuse texture in the table
+}push;
+
+#ifdef LOD_DITHER
+// 4x4 ordered dither, a threshold in (0, 1) per pixel
+float ditherThreshold() {
+	const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+	ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+	return (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+}
+#endif
+
+// The cluster this fragment falls in: its screen tile, and the depth slice of its view space depth
+uint clusterIndex() {
+	uvec2 tile = min(uvec2(gl_FragCoord.xy / ubo.clusterSlicing.xy), ubo.clusterGrid.xy - 1);
+	float viewDepth = (ubo.view * vec4(fragPosWorld, 1.0)).z;
+	uint slice = uint(clamp(log(max(viewDepth, 1e-4)) * ubo.clusterSlicing.z + ubo.clusterSlicing.w, 0.0, float(ubo.clusterGrid.z - 1)));
+	return (slice * ubo.clusterGrid.y + tile.y) * ubo.clusterGrid.x + tile.x;
+}
+
+// Alpha variants, one per render bucket: ALPHA_TEST cuts out at the cutoff, ALPHA_TO_COVERAGE
+// (under MSAA) lets the alpha pick the covered samples, ALPHA_BLEND outputs it for blending.
+// Without any of them alpha is ignored and nothing is discarded, which keeps early depth testing.
+const float ALPHA_CUTOFF = 0.5;
+
+void main(){
+	vec4 texDiff = texture(textures[nonuniformEXT(push.textureIndex)], fragUV);
+#if defined(ALPHA_TEST)
+	if (texDiff.a < ALPHA_CUTOFF) discard;
+#elif defined(ALPHA_TO_COVERAGE)
+	// sharpened around the cutoff, so the edge is about a pixel of partial coverage instead of
+	// see-through wherever the mask is soft or magnified
+	texDiff.a = clamp((texDiff.a - ALPHA_CUTOFF) / max(fwidth(texDiff.a), 0.0001) + 0.5, 0.0, 1.0);
+	if (texDiff.a <= 0.0) discard;
+#elif defined(ALPHA_BLEND)
+	if (texDiff.a <= 0.0) discard; // nothing to blend
+#else
+	texDiff.a = 1.0;
+#endif
+#ifdef LOD_DITHER
+	// Cross-fade between two LODs drawn on top of each other: the outgoing one (fade > 0) keeps
+	// exactly the pixels the incoming one (fade < 0) drops
+	if (fragLodFade > 0.0 && ditherThreshold() < fragLodFade) discard;
+	if (fragLodFade < 0.0 && ditherThreshold() >= -fragLodFade) discard;
+#endif
+	vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
+	vec3 specularLight = vec3(0.0f);
+	vec3 surfaceNormal = normalize(fragNormalWorld);
+
+	vec3 cameraPosWorld = ubo.inverseView[3].xyz;
+	vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld); // Direction from fragment to camera
+
+	uvec2 cluster = clusterBuffer.clusters[clusterIndex()];
+	for(uint i = 0; i < cluster.y; i++){
+		PointLight light = lightBuffer.lights[lightIndexBuffer.lightIndices[cluster.x + i]];
+		
+		// Diffuse light
+		vec3 directionToLight = light.position.xyz - fragPosWorld;
+		float distanceSquared = dot(directionToLight, directionToLight);
+		// fades to zero at the range the light was binned with, instead of the physical 1/d^2
+		float rangeFactor = clamp(1.0 - pow(distanceSquared / (light.position.w * light.position.w), 2.0), 0.0, 1.0);
+		if (rangeFactor <= 0.0) continue;
+		directionToLight = normalize(directionToLight);
+
+
+		float cosAngIncidence = max(dot(surfaceNormal, directionToLight), 0.0);
+		vec3 intensity = light.color.xyz * light.color.w * rangeFactor * rangeFactor;
+
+		diffuseLight += intensity * cosAngIncidence;
+
+		// Specular light
+		vec3 halfAngle = normalize(viewDirection + directionToLight);
+		float blinnTerm = dot(surfaceNormal, halfAngle);
+		blinnTerm = clamp(blinnTerm, 0.0, 1.0);
+		blinnTerm = pow(blinnTerm, 64.0); // Shininess factor (can be replaced with the specular map)
+		specularLight += intensity * blinnTerm;
+	}
+	// Ambient light
+	vec3 ambientLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
+	
+	outColor = vec4(diffuseLight * texDiff.rgb + specularLight * texDiff.rgb, texDiff.a);
+}
\ No newline at end of file
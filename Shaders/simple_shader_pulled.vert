@@ -0,0 +1,72 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+
+// Vertices are read straight from the mesh's vertex buffer (programmable vertex pulling),
+// the pipeline has no vertex input state
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer VertexData {
+	float values[];
+};
+
+// LveModel::Vertex: position, color, normal, uv as 11 tightly packed floats
+const uint VERTEX_FLOATS = 11;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragUV;
+layout(location = 4) flat out float fragLodFade; // LOD cross-fade, read by the dithered fragment shaders
+
+invariant gl_Position; // the same as in the depth prepass, whose depth is tested for EQUAL
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projection;
+    mat4 view;
+	mat4 inverseView;
+	//vec3 directionToLight;
+	vec4 ambientLightColor;
+	uvec4 clusterGrid; // clusters along x, y and depth, w is the light count
+	vec4 clusterSlicing; // x,y tile size in pixels, z,w scale and bias of the log depth slices
+} ubo;
+
+// One entry per draw (or per instance), written by SimpleRenderSystem every frame
+struct ObjectData {
+	vec4 modelRows[3]; // 3x4 model matrix by rows, the last row is 0 0 0 1
+	vec4 normalScale;  // inverse squared scale per axis, so mat3(model) * scale is the normal matrix; LOD cross-fade in w
+};
+
+layout(set = 2, binding = 0) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+} objectBuffer;
+
+layout(push_constant) uniform Push{
+	uint textureIndex; // bindless texture slot, read by the fragment shader
+	VertexData vertices; // device address of the mesh's vertex buffer
+} push;
+
+vec3 fetchVec3(uint base) {
+	return vec3(push.vertices.values[base], push.vertices.values[base + 1], push.vertices.values[base + 2]);
+}
+
+void main(){
+	// gl_VertexIndex already includes the draw's vertexOffset, so merged draws just work
+	uint base = uint(gl_VertexIndex) * VERTEX_FLOATS;
+	vec3 position = fetchVec3(base);
+	vec3 color = fetchVec3(base + 3);
+	vec3 normal = fetchVec3(base + 6);
+	vec2 uv = vec2(push.vertices.values[base + 9], push.vertices.values[base + 10]);
+
+	// gl_InstanceIndex includes the draw's firstInstance, which points at its entry (instanced
+	// draws at the first entry of the model's group)
+	ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+
+	vec4 localPosition = vec4(position, 1.0f);
+	vec3 positionWorld = vec3(dot(object.modelRows[0], localPosition), dot(object.modelRows[1], localPosition), dot(object.modelRows[2], localPosition));
+	gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0f);
+
+	vec3 scaledNormal = normal * object.normalScale.xyz;
+	fragNormalWorld = normalize(vec3(dot(object.modelRows[0].xyz, scaledNormal), dot(object.modelRows[1].xyz, scaledNormal), dot(object.modelRows[2].xyz, scaledNormal)));
+	fragPosWorld = positionWorld;
+	fragColor = color;
+	fragUV = uv;
+	fragLodFade = object.normalScale.w;
+}
@@ -0,0 +1,417 @@
+#include "deferred_render_system.h"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+    struct LightingPushConstantData {
+        glm::mat4 inverseProjection; // screen to view space
+        glm::ivec2 size;
+    };
+
+    constexpr uint32_t LIGHTING_TILE_SIZE = 16;
+
+    static bool hasStencilComponent(VkFormat format) {
+        return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+    }
+
+    DeferredRenderSystem::DeferredRenderSystem(LveDevice& device, VkRenderPass swapChainRenderPass, VkDescriptorSetLayout globalSetLayout)
+        : lveDevice{ device } {
+        depthFormat = lveDevice.findSupportedFormat(
+            { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+        createRenderPasses();
+        createPipelineLayouts(globalSetLayout);
+        createPipelines(swapChainRenderPass);
+        createSampler();
+    }
+
+    DeferredRenderSystem::~DeferredRenderSystem() {
+        destroyTargets();
+        lveDevice.deletionQueue().retire(
+            [device = lveDevice.device(), sampler = sampler, renderPass = renderPass, resumeRenderPass = resumeRenderPass]() {
+                vkDestroySampler(device, sampler, nullptr);
+                vkDestroyRenderPass(device, renderPass, nullptr);
+                vkDestroyRenderPass(device, resumeRenderPass, nullptr);
+            });
+        vkDestroyPipelineLayout(lveDevice.device(), lightingPipelineLayout, nullptr);
+        vkDestroyPipelineLayout(lveDevice.device(), compositePipelineLayout, nullptr);
+    }
+
+    void DeferredRenderSystem::createRenderPasses() {
+        std::array<VkAttachmentDescription, 3> attachments{};
+        for (auto& attachment : attachments) {
+            attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // read by the lighting, kept for the resume pass
+            attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        }
+        attachments[0].format = ALBEDO_FORMAT;
+        attachments[1].format = NORMAL_FORMAT;
+        attachments[2].format = depthFormat;
+        attachments[2].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL; // as the depth pyramid expects it
+
+        std::array<VkAttachmentReference, 2> colorAttachmentRefs{ {
+            { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+            { 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL } } };
+        VkAttachmentReference depthAttachmentRef{ 2, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = static_cast<uint32_t>(colorAttachmentRefs.size());
+        subpass.pColorAttachments = colorAttachmentRefs.data();
+        subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+        // The previous frame's lighting and composite read these images, only an execution
+        // dependency is needed before they are overwritten
+        VkSubpassDependency dependency{};
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dependency.srcAccessMask = 0;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        renderPassInfo.pAttachments = attachments.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = 1;
+        renderPassInfo.pDependencies = &dependency;
+        if (vkCreateRenderPass(lveDevice.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create G-buffer render pass!");
+        }
+
+        // Resume pass, like the swap chain's: the depth pyramid in between synchronizes the depth itself
+        attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[1].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachments[2].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[2].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDependency resumeDependency{};
+        resumeDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        resumeDependency.dstSubpass = 0;
+        resumeDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        resumeDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        resumeDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        resumeDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        renderPassInfo.pDependencies = &resumeDependency;
+        if (vkCreateRenderPass(lveDevice.device(), &renderPassInfo, nullptr, &resumeRenderPass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create G-buffer resume render pass!");
+        }
+    }
+
+    void DeferredRenderSystem::createPipelineLayouts(VkDescriptorSetLayout globalSetLayout) {
+        lightingSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT) // albedo
+            .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT) // normal
+            .addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT) // depth
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)          // lit color
+            .build();
+        compositeSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT) // lit color
+            .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT) // depth
+            .build();
+
+        // the lighting reads the ubo and the lights of the global set
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(LightingPushConstantData);
+
+        std::array<VkDescriptorSetLayout, 2> lightingSetLayouts{ globalSetLayout, lightingSetLayout->getDescriptorSetLayout() };
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(lightingSetLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = lightingSetLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &lightingPipelineLayout) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        VkDescriptorSetLayout compositeLayout = compositeSetLayout->getDescriptorSetLayout();
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &compositeLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
+        if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &compositePipelineLayout) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void DeferredRenderSystem::createPipelines(VkRenderPass swapChainRenderPass) {
+        assert(lightingPipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+        lightingPipeline = std::make_unique<LveComputePipeline>(lveDevice, "Shaders/tiled_lighting.comp.spv", lightingPipelineLayout);
+
+        // A fullscreen triangle that overwrites color and depth, whatever the swap chain pass had
+        PipelineConfigInfo pipelineConfig{};
+        LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+        pipelineConfig.bindingDescriptions.clear();
+        pipelineConfig.attributeDescriptions.clear();
+        pipelineConfig.rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+        pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_ALWAYS;
+        pipelineConfig.multisampleInfo.rasterizationSamples = lveDevice.getMsaaSampleCount();
+        pipelineConfig.renderPass = swapChainRenderPass;
+        pipelineConfig.pipelineLayout = compositePipelineLayout;
+        compositePipeline = std::make_unique<LvePipeline>(
+            lveDevice, "Shaders/deferred_composite.vert.spv", "Shaders/deferred_composite.frag.spv", pipelineConfig);
+    }
+
+    void DeferredRenderSystem::createSampler() {
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.minLod = 0.f;
+        samplerInfo.maxLod = 0.f;
+        if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create G-buffer sampler!");
+        }
+    }
+
+    DeferredRenderSystem::Target DeferredRenderSystem::createTarget(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect) {
+        Target target{};
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = extent.width;
+        imageInfo.extent.height = extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = usage;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        lveDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, target.image, target.memory);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = target.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange = { aspect, 0, 1, 0, 1 };
+        if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &target.view) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create G-buffer view!");
+        }
+        return target;
+    }
+
+    void DeferredRenderSystem::createTargets(VkExtent2D newExtent) {
+        destroyTargets();
+        extent = newExtent;
+        albedo = createTarget(ALBEDO_FORMAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+        normal = createTarget(NORMAL_FORMAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+        depth = createTarget(depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_DEPTH_BIT);
+        lit = createTarget(LIT_FORMAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+        std::array<VkImageView, 3> attachments{ albedo.view, normal.view, depth.view };
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebufferInfo.pAttachments = attachments.data();
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+        if (vkCreateFramebuffer(lveDevice.device(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create G-buffer framebuffer!");
+        }
+    }
+
+    void DeferredRenderSystem::destroyTargets() {
+        if (framebuffer == VK_NULL_HANDLE) return;
+        lveDevice.deletionQueue().retire(
+            [device = lveDevice.device(), framebuffer = framebuffer, targets = std::array<Target, 4>{ albedo, normal, depth, lit }]() {
+                vkDestroyFramebuffer(device, framebuffer, nullptr);
+                for (const auto& target : targets) {
+                    vkDestroyImageView(device, target.view, nullptr);
+                    vkDestroyImage(device, target.image, nullptr);
+                    vkFreeMemory(device, target.memory, nullptr);
+                }
+            });
+        framebuffer = VK_NULL_HANDLE;
+        albedo = normal = depth = lit = Target{};
+    }
+
+    void DeferredRenderSystem::beginGBufferPass(FrameInfo& frameInfo, bool resume) {
+        if (framebuffer == VK_NULL_HANDLE || frameInfo.extent.width != extent.width || frameInfo.extent.height != extent.height) {
+            assert(!resume && "The G-buffer was resized between two passes of a frame");
+            createTargets(frameInfo.extent); // the old one is retired once the frames reading it are done
+        }
+
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = resume ? resumeRenderPass : renderPass;
+        renderPassInfo.framebuffer = framebuffer;
+        renderPassInfo.renderArea.offset = { 0, 0 };
+        renderPassInfo.renderArea.extent = extent;
+
+        std::array<VkClearValue, 3> clearValues{};
+        clearValues[0].color = { 0.f, 0.f, 0.f, 0.f };
+        clearValues[1].color = { 0.f, 0.f, 0.f, 0.f };
+        clearValues[2].depthStencil = { 1.0f, 0 };
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassInfo.pClearValues = clearValues.data();
+        vkCmdBeginRenderPass(frameInfo.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport{ 0.f, 0.f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.f, 1.f };
+        VkRect2D scissor{ { 0, 0 }, extent };
+        vkCmdSetViewport(frameInfo.commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(frameInfo.commandBuffer, 0, 1, &scissor);
+    }
+
+    void DeferredRenderSystem::endGBufferPass(FrameInfo& frameInfo) {
+        vkCmdEndRenderPass(frameInfo.commandBuffer);
+    }
+
+    LveDepthTarget DeferredRenderSystem::getDepthTarget() const {
+        return { depth.image, depth.view, depthFormat, extent, VK_SAMPLE_COUNT_1_BIT };
+    }
+
+    void DeferredRenderSystem::light(FrameInfo& frameInfo) {
+        assert(framebuffer != VK_NULL_HANDLE && "Lighting before any G-buffer pass");
+        VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (hasStencilComponent(depthFormat)) {
+            depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT; // both aspects share one layout
+        }
+
+        // --- The G-buffer becomes readable, by the lighting and the composite after it, and the
+        // lit image writable (its old contents are not needed) ---
+        std::array<VkImageMemoryBarrier, 4> startBarriers{};
+        for (auto& barrier : startBarriers) {
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        }
+        startBarriers[0].image = albedo.image;
+        startBarriers[1].image = normal.image;
+
+        startBarriers[2].image = depth.image;
+        startBarriers[2].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        startBarriers[2].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        startBarriers[2].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        startBarriers[2].subresourceRange.aspectMask = depthAspect;
+
+        startBarriers[3].image = lit.image;
+        startBarriers[3].srcAccessMask = 0; // only the previous frame's composite read to wait for
+        startBarriers[3].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        startBarriers[3].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        startBarriers[3].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        vkCmdPipelineBarrier(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr,
+            static_cast<uint32_t>(startBarriers.size()), startBarriers.data());
+
+        VkDescriptorImageInfo albedoInfo{ sampler, albedo.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        VkDescriptorImageInfo normalInfo{ sampler, normal.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        VkDescriptorImageInfo depthInfo{ sampler, depth.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+        VkDescriptorImageInfo litInfo{ VK_NULL_HANDLE, lit.view, VK_IMAGE_LAYOUT_GENERAL };
+        VkDescriptorSet lightingSet;
+        if (!LveDescriptorWriter(*lightingSetLayout, frameInfo.frameDescriptorAllocator)
+            .writeImage(0, &albedoInfo)
+            .writeImage(1, &normalInfo)
+            .writeImage(2, &depthInfo)
+            .writeImage(3, &litInfo)
+            .build(lightingSet)) {
+            throw std::runtime_error("failed to allocate tiled lighting descriptor set!");
+        }
+
+        lightingPipeline->bind(frameInfo.commandBuffer);
+        std::array<VkDescriptorSet, 2> sets{ frameInfo.globalDescriptorSet, lightingSet };
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            lightingPipelineLayout,
+            0, static_cast<uint32_t>(sets.size()),
+            sets.data(),
+            0, nullptr);
+
+        LightingPushConstantData push{};
+        push.inverseProjection = glm::inverse(frameInfo.camera.getProjection());
+        push.size = glm::ivec2{ extent.width, extent.height };
+        vkCmdPushConstants(
+            frameInfo.commandBuffer,
+            lightingPipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(LightingPushConstantData),
+            &push);
+        vkCmdDispatch(
+            frameInfo.commandBuffer,
+            (extent.width + LIGHTING_TILE_SIZE - 1) / LIGHTING_TILE_SIZE,
+            (extent.height + LIGHTING_TILE_SIZE - 1) / LIGHTING_TILE_SIZE,
+            1);
+
+        // --- The composite reads the lit image ---
+        VkImageMemoryBarrier litBarrier = startBarriers[3];
+        litBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        litBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        litBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        litBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &litBarrier);
+    }
+
+    void DeferredRenderSystem::composite(FrameInfo& frameInfo) {
+        VkDescriptorImageInfo litInfo{ sampler, lit.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        VkDescriptorImageInfo depthInfo{ sampler, depth.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+        VkDescriptorSet compositeSet;
+        if (!LveDescriptorWriter(*compositeSetLayout, frameInfo.frameDescriptorAllocator)
+            .writeImage(0, &litInfo)
+            .writeImage(1, &depthInfo)
+            .build(compositeSet)) {
+            throw std::runtime_error("failed to allocate deferred composite descriptor set!");
+        }
+
+        compositePipeline->bind(frameInfo.commandBuffer);
+        frameInfo.renderStats.pipelineBinds++;
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            compositePipelineLayout,
+            0, 1,
+            &compositeSet,
+            0, nullptr);
+        frameInfo.renderStats.descriptorBinds++;
+        vkCmdDraw(frameInfo.commandBuffer, 3, 1, 0, 0);
+    }
+
+}  // namespace lve
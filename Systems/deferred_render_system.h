@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../lve_device.h"
+#include "../lve_pipeline.h"
+#include "../lve_descriptors.h"
+#include "../lve_frame_info.h"
+#include "../lve_swap_chain.h"
+
+// std
+#include <memory>
+
+namespace lve {
+	// Tiled deferred shading. SimpleRenderSystem draws the opaque and masked meshes into this
+	// system's G-buffer: albedo, the world space normal packed onto an octahedron, and depth, all
+	// single sampled. A compute pass then lights it per 16x16 pixel tile: the tile's depth range and
+	// the frustum through its corners cull the point lights into a list in shared memory first, so
+	// every pixel only loops over the lights of its tile, and overdraw never pays for lighting.
+	// The composite copies the lit color and the depth into the swap chain pass, where the skybox,
+	// blended meshes and light billboards draw forward on top of it.
+	//
+	// The targets follow the frame's extent and are shared by the frames in flight, the barriers
+	// order each frame's writes after the previous one's reads.
+	class DeferredRenderSystem {
+	public:
+		static constexpr VkFormat ALBEDO_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+		static constexpr VkFormat NORMAL_FORMAT = VK_FORMAT_R16G16_SFLOAT;
+		static constexpr VkFormat LIT_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+		DeferredRenderSystem(LveDevice& device, VkRenderPass swapChainRenderPass, VkDescriptorSetLayout globalSetLayout);
+		~DeferredRenderSystem();
+
+		DeferredRenderSystem(const DeferredRenderSystem&) = delete;
+		DeferredRenderSystem& operator=(const DeferredRenderSystem&) = delete;
+
+		// For the pipelines drawing into the G-buffer
+		VkRenderPass getGBufferRenderPass() const { return renderPass; }
+
+		// Begins the G-buffer pass, cleared, or with resume on top of what an earlier G-buffer pass of
+		// the frame stored (occlusion culling's late pass). Recreates the targets on a new extent.
+		void beginGBufferPass(FrameInfo& frameInfo, bool resume = false);
+		void endGBufferPass(FrameInfo& frameInfo);
+		// The G-buffer depth, in the attachment layout between passes
+		LveDepthTarget getDepthTarget() const;
+
+		// Records the lighting dispatch, outside of a render pass and after the last G-buffer pass
+		void light(FrameInfo& frameInfo);
+		// Draws the lit color and the G-buffer depth, first thing in the swap chain pass
+		void composite(FrameInfo& frameInfo);
+
+	private:
+		// An image with its memory and a view of all of it
+		struct Target {
+			VkImage image = VK_NULL_HANDLE;
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+		};
+
+		void createRenderPasses();
+		void createPipelineLayouts(VkDescriptorSetLayout globalSetLayout);
+		void createPipelines(VkRenderPass swapChainRenderPass);
+		void createSampler();
+		Target createTarget(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect);
+		void createTargets(VkExtent2D newExtent);
+		void destroyTargets();
+
+		LveDevice& lveDevice;
+
+		VkFormat depthFormat;
+		VkRenderPass renderPass;
+		VkRenderPass resumeRenderPass;
+		std::unique_ptr<LveDescriptorSetLayout> lightingSetLayout;  // G-buffer and the lit image
+		std::unique_ptr<LveDescriptorSetLayout> compositeSetLayout; // lit image and depth
+		VkPipelineLayout lightingPipelineLayout;
+		VkPipelineLayout compositePipelineLayout;
+		std::unique_ptr<LveComputePipeline> lightingPipeline;
+		std::unique_ptr<LvePipeline> compositePipeline;
+		VkSampler sampler;
+
+		VkExtent2D extent{ 0, 0 };
+		Target albedo;
+		Target normal;
+		Target depth;
+		Target lit;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+	};
+}  // namespace lve
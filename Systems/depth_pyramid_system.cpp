@@ -0,0 +1,276 @@
+#include "depth_pyramid_system.h"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+    struct PyramidPushConstantData {
+        glm::ivec2 srcSize;
+        glm::ivec2 dstSize;
+        int32_t sampleCount;
+    };
+
+    constexpr uint32_t PYRAMID_WORKGROUP_SIZE = 8;
+
+    static bool hasStencilComponent(VkFormat format) {
+        return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+    }
+
+    DepthPyramidSystem::DepthPyramidSystem(LveDevice& device) : lveDevice{ device } {
+        createPipelineLayout();
+        createPipelines();
+        createSampler();
+    }
+
+    DepthPyramidSystem::~DepthPyramidSystem() {
+        destroyPyramid();
+        lveDevice.deletionQueue().retire([device = lveDevice.device(), sampler = sampler]() {
+            vkDestroySampler(device, sampler, nullptr);
+        });
+        vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+    }
+
+    void DepthPyramidSystem::createPipelineLayout() {
+        pyramidSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT) // depth or previous level
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)          // level being written
+            .build();
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(PyramidPushConstantData);
+
+        VkDescriptorSetLayout setLayout = pyramidSetLayout->getDescriptorSetLayout();
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &setLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void DepthPyramidSystem::createPipelines() {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+        initPipeline = std::make_unique<LveComputePipeline>(lveDevice, "Shaders/depth_pyramid_init.comp.spv", pipelineLayout);
+        initMsPipeline = std::make_unique<LveComputePipeline>(lveDevice, "Shaders/depth_pyramid_init_ms.comp.spv", pipelineLayout);
+        downsamplePipeline = std::make_unique<LveComputePipeline>(lveDevice, "Shaders/depth_pyramid.comp.spv", pipelineLayout);
+    }
+
+    void DepthPyramidSystem::createSampler() {
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.minLod = 0.f;
+        samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+        if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create depth pyramid sampler!");
+        }
+    }
+
+    // Full resolution level 0 (no rescaling, so every depth texel lands in exactly one pyramid
+    // texel) down to 1x1
+    void DepthPyramidSystem::createPyramid(VkExtent2D newExtent) {
+        destroyPyramid();
+        extent = newExtent;
+        mipLevels = 1;
+        for (uint32_t size = std::max(extent.width, extent.height); size > 1; size /= 2) {
+            mipLevels++;
+        }
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = extent.width;
+        imageInfo.extent.height = extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = mipLevels;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        lveDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R32_SFLOAT;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = mipLevels;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &fullView) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create depth pyramid view!");
+        }
+
+        mipViews.resize(mipLevels);
+        for (uint32_t level = 0; level < mipLevels; level++) {
+            viewInfo.subresourceRange.baseMipLevel = level;
+            viewInfo.subresourceRange.levelCount = 1;
+            if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &mipViews[level]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create depth pyramid level view!");
+            }
+        }
+    }
+
+    void DepthPyramidSystem::destroyPyramid() {
+        if (image == VK_NULL_HANDLE) return;
+        lveDevice.deletionQueue().retire(
+            [device = lveDevice.device(), image = image, memory = memory, fullView = fullView, mipViews = mipViews]() {
+                for (auto view : mipViews) {
+                    vkDestroyImageView(device, view, nullptr);
+                }
+                vkDestroyImageView(device, fullView, nullptr);
+                vkDestroyImage(device, image, nullptr);
+                vkFreeMemory(device, memory, nullptr);
+            });
+        image = VK_NULL_HANDLE;
+        mipViews.clear();
+    }
+
+    VkDescriptorImageInfo DepthPyramidSystem::descriptorInfo() const {
+        return { sampler, fullView, VK_IMAGE_LAYOUT_GENERAL };
+    }
+
+    void DepthPyramidSystem::build(VkCommandBuffer commandBuffer, LveDescriptorAllocator& frameAllocator, const LveDepthTarget& depth) {
+        if (image == VK_NULL_HANDLE || depth.extent.width != extent.width || depth.extent.height != extent.height) {
+            createPyramid(depth.extent); // the old one is retired once the frames reading it are done
+        }
+
+        VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (hasStencilComponent(depth.format)) {
+            depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT; // both aspects share one layout
+        }
+
+        // --- Depth becomes readable, the pyramid writable (its old contents are not needed) ---
+        std::array<VkImageMemoryBarrier, 2> startBarriers{};
+        startBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        startBarriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        startBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        startBarriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        startBarriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        startBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        startBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        startBarriers[0].image = depth.image;
+        startBarriers[0].subresourceRange = { depthAspect, 0, 1, 0, 1 };
+
+        startBarriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        startBarriers[1].srcAccessMask = 0; // only reads of the previous frame to wait for
+        startBarriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        startBarriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        startBarriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        startBarriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        startBarriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        startBarriers[1].image = image;
+        startBarriers[1].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 };
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr,
+            static_cast<uint32_t>(startBarriers.size()), startBarriers.data());
+
+        // --- Level 0 from the depth, then every level from the one below ---
+        VkDescriptorImageInfo depthInfo{ sampler, depth.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+        glm::ivec2 srcSize{ extent.width, extent.height };
+        for (uint32_t level = 0; level < mipLevels; level++) {
+            glm::ivec2 dstSize = glm::max(glm::ivec2{ extent.width >> level, extent.height >> level }, glm::ivec2{ 1 });
+
+            VkDescriptorImageInfo srcInfo = level == 0
+                ? depthInfo
+                : VkDescriptorImageInfo{ sampler, mipViews[level - 1], VK_IMAGE_LAYOUT_GENERAL };
+            VkDescriptorImageInfo dstInfo{ VK_NULL_HANDLE, mipViews[level], VK_IMAGE_LAYOUT_GENERAL };
+            VkDescriptorSet pyramidSet;
+            if (!LveDescriptorWriter(*pyramidSetLayout, frameAllocator)
+                .writeImage(0, &srcInfo)
+                .writeImage(1, &dstInfo)
+                .build(pyramidSet)) {
+                throw std::runtime_error("failed to allocate depth pyramid descriptor set!");
+            }
+
+            if (level == 0) {
+                (depth.samples == VK_SAMPLE_COUNT_1_BIT ? initPipeline : initMsPipeline)->bind(commandBuffer);
+            }
+            else if (level == 1) {
+                downsamplePipeline->bind(commandBuffer);
+            }
+            vkCmdBindDescriptorSets(
+                commandBuffer,
+                VK_PIPELINE_BIND_POINT_COMPUTE,
+                pipelineLayout,
+                0, 1,
+                &pyramidSet,
+                0, nullptr);
+
+            PyramidPushConstantData push{ srcSize, dstSize, static_cast<int32_t>(depth.samples) };
+            vkCmdPushConstants(
+                commandBuffer,
+                pipelineLayout,
+                VK_SHADER_STAGE_COMPUTE_BIT,
+                0,
+                sizeof(PyramidPushConstantData),
+                &push);
+            vkCmdDispatch(
+                commandBuffer,
+                (dstSize.x + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE,
+                (dstSize.y + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE,
+                1);
+
+            // the next level (or the culling pass after the last one) reads what was just written
+            VkImageMemoryBarrier levelBarrier{};
+            levelBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            levelBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            levelBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            levelBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            levelBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            levelBarrier.image = image;
+            levelBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0, 0, nullptr, 0, nullptr, 1, &levelBarrier);
+
+            srcSize = dstSize;
+        }
+
+        // --- Depth goes back to being an attachment for the resumed render pass ---
+        VkImageMemoryBarrier endBarrier = startBarriers[0];
+        endBarrier.srcAccessMask = 0; // read only, the execution dependency is enough
+        endBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        endBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        endBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &endBarrier);
+    }
+
+}  // namespace lve
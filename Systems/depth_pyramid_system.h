@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../lve_device.h"
+#include "../lve_pipeline.h"
+#include "../lve_descriptors.h"
+#include "../lve_swap_chain.h"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+	// Hierarchical depth (Hi-Z) built from the frame's depth buffer with compute. Level 0 holds the
+	// farthest depth of every pixel (over all MSAA samples), every further level the farthest depth
+	// of the texels it covers below. Anything whose nearest depth is behind the pyramid texels
+	// covering its screen rectangle is hidden.
+	class DepthPyramidSystem {
+	public:
+		DepthPyramidSystem(LveDevice& device);
+		~DepthPyramidSystem();
+
+		DepthPyramidSystem(const DepthPyramidSystem&) = delete;
+		DepthPyramidSystem& operator=(const DepthPyramidSystem&) = delete;
+
+		// Records the build, outside of a render pass and after the depth was written. The depth image
+		// is back in the attachment layout afterwards, the pyramid is left in GENERAL for compute reads.
+		void build(VkCommandBuffer commandBuffer, LveDescriptorAllocator& frameAllocator, const LveDepthTarget& depth);
+
+		// Nearest sampler over the whole mip chain, for texelFetch
+		VkDescriptorImageInfo descriptorInfo() const;
+		VkExtent2D getExtent() const { return extent; }
+		uint32_t getMipLevels() const { return mipLevels; }
+
+	private:
+		void createPipelineLayout();
+		void createPipelines();
+		void createSampler();
+		void createPyramid(VkExtent2D newExtent);
+		void destroyPyramid();
+
+		LveDevice& lveDevice;
+
+		std::unique_ptr<LveDescriptorSetLayout> pyramidSetLayout;
+		VkPipelineLayout pipelineLayout;
+		std::unique_ptr<LveComputePipeline> initPipeline;   // level 0 from single sampled depth
+		std::unique_ptr<LveComputePipeline> initMsPipeline; // level 0 from multisampled depth
+		std::unique_ptr<LveComputePipeline> downsamplePipeline;
+		VkSampler sampler;
+
+		VkExtent2D extent{ 0, 0 };
+		uint32_t mipLevels = 0;
+		VkImage image = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkImageView fullView = VK_NULL_HANDLE;
+		std::vector<VkImageView> mipViews; // one per level, written as storage images
+	};
+}  // namespace lve
@@ -0,0 +1,365 @@
+#include "gpu_cull_system.h"
+#include "../lve_swap_chain.h"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace lve {
+
+    struct CullPushConstantData {
+        uint32_t drawCount;
+        uint32_t compact;
+        uint32_t phase;
+    };
+
+    // std140 layout of CullUbo in cull_frustum.comp, shared by both phases of a frame
+    struct CullUbo {
+        glm::vec4 frustumPlanes[6];
+        glm::mat4 viewProjection;
+        glm::vec2 pyramidSize;
+        float pyramidLevels;
+        float lodScale;
+        glm::vec4 cameraPosition;
+    };
+
+    // StatsBuffer in cull_frustum.comp
+    struct CullStats {
+        uint32_t frustumCulled;
+        uint32_t occluded;
+        uint32_t occludedTriangles;
+        uint32_t lateDraws;
+    };
+
+    // std430 layout of DrawCullData in cull_frustum.comp
+    struct DrawCullData {
+        glm::vec4 boundingSphere;
+        uint32_t lodCount;
+        uint32_t bucket;
+        uint32_t bucketOffset;
+        uint32_t padding;
+        uint32_t lodFirstIndex[4];
+        uint32_t lodIndexCount[4];
+        float lodError[4];
+    };
+    static_assert(LveModel::Mesh::MAX_LODS == 4, "DrawCullData holds 4 levels");
+
+    constexpr uint32_t CULL_WORKGROUP_SIZE = 64;
+
+    // Device local copy of data that is written once, through a staging buffer
+    static std::unique_ptr<LveBuffer> createStaticBuffer(
+        LveDevice& device, const void* data, VkDeviceSize instanceSize, uint32_t instanceCount, VkBufferUsageFlags usage) {
+        LveBuffer stagingBuffer{
+            device,
+            instanceSize,
+            instanceCount,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        };
+        stagingBuffer.map();
+        stagingBuffer.writeToBuffer(const_cast<void*>(data));
+
+        auto buffer = std::make_unique<LveBuffer>(
+            device,
+            instanceSize,
+            instanceCount,
+            usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        device.copyBuffer(stagingBuffer.getBuffer(), buffer->getBuffer(), instanceSize * instanceCount);
+        return buffer;
+    }
+
+    GpuCullSystem::InstanceData GpuCullSystem::InstanceData::pack(const glm::mat4& modelMatrix, float lodFade) {
+        static_assert(sizeof(InstanceData) == 64, "InstanceData is laid out for std430");
+        InstanceData instance;
+        for (int row = 0; row < 3; row++) {
+            instance.modelRows[row] = { modelMatrix[0][row], modelMatrix[1][row], modelMatrix[2][row], modelMatrix[3][row] };
+        }
+        // the columns of the upper 3x3 are the rotated axes times their scale
+        for (int axis = 0; axis < 3; axis++) {
+            glm::vec3 column{ modelMatrix[axis] };
+            instance.normalScale[axis] = 1.f / glm::dot(column, column);
+        }
+        instance.normalScale.w = lodFade;
+        return instance;
+    }
+
+    GpuCullSystem::GpuCullSystem(LveDevice& device)
+        : lveDevice{ device }, useDrawCount{ device.getFeatureSupport().drawIndirectCount } {
+        assert(lveDevice.getFeatureSupport().drawIndirectFirstInstance && "GPU culling needs drawIndirectFirstInstance");
+        createPipelineLayout();
+        createPipeline();
+        indirectBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT * 2);
+        countBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT * 2);
+
+        CullStats noStats{};
+        for (int i = 0; i < LveSwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+            uboBuffers.push_back(std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(CullUbo),
+                1,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+            uboBuffers.back()->map();
+            statsBuffers.push_back(std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(CullStats),
+                1,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+            statsBuffers.back()->map();
+            statsBuffers.back()->writeToBuffer(&noStats);
+        }
+    }
+
+    GpuCullSystem::~GpuCullSystem() {
+        vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+    }
+
+    void GpuCullSystem::createPipelineLayout() {
+        cullSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // instances
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // bounds
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // indirect commands
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // draw counts
+            .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // visibility
+            .addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // stats
+            .addBinding(6, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // frustum and camera
+            .addBinding(7, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT) // depth pyramid, late phase only
+            .build();
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullPushConstantData);
+
+        VkDescriptorSetLayout setLayout = cullSetLayout->getDescriptorSetLayout();
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &setLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void GpuCullSystem::createPipeline() {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+        cullPipeline = std::make_unique<LveComputePipeline>(lveDevice, "Shaders/cull_frustum.comp.spv", pipelineLayout);
+        occlusionPipeline = std::make_unique<LveComputePipeline>(lveDevice, "Shaders/cull_occlusion.comp.spv", pipelineLayout);
+    }
+
+    // Groups every (object, mesh) pair by mesh, so each mesh owns a contiguous range of command
+    // slots, and uploads matrices and bounds in that order
+    void GpuCullSystem::buildScene(LveGameObject::Map& gameObjects) {
+        std::unordered_map<LveModel::Mesh*, uint32_t> bucketIndices;
+        std::vector<std::vector<InstanceData>> bucketInstances;
+        buckets.clear();
+        for (auto& kv : gameObjects) {
+            auto& obj = kv.second;
+            if (obj.model == nullptr) continue;
+
+            InstanceData instance = InstanceData::pack(obj.transform.mat4());
+            for (auto& mesh : obj.model->meshes) {
+                if (!mesh.hasIndexBuffer) continue; // commands are indexed, loaded meshes always are
+
+                auto it = bucketIndices.find(&mesh);
+                if (it == bucketIndices.end()) {
+                    it = bucketIndices.emplace(&mesh, static_cast<uint32_t>(buckets.size())).first;
+                    buckets.push_back({ &mesh, 0, 0 });
+                    bucketInstances.emplace_back();
+                }
+                bucketInstances[it->second].push_back(instance);
+            }
+        }
+
+        std::vector<InstanceData> instances;
+        std::vector<DrawCullData> cullData;
+        for (uint32_t b = 0; b < buckets.size(); b++) {
+            Bucket& bucket = buckets[b];
+            bucket.firstDraw = static_cast<uint32_t>(instances.size());
+            bucket.drawCount = static_cast<uint32_t>(bucketInstances[b].size());
+            DrawCullData draw{ bucket.mesh->boundingSphere, bucket.mesh->getLodCount(), b, bucket.firstDraw, 0 };
+            for (uint32_t level = 0; level < LveModel::Mesh::MAX_LODS; level++) {
+                const auto& lod = bucket.mesh->lods[std::min(level, draw.lodCount - 1)];
+                draw.lodFirstIndex[level] = lod.firstIndex;
+                draw.lodIndexCount[level] = lod.indexCount;
+                draw.lodError[level] = lod.error;
+            }
+            for (auto& instance : bucketInstances[b]) {
+                instances.push_back(instance);
+                cullData.push_back(draw);
+            }
+        }
+
+        drawCount = static_cast<uint32_t>(instances.size());
+        builtObjectCount = gameObjects.size();
+        sceneDirty = false;
+        if (drawCount == 0) return;
+
+        // replaced buffers are retired by their destructors once the frames using them are done
+        instanceBuffer = createStaticBuffer(
+            lveDevice, instances.data(), sizeof(InstanceData), drawCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        cullDataBuffer = createStaticBuffer(
+            lveDevice, cullData.data(), sizeof(DrawCullData), drawCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        visibilityBuffer = std::make_unique<LveBuffer>( // cleared by cull() before its first use
+            lveDevice,
+            sizeof(uint32_t),
+            drawCount,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        for (int i = 0; i < LveSwapChain::MAX_FRAMES_IN_FLIGHT * 2; i++) {
+            indirectBuffers[i] = std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(VkDrawIndexedIndirectCommand),
+                drawCount,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            countBuffers[i] = std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(uint32_t),
+                static_cast<uint32_t>(buckets.size()),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+    }
+
+    void GpuCullSystem::cull(FrameInfo& frameInfo) {
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+
+        // this slot's fence was waited on, so the counters of its previous frame are final
+        auto* stats = static_cast<CullStats*>(statsBuffers[frameInfo.frameIndex]->getMappedMemory());
+        frameInfo.renderStats.culled += stats->frustumCulled;
+        frameInfo.renderStats.occluded += stats->occluded;
+        frameInfo.renderStats.occludedTriangles += stats->occludedTriangles;
+        *stats = {}; // coherent, the shader starts counting from zero again
+
+        bool rebuilt = false;
+        if (sceneDirty || builtObjectCount != frameInfo.gameObjects.size()) {
+            buildScene(frameInfo.gameObjects);
+            rebuilt = true;
+        }
+        if (drawCount == 0) return;
+
+        CullUbo ubo{};
+        std::array<glm::vec4, 6> planes = frameInfo.camera.getFrustumPlanes();
+        for (int i = 0; i < 6; i++) {
+            ubo.frustumPlanes[i] = planes[i];
+        }
+        ubo.viewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+        ubo.lodScale = lodScale;
+        ubo.cameraPosition = frameInfo.camera.getInverseView()[3];
+        uboBuffers[frameInfo.frameIndex]->writeToBuffer(&ubo);
+
+        // --- Reset the per-mesh counters before the shader starts appending ---
+        if (rebuilt) {
+            vkCmdFillBuffer(commandBuffer, visibilityBuffer->getBuffer(), 0, VK_WHOLE_SIZE, 0); // nothing was seen yet
+        }
+        vkCmdFillBuffer(commandBuffer, getCountBuffer(frameInfo.frameIndex).getBuffer(), 0, VK_WHOLE_SIZE, 0);
+        if (occlusionCulling) {
+            vkCmdFillBuffer(commandBuffer, getCountBuffer(frameInfo.frameIndex, true).getBuffer(), 0, VK_WHOLE_SIZE, 0);
+        }
+        VkMemoryBarrier fillBarrier{};
+        fillBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &fillBarrier, 0, nullptr, 0, nullptr);
+
+        dispatch(frameInfo, occlusionCulling ? PHASE_EARLY : PHASE_ALL);
+    }
+
+    void GpuCullSystem::cullLate(FrameInfo& frameInfo, const LveDepthTarget& depth) {
+        assert(occlusionCulling && "The late phase is only recorded with occlusion culling");
+        if (drawCount == 0) return;
+
+        if (!depthPyramid) {
+            depthPyramid = std::make_unique<DepthPyramidSystem>(lveDevice);
+        }
+        depthPyramid->build(frameInfo.commandBuffer, frameInfo.frameDescriptorAllocator, depth);
+
+        // the UBO is only read when the frame executes, so the pyramid size can still be filled in
+        CullUbo* ubo = static_cast<CullUbo*>(uboBuffers[frameInfo.frameIndex]->getMappedMemory());
+        ubo->pyramidSize = { depthPyramid->getExtent().width, depthPyramid->getExtent().height };
+        ubo->pyramidLevels = static_cast<float>(depthPyramid->getMipLevels());
+
+        dispatch(frameInfo, PHASE_LATE);
+    }
+
+    void GpuCullSystem::dispatch(FrameInfo& frameInfo, Phase phase) {
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+        const bool late = phase == PHASE_LATE;
+        LveBuffer& indirectBuffer = getIndirectBuffer(frameInfo.frameIndex, late);
+        LveBuffer& countBuffer = getCountBuffer(frameInfo.frameIndex, late);
+
+        // --- Cull ---
+        auto instanceInfo = instanceBuffer->descriptorInfo();
+        auto cullDataInfo = cullDataBuffer->descriptorInfo();
+        auto indirectInfo = indirectBuffer.descriptorInfo();
+        auto countInfo = countBuffer.descriptorInfo();
+        auto visibilityInfo = visibilityBuffer->descriptorInfo();
+        auto statsInfo = statsBuffers[frameInfo.frameIndex]->descriptorInfo();
+        auto uboInfo = uboBuffers[frameInfo.frameIndex]->descriptorInfo();
+        LveDescriptorWriter writer{ *cullSetLayout, frameInfo.frameDescriptorAllocator };
+        writer.writeBuffer(0, &instanceInfo)
+            .writeBuffer(1, &cullDataInfo)
+            .writeBuffer(2, &indirectInfo)
+            .writeBuffer(3, &countInfo)
+            .writeBuffer(4, &visibilityInfo)
+            .writeBuffer(5, &statsInfo)
+            .writeBuffer(6, &uboInfo);
+        VkDescriptorImageInfo pyramidInfo{};
+        if (late) {
+            pyramidInfo = depthPyramid->descriptorInfo();
+            writer.writeImage(7, &pyramidInfo); // the other phases' shader never reads binding 7
+        }
+        VkDescriptorSet cullSet;
+        if (!writer.build(cullSet)) {
+            throw std::runtime_error("failed to allocate cull descriptor set!");
+        }
+
+        (late ? occlusionPipeline : cullPipeline)->bind(commandBuffer);
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipelineLayout,
+            0, 1,
+            &cullSet,
+            0, nullptr);
+
+        CullPushConstantData push{};
+        push.drawCount = drawCount;
+        push.compact = useDrawCount ? 1 : 0;
+        push.phase = phase;
+        vkCmdPushConstants(
+            commandBuffer,
+            pipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(CullPushConstantData),
+            &push);
+        vkCmdDispatch(commandBuffer, (drawCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+        // --- Commands and counts are consumed by the indirect draws of this frame, the visibility
+        // by the next phase, the stats by the CPU once the frame's fence is signaled ---
+        VkMemoryBarrier cullBarrier{};
+        cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+    }
+
+}  // namespace lve
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "../lve_device.h"
+#include "../lve_game_object.h"
+#include "../lve_pipeline.h"
+#include "../lve_frame_info.h"
+#include "../lve_descriptors.h"
+#include "../lve_buffer.h"
+#include "../lve_model.h"
+#include "../lve_swap_chain.h"
+#include "depth_pyramid_system.h"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+	// Frustum culling on the GPU for static scenes. The objects are uploaded once (matrices,
+	// local bounds, which mesh they draw), then every frame a compute pass tests them against the
+	// camera frustum and writes the survivors as indirect commands, grouped per mesh, plus one
+	// draw count per mesh. The CPU never touches individual objects after the upload.
+	//
+	// With occlusion culling the frame is culled in two phases: the early phase draws what was
+	// visible last frame, a depth pyramid is built from that depth, and the late phase tests
+	// everything against it, drawing only what the early phase missed (so nothing pops in when it
+	// becomes visible) and remembering the result for the next frame.
+	class GpuCullSystem {
+	public:
+		// Same layout as the object buffer of the vertex shaders (set 2), 64 bytes: the model matrix
+		// as the three rows of a 3x4 matrix, its last row being 0 0 0 1, and the inverse squared
+		// scale of each axis. For the rotation and scale matrices of TransformComponent the normal
+		// matrix is then mat3(model) * diag(normalScale.xyz), no inverse needed. normalScale.w is
+		// the LOD cross-fade.
+		struct InstanceData {
+			glm::vec4 modelRows[3];
+			glm::vec4 normalScale;
+
+			static InstanceData pack(const glm::mat4& modelMatrix, float lodFade = 0.f);
+		};
+
+		// One per mesh. Its commands live at [firstDraw, firstDraw + drawCount) of the indirect buffer
+		struct Bucket {
+			LveModel::Mesh* mesh;
+			uint32_t firstDraw;
+			uint32_t drawCount;
+		};
+
+		GpuCullSystem(LveDevice& device);
+		~GpuCullSystem();
+
+		GpuCullSystem(const GpuCullSystem&) = delete;
+		GpuCullSystem& operator=(const GpuCullSystem&) = delete;
+
+		// Objects are treated as static, the scene is rebuilt after invalidateScene() or when the
+		// number of objects changes
+		void invalidateScene() { sceneDirty = true; }
+
+		void setOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
+		// LOD selection in the cull pass (see LveModel::Mesh::selectLod): pixels a unit covers at
+		// distance 1 divided by the allowed error, 0 draws the full meshes. Read by cull().
+		void setLodScale(float scale) { lodScale = scale; }
+		bool usesOcclusionCulling() const { return occlusionCulling; }
+
+		// Records the cull dispatch (the early phase with occlusion culling), must be called outside
+		// of a render pass. Adds the culled counts of this frame slot's previous use to the stats,
+		// the GPU's counters are only readable once its fence was waited on.
+		void cull(FrameInfo& frameInfo);
+		// Occlusion culling only: builds the depth pyramid from what the early phase drew and records
+		// the late phase. Called between the render pass and its resumed continuation.
+		void cullLate(FrameInfo& frameInfo, const LveDepthTarget& depth);
+
+		// With draw counts the commands of a bucket are compacted and the visible count is read from
+		// the count buffer, without them culled commands keep their slot with instanceCount 0
+		bool usesDrawCount() const { return useDrawCount; }
+		const std::vector<Bucket>& getBuckets() const { return buckets; }
+		uint32_t getDrawCount() const { return drawCount; }
+		LveBuffer& getInstanceBuffer() { return *instanceBuffer; }
+		LveBuffer& getIndirectBuffer(int frameIndex, bool late = false) { return *indirectBuffers[bufferIndex(frameIndex, late)]; }
+		LveBuffer& getCountBuffer(int frameIndex, bool late = false) { return *countBuffers[bufferIndex(frameIndex, late)]; }
+
+	private:
+		enum Phase : uint32_t { PHASE_ALL, PHASE_EARLY, PHASE_LATE }; // same values as cull_frustum.comp
+
+		static int bufferIndex(int frameIndex, bool late) { return frameIndex * 2 + (late ? 1 : 0); }
+		void createPipelineLayout();
+		void createPipeline();
+		void buildScene(LveGameObject::Map& gameObjects);
+		void dispatch(FrameInfo& frameInfo, Phase phase);
+
+		LveDevice& lveDevice;
+		bool useDrawCount;
+
+		std::unique_ptr<LveDescriptorSetLayout> cullSetLayout;
+		std::unique_ptr<LveComputePipeline> cullPipeline;
+		std::unique_ptr<LveComputePipeline> occlusionPipeline; // late phase, reads the depth pyramid
+		VkPipelineLayout pipelineLayout;
+
+		bool occlusionCulling = false;
+		float lodScale = 0.f;
+		std::unique_ptr<DepthPyramidSystem> depthPyramid; // created on first use
+		std::vector<std::unique_ptr<LveBuffer>> uboBuffers;   // one per frame in flight, host visible
+		std::vector<std::unique_ptr<LveBuffer>> statsBuffers; // one per frame in flight, host visible
+
+		bool sceneDirty = true;
+		size_t builtObjectCount = 0;
+		uint32_t drawCount = 0;
+		std::vector<Bucket> buckets;
+		std::unique_ptr<LveBuffer> instanceBuffer; // device local, written at upload only
+		std::unique_ptr<LveBuffer> cullDataBuffer;
+		std::unique_ptr<LveBuffer> visibilityBuffer; // device local, written by the late phase
+		std::vector<std::unique_ptr<LveBuffer>> indirectBuffers; // early/all and late phase per frame in flight, see bufferIndex()
+		std::vector<std::unique_ptr<LveBuffer>> countBuffers;
+	};
+}  // namespace lve
\ No newline at end of file
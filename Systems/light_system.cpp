@@ -7,9 +7,9 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
-#include <map>
 #include <stdexcept>
 
 namespace lve {
@@ -68,33 +68,31 @@ namespace lve {
             pipelineConfig);
     }
 
-    void LightSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo) {
-        int lightIndex = 0;
-        for(auto& kv: frameInfo.gameObjects) {
-            auto& obj= kv.second;
-            if (obj.lightComponent == nullptr) continue;
-            
-            //copy light to ubo
-            ubo.lights[lightIndex].position = glm::vec4(obj.transform.translation, 1.0f);
-			ubo.lights[lightIndex].color = glm::vec4(obj.color, obj.lightComponent->lightIntensity);
-
-            lightIndex++;
-		}
-        ubo.numLights = lightIndex;
-    }
-
     void LightSystem::render(FrameInfo& frameInfo) {
-        //sort lights
-		std::map<float, LveGameObject::id_t> sortedLights;
+        //sort lights far to near, in frame memory since the list is rebuilt every frame
+        struct SortedLight {
+            float distanceSquared;
+            LveGameObject* obj;
+        };
+        // lights without a radius have no billboard
+        auto hasBillboard = [](const LveGameObject& obj) { return obj.lightComponent != nullptr && obj.transform.scale.x > 0.f; };
+        uint32_t lightCount = 0;
+        for (auto& kv : frameInfo.gameObjects) {
+            if (hasBillboard(kv.second)) lightCount++;
+        }
+        SortedLight* sortedLights = frameInfo.frameMemory.allocateArray<SortedLight>(lightCount);
 
+        uint32_t lightIndex = 0;
         for (auto& kv : frameInfo.gameObjects) {
             auto& obj = kv.second;
-            if (obj.lightComponent == nullptr) continue;
+            if (!hasBillboard(obj)) continue;
 			auto offset = frameInfo.camera.getPosition() - obj.transform.translation;
-			float distanceSquared = glm::dot(offset, offset);
-			sortedLights[distanceSquared] = obj.getId();
-
+			sortedLights[lightIndex++] = { glm::dot(offset, offset), &obj };
         }
+        std::sort(sortedLights, sortedLights + lightCount, [](const SortedLight& a, const SortedLight& b) {
+            return a.distanceSquared > b.distanceSquared;
+        });
+
         lvePipeline->bind(frameInfo.commandBuffer);
 
         vkCmdBindDescriptorSets(
@@ -105,9 +103,9 @@ namespace lve {
             &frameInfo.globalDescriptorSet,
             0, nullptr);
 
-		// iterate through sorted lights in reverse order (furthest to closest)
-        for (auto it = sortedLights.rbegin(); it != sortedLights.rend(); it++) {
-            auto& obj = frameInfo.gameObjects.at(it->second);
+		// furthest to closest for blending
+        for (uint32_t i = 0; i < lightCount; i++) {
+            auto& obj = *sortedLights[i].obj;
  
             LightPushConstants push{};
 			push.position = glm::vec4(obj.transform.translation, 1.0f);
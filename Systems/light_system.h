@@ -19,7 +19,7 @@ namespace lve {
 		LightSystem(const LightSystem&) = delete;
 		LightSystem& operator=(const LightSystem&) = delete;
 
-		void update(FrameInfo& frameInfo, GlobalUbo& ubo);
+		// Billboards of the lights, the lighting itself comes from LveLightClusters
 		void render(FrameInfo& frameInfo);
 
 	private:
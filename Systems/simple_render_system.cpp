@@ -1,4 +1,5 @@
 #include "simple_render_system.h"
+#include "../lve_swap_chain.h"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -9,23 +10,72 @@
 // std
 #include <array>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <stdexcept>
 
 namespace lve {
 
+    // Per mesh, the matrices are in the object buffer
     struct SimplePushConstantData {
-        alignas(16) glm::mat4 modelMatrix{ 1.f };
-        alignas(16) glm::mat4 normalMatrix{ 1.f };
+        uint32_t textureIndex = 0; // bindless slot (TextureHandle::index)
+        uint32_t padding = 0;
+        VkDeviceAddress vertexAddress = 0; // vertex pulling only
     };
+    static_assert(sizeof(SimplePushConstantData) == 16, "Push constants must match the shaders' layout");
 
-    SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> descriptorSetLayouts)
-        : lveDevice{ device } {
+    // view distance mapped to the full depth range of the sort key
+    constexpr float MAX_SORT_DISTANCE = 100.f;
+
+    // screen space error a LOD may have at bias 0, in pixels, and how long a LOD change fades
+    constexpr float LOD_PIXEL_ERROR = 1.f;
+    constexpr float LOD_FADE_TIME = 0.25f;
+    // frames a cross-fade state outlives its object's last draw, so objects going in and out of
+    // view don't allocate a new one every time
+    constexpr uint32_t LOD_STATE_LIFETIME = 1024;
+    // lodKeys are the object id in the high 32 bits and its mesh index in the low ones; instanced
+    // objects pick one LOD for all their meshes and take this mesh index
+    constexpr uint32_t INSTANCED_LOD_MESH = UINT32_MAX;
+
+    // Pixels a local space unit covers at the nearest point of the bounding sphere, scaled by lodScale
+    static float lodPixelsPerUnit(float lodScale, const glm::mat4& modelMatrix, const glm::vec4& localSphere, const glm::vec3& cameraPosition) {
+        float scale = glm::max(glm::max(glm::length(glm::vec3{ modelMatrix[0] }), glm::length(glm::vec3{ modelMatrix[1] })),
+            glm::length(glm::vec3{ modelMatrix[2] }));
+        glm::vec3 center{ modelMatrix * glm::vec4{ glm::vec3{ localSphere }, 1.f } };
+        float distance = glm::max(glm::length(center - cameraPosition) - localSphere.w * scale, 1e-3f);
+        return lodScale * scale / distance;
+    }
+
+    SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, TextureBinding textureBinding, bool vertexPulling, DrawSubmission drawSubmission, bool lodCrossFade)
+        : lveDevice{ device }, textureBinding{ textureBinding }, vertexPulling{ vertexPulling }, drawSubmission{ drawSubmission }, lodCrossFade{ lodCrossFade } {
+        assert((!vertexPulling || lveDevice.getFeatureSupport().bufferDeviceAddress) && "Vertex pulling needs buffer device address");
+        assert((!vertexPulling || drawSubmission == DrawSubmission::PerObject) && "Vertex pulling only works with per-object draws");
+        assert((drawSubmission < DrawSubmission::Indirect || lveDevice.getFeatureSupport().drawIndirectFirstInstance) &&
+            "Indirect draws need drawIndirectFirstInstance");
+        instanceSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .build();
+        descriptorSetLayouts.push_back(instanceSetLayout->getDescriptorSetLayout());
+        instanceBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        if (drawSubmission == DrawSubmission::Indirect) {
+            indirectBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        }
+        if (drawSubmission == DrawSubmission::GpuCulled) {
+            gpuCulling = std::make_unique<GpuCullSystem>(lveDevice);
+        }
         createPipelineLayout(descriptorSetLayouts);
         createPipeline(renderPass);
     }
 
     SimpleRenderSystem::~SimpleRenderSystem() {
         vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+        if (staticCommandPool != VK_NULL_HANDLE) {
+            // the cached command buffers may still be executing in frames in flight
+            lveDevice.deletionQueue().retire([device = lveDevice.device(), pool = staticCommandPool]() {
+                vkDestroyCommandPool(device, pool, nullptr);
+            });
+        }
     }
 
     void SimpleRenderSystem::createPipelineLayout(std::vector<VkDescriptorSetLayout> descriptorSetLayouts) {
@@ -44,26 +94,379 @@ namespace lve {
             VK_SUCCESS) {
             throw std::runtime_error("failed to create pipeline layout!");
         }
+
+        if (textureBinding == TextureBinding::PushDescriptors) {
+            textureUpdateTemplate = LveDescriptorUpdateTemplate::Builder(lveDevice)
+                .addEntry(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0) // data is a single VkDescriptorImageInfo
+                .setPushDescriptors(pipelineLayout, 1)
+                .build();
+        }
     }
 
     void SimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
+        auto configure = [&](PipelineConfigInfo& pipelineConfig) {
+            LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+            pipelineConfig.renderPass = renderPass;
+            pipelineConfig.pipelineLayout = pipelineLayout;
+            pipelineConfig.multisampleInfo.rasterizationSamples = lveDevice.getMsaaSampleCount();
+            if (vertexPulling) {
+                // any vertex layout works with the same pipeline, the shader decodes it
+                pipelineConfig.bindingDescriptions.clear();
+                pipelineConfig.attributeDescriptions.clear();
+            }
+        };
+        const char* vertexShader = vertexPulling ? "Shaders/simple_shader_pulled.vert.spv" : "Shaders/simple_shader.vert.spv";
+        const char* fragmentShader = textureBinding == TextureBinding::Bindless
+            ? (lodCrossFade ? "Shaders/simple_shader_bindless_dither.frag.spv" : "Shaders/simple_shader_bindless.frag.spv")
+            : (lodCrossFade ? "Shaders/simple_shader_dither.frag.spv" : "Shaders/simple_shader.frag.spv");
+
         PipelineConfigInfo pipelineConfig{};
-        LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
-        pipelineConfig.renderPass = renderPass;
-        pipelineConfig.pipelineLayout = pipelineLayout;
-        pipelineConfig.multisampleInfo.rasterizationSamples = lveDevice.getMsaaSampleCount();
-        lvePipeline = std::make_unique<LvePipeline>(
+        configure(pipelineConfig);
+        lvePipeline = std::make_unique<LvePipeline>(lveDevice, vertexShader, fragmentShader, pipelineConfig);
+
+        // The prepass only needs a fragment shader to dither cross-fading LODs like the shading pass
+        PipelineConfigInfo prepassConfig{};
+        configure(prepassConfig);
+        if (!vertexPulling) {
+            prepassConfig.attributeDescriptions.resize(1); // position, same binding and stride
+        }
+        prepassConfig.colorBlendAttachment.colorWriteMask = 0;
+        depthPrepassPipeline = std::make_unique<LvePipeline>(
             lveDevice,
-            "Shaders/simple_shader.vert.spv",
-            "Shaders/simple_shader.frag.spv",
-            pipelineConfig);
+            vertexPulling ? "Shaders/depth_prepass_pulled.vert.spv" : "Shaders/depth_prepass.vert.spv",
+            lodCrossFade ? "Shaders/depth_prepass.frag.spv" : "",
+            prepassConfig);
+
+        PipelineConfigInfo shadingConfig{};
+        configure(shadingConfig);
+        shadingConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+        shadingConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+        prepassShadingPipeline = std::make_unique<LvePipeline>(lveDevice, vertexShader, fragmentShader, shadingConfig);
+
+        // The buckets that discard, with the usual depth test whether or not the prepass ran.
+        // Cut-outs are mostly single cards (fences, foliage), so both of their faces draw.
+        const std::string fragmentBase = textureBinding == TextureBinding::Bindless ? "Shaders/simple_shader_bindless" : "Shaders/simple_shader";
+        const bool alphaToCoverage = lveDevice.getMsaaSampleCount() != VK_SAMPLE_COUNT_1_BIT;
+        PipelineConfigInfo maskedConfig{};
+        configure(maskedConfig);
+        maskedConfig.rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+        maskedConfig.multisampleInfo.alphaToCoverageEnable = alphaToCoverage ? VK_TRUE : VK_FALSE;
+        alphaTestPipeline = std::make_unique<LvePipeline>(
+            lveDevice, vertexShader, fragmentBase + (alphaToCoverage ? "_alpha_coverage.frag.spv" : "_alpha_test.frag.spv"), maskedConfig);
+
+        PipelineConfigInfo blendedConfig{};
+        configure(blendedConfig);
+        LvePipeline::enableAlphaBlending(blendedConfig);
+        blendedConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+        blendedPipeline = std::make_unique<LvePipeline>(lveDevice, vertexShader, fragmentBase + "_alpha_blend.frag.spv", blendedConfig);
     }
 
-    void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo) {
+    void SimpleRenderSystem::setDeferred(VkRenderPass gbufferRenderPass) {
+        gbufferPipeline.reset();
+        gbufferMaskedPipeline.reset();
+        if (gbufferRenderPass == VK_NULL_HANDLE) return;
+
+        // Two color attachments (albedo, normal) and a single sampled depth, nothing blends
+        std::array<VkPipelineColorBlendAttachmentState, 2> attachments{};
+        auto configure = [&](PipelineConfigInfo& pipelineConfig) {
+            LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+            pipelineConfig.renderPass = gbufferRenderPass;
+            pipelineConfig.pipelineLayout = pipelineLayout;
+            if (vertexPulling) {
+                pipelineConfig.bindingDescriptions.clear();
+                pipelineConfig.attributeDescriptions.clear();
+            }
+            attachments.fill(pipelineConfig.colorBlendAttachment);
+            pipelineConfig.colorBlendInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+            pipelineConfig.colorBlendInfo.pAttachments = attachments.data();
+        };
+        const char* vertexShader = vertexPulling ? "Shaders/simple_shader_pulled.vert.spv" : "Shaders/simple_shader.vert.spv";
+        const std::string fragmentBase = textureBinding == TextureBinding::Bindless ? "Shaders/gbuffer_bindless" : "Shaders/gbuffer";
+
+        PipelineConfigInfo opaqueConfig{};
+        configure(opaqueConfig);
+        gbufferPipeline = std::make_unique<LvePipeline>(
+            lveDevice, vertexShader, fragmentBase + (lodCrossFade ? "_dither.frag.spv" : ".frag.spv"), opaqueConfig);
+
+        PipelineConfigInfo maskedConfig{};
+        configure(maskedConfig);
+        maskedConfig.rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+        gbufferMaskedPipeline = std::make_unique<LvePipeline>(lveDevice, vertexShader, fragmentBase + "_alpha_test.frag.spv", maskedConfig);
+    }
+
+    void SimpleRenderSystem::cullGameObjects(FrameInfo& frameInfo) {
+        if (usesStaticCommandBuffers()) return; // the cached commands draw everything
+        if (gpuCulling) {
+            gpuCulling->setLodScale(computeLodScale(frameInfo));
+            gpuCulling->cull(frameInfo);
+        }
+        else if (occlusionCulling && frustumCulling) {
+            rasterizeOccluders(frameInfo);
+        }
+    }
+
+    void SimpleRenderSystem::rasterizeOccluders(FrameInfo& frameInfo) {
+        if (!occlusionBuffer) {
+            occlusionBuffer = std::make_unique<LveOcclusionBuffer>();
+        }
+        occlusionBuffer->begin(frameInfo.camera.getProjection() * frameInfo.camera.getView());
+        for (auto& kv : frameInfo.gameObjects) {
+            auto& obj = kv.second;
+            if (obj.occluder) {
+                occlusionBuffer->addOccluder(*obj.occluder, obj.model ? frameInfo.transforms.getMatrix(obj.transformSlot) : obj.transform.mat4());
+            }
+        }
+        occlusionBuffer->rasterize();
+    }
+
+    float SimpleRenderSystem::computeLodScale(const FrameInfo& frameInfo) const {
+        if (!lodSelection) return 0.f;
+        return frameInfo.camera.getPixelScale(static_cast<float>(frameInfo.extent.height)) / (LOD_PIXEL_ERROR * std::exp2(lodBias));
+    }
+
+    SimpleRenderSystem::LodState SimpleRenderSystem::updateLod(uint64_t lodKey, uint32_t lod, float frameTime) {
+        if (!lodCrossFade) {
+            return { lod, lod, 1.f, lodFrame };
+        }
+
+        LodState& state = lodStates.emplace(lodKey, LodState{ lod, lod, 1.f, lodFrame }).first->second;
+        if (state.lastFrame + 1 < lodFrame) {
+            state = { lod, lod, 1.f, lodFrame }; // wasn't drawn last frame, comes back without a fade
+        }
+        if (state.lod != lod) {
+            state.previousLod = state.lod; // a fade still running is cut short
+            state.lod = lod;
+            state.progress = 0.f;
+        }
+        if (state.previousLod != state.lod) {
+            state.progress += frameTime / LOD_FADE_TIME; // above 0 from the first frame, so both levels draw something
+            if (state.progress >= 1.f) {
+                state.previousLod = state.lod;
+                state.progress = 1.f;
+            }
+        }
+        state.lastFrame = lodFrame;
+        return state;
+    }
+
+    // Queues the packet at its LOD, twice with complementary dither patterns while a cross-fade runs
+    void SimpleRenderSystem::submitDraw(FrameInfo& frameInfo, uint64_t key, uint64_t lodKey, DrawPacket packet) {
+        if (lodScale > 0.f) {
+            float pixelsPerUnit = lodPixelsPerUnit(lodScale, packet.modelMatrix, packet.mesh->boundingSphere, lodCameraPosition);
+            uint32_t lod = packet.mesh->selectLod(pixelsPerUnit);
+            if (packet.mesh->fragmentBuffer.alphaMode != AlphaMode::Opaque) {
+                // their shaders don't dither, two overlapping levels would show through each other
+                packet.lod = lod;
+                renderQueue.submit(key, packet);
+                return;
+            }
+            LodState state = updateLod(lodKey, lod, frameInfo.frameTime);
+            packet.lod = state.lod;
+            if (state.previousLod != state.lod) {
+                DrawPacket outgoing = packet;
+                outgoing.lod = state.previousLod;
+                outgoing.lodFade = state.progress;
+                renderQueue.submit(key, outgoing);
+                packet.lodFade = -state.progress;
+            }
+        }
+        renderQueue.submit(key, packet);
+    }
+
+    // Frustum test of cullBounds into cullVisibility, then the occlusion test of the survivors.
+    // Only the rejected ones are counted, in the stats.
+    void SimpleRenderSystem::cullBoundsVisibility(FrameInfo& frameInfo, size_t count) {
+        uint32_t visibleCount = cullBoxes(frameInfo.camera.getFrustumPlanes(), cullBounds, cullVisibility);
+        frameInfo.renderStats.culled += static_cast<uint32_t>(count) - visibleCount;
+        if (occlusionCulling && occlusionBuffer) {
+            frameInfo.renderStats.occluded += occlusionBuffer->testBoxes(cullBounds, cullVisibility);
+        }
+    }
+
+    void SimpleRenderSystem::invalidateStaticScene() {
+        if (gpuCulling) {
+            gpuCulling->invalidateScene();
+        }
+        for (auto& commands : staticCommands) {
+            commands.valid = false; // re-recorded when their frame index comes around
+        }
+        // groups of models that may be gone, with their instance capacity
+        instanceGroups.clear();
+        groupIndices.clear();
+    }
+
+    void SimpleRenderSystem::setDepthPrepass(bool enabled) {
+        depthPrepass = enabled;
+        for (auto& commands : staticCommands) {
+            commands.valid = false; // recorded with or without it
+        }
+    }
+
+    void SimpleRenderSystem::setStaticCommandBuffers(bool enabled) {
+        staticCommandBuffers = enabled;
+        for (auto& commands : staticCommands) {
+            commands.valid = false; // the scene may have changed while they were off
+        }
+    }
 
-        lvePipeline->bind(frameInfo.commandBuffer);
+    VkCommandBuffer SimpleRenderSystem::getStaticCommandBuffer(FrameInfo& frameInfo, VkRenderPass renderPass, uint32_t renderPassGeneration) {
+        assert(usesStaticCommandBuffers() && "Static command buffers are off");
+        StaticCommands& commands = staticCommands[frameInfo.frameIndex];
+        if (!commands.valid || commands.renderPassGeneration != renderPassGeneration ||
+            commands.extent.width != frameInfo.extent.width || commands.extent.height != frameInfo.extent.height) {
+            recordStaticCommands(frameInfo, renderPass, commands);
+            commands.renderPassGeneration = renderPassGeneration;
+        }
+        frameInfo.renderStats.accumulate(commands.stats);
+        return commands.commandBuffer;
+    }
+
+    // The buffer of a frame index is only re-recorded once that frame's fence was waited on, so
+    // it is never pending, and each one is only in one frame at a time (no simultaneous use)
+    void SimpleRenderSystem::recordStaticCommands(FrameInfo& frameInfo, VkRenderPass renderPass, StaticCommands& commands) {
+        if (staticCommandPool == VK_NULL_HANDLE) {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // buffers are re-recorded one at a time
+            if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &staticCommandPool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create static command pool!");
+            }
+        }
+        if (commands.commandBuffer == VK_NULL_HANDLE) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = staticCommandPool;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commands.commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate static command buffer!");
+            }
+        }
+
+        // no framebuffer, so it stays valid for every swap chain image
+        beginSecondaryCommandBuffer(commands.commandBuffer, renderPass, VK_NULL_HANDLE, frameInfo.extent, 0);
+        commands.stats = {};
+        FrameInfo staticInfo = frameInfo.withCommandBuffer(commands.commandBuffer, commands.stats);
+
+        // nothing that depends on the camera: no culling, no LODs, and the blended meshes, which
+        // are sorted by distance, are left to renderBlendedGameObjects
+        const bool culling = frustumCulling;
+        frustumCulling = false;
+        lodScale = 0.f;
+        queueVisibleGameObjects(staticInfo, QueuedBuckets::DepthWriting);
+        frustumCulling = culling;
+
+        // the matrices are replayed with the commands, so they get a buffer and set of their own
+        // that the frame's descriptor pools don't reset
+        if (!renderQueue.empty()) {
+            if (!staticDescriptorPool) {
+                staticDescriptorPool = LveDescriptorPool::Builder(lveDevice)
+                    .setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+                    .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+                    .build();
+                staticObjectBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+            }
+            uint32_t drawCount = static_cast<uint32_t>(renderQueue.size());
+            LveBuffer& objectBuffer = getFrameBuffer(
+                staticObjectBuffers, frameInfo.frameIndex, sizeof(InstanceData), drawCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+            auto* objects = static_cast<InstanceData*>(objectBuffer.getMappedMemory());
+            for (uint32_t i = 0; i < drawCount; i++) {
+                objects[i] = InstanceData::pack(renderQueue[i].modelMatrix, renderQueue[i].lodFade);
+            }
+
+            auto bufferInfo = objectBuffer.descriptorInfo(sizeof(InstanceData) * drawCount);
+            LveDescriptorWriter writer{ *instanceSetLayout, *staticDescriptorPool };
+            writer.writeBuffer(0, &bufferInfo);
+            if (commands.objectSet == VK_NULL_HANDLE) {
+                if (!writer.build(commands.objectSet)) {
+                    throw std::runtime_error("failed to allocate static object descriptor set!");
+                }
+            }
+            else {
+                writer.overwrite(commands.objectSet); // its last frame is done, see above
+            }
+            queuedObjectSet = commands.objectSet;
+        }
+        recordPasses(staticInfo, [&](bool depthOnly) {
+            recordQueuedDraws(staticInfo, 0, static_cast<uint32_t>(renderQueue.size()), depthOnly);
+        });
+
+        if (vkEndCommandBuffer(commands.commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record static command buffer!");
+        }
+        commands.valid = true;
+        commands.extent = frameInfo.extent;
+    }
+
+    void SimpleRenderSystem::setOcclusionCulling(bool enabled) {
+        occlusionCulling = enabled;
+        if (gpuCulling) {
+            gpuCulling->setOcclusionCulling(enabled);
+        }
+    }
+
+    void SimpleRenderSystem::cullLateGameObjects(FrameInfo& frameInfo, const LveDepthTarget& depth) {
+        assert(hasLatePass() && "No late pass without occlusion culling");
+        gpuCulling->cullLate(frameInfo, depth);
+    }
+
+    void SimpleRenderSystem::renderLateGameObjects(FrameInfo& frameInfo) {
+        assert(hasLatePass() && "No late pass without occlusion culling");
+        output = usesDeferred() ? Output::GBuffer : Output::Forward;
+        // a new render pass, nothing is bound anymore
+        recordPasses(frameInfo, [&](bool depthOnly) { renderGpuCulled(frameInfo, true, depthOnly); });
+    }
+
+    // Goes over what renderGameObjects (and renderLateGameObjects) prepared this frame again, the
+    // queue, the instance groups or the cull results, drawing only the blended bucket. With static
+    // command buffers nothing was prepared, the blended meshes are queued here.
+    void SimpleRenderSystem::renderBlendedGameObjects(FrameInfo& frameInfo) {
+        assert((usesDeferred() || usesStaticCommandBuffers()) && "Blended meshes only draw apart from the others when deferred or cached");
+        if (usesStaticCommandBuffers()) {
+            // at full detail like the cached draws, and without occlusion culling, whose occluders
+            // cullGameObjects doesn't rasterize in this mode
+            const bool occlusion = occlusionCulling;
+            occlusionCulling = false;
+            lodScale = 0.f;
+            queueVisibleGameObjects(frameInfo, QueuedBuckets::Blended);
+            occlusionCulling = occlusion;
+            writeQueuedObjects(frameInfo);
+        }
+        output = Output::Blended;
+        bindPipeline(frameInfo);
+        switch (drawSubmission) {
+        case DrawSubmission::Instanced:
+            if (instancedObjectSet != VK_NULL_HANDLE) {
+                bindInstanceSet(frameInfo, instancedObjectSet);
+                recordInstanced(frameInfo, false);
+            }
+            break;
+        case DrawSubmission::GpuCulled:
+            renderGpuCulled(frameInfo, false, false);
+            if (hasLatePass()) {
+                renderGpuCulled(frameInfo, true, false);
+            }
+            break;
+        default:
+            recordQueuedDraws(frameInfo, 0, static_cast<uint32_t>(renderQueue.size()), false);
+            break;
+        }
+        output = Output::Forward;
+    }
+
+    // Pipeline of the opaque bucket and the sets shared by every draw (global UBO, bindless table).
+    // Blended output has no opaque bucket, its pipeline is bound by the first draw.
+    void SimpleRenderSystem::bindPipeline(FrameInfo& frameInfo, bool depthOnly) {
+        if (output != Output::Blended) {
+            LvePipeline& pipeline = depthOnly ? *depthPrepassPipeline
+                : output == Output::GBuffer ? *gbufferPipeline
+                : depthPrepass ? *prepassShadingPipeline : *lvePipeline;
+            pipeline.bind(frameInfo.commandBuffer);
+            frameInfo.renderStats.pipelineBinds++;
+        }
         
         // Bind global UBO descriptor set (set = 0)
         vkCmdBindDescriptorSets(
@@ -73,23 +476,402 @@ namespace lve {
             0, 1, 
             &frameInfo.globalDescriptorSet,
             0, nullptr);
+        frameInfo.renderStats.descriptorBinds++;
+
+        // Bindless texture table (set = 1), meshes only select their slot through push constants
+        if (textureBinding == TextureBinding::Bindless && !depthOnly) {
+            assert(frameInfo.bindlessTextureSet != VK_NULL_HANDLE && "Bindless mode without a texture table!");
+            vkCmdBindDescriptorSets(
+                frameInfo.commandBuffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                pipelineLayout,
+                1, 1,
+                &frameInfo.bindlessTextureSet,
+                0, nullptr);
+            frameInfo.renderStats.descriptorBinds++;
+        }
+    }
+
+    bool SimpleRenderSystem::bindBucket(FrameInfo& frameInfo, AlphaMode alphaMode, AlphaMode& bound) {
+        // the G-buffer takes what writes depth, the blended bucket goes on top of the lit result
+        if (output != Output::Forward && (alphaMode == AlphaMode::Blended) != (output == Output::Blended)) return false;
+        if (alphaMode == bound) return true;
+        LvePipeline& pipeline = output == Output::GBuffer
+            ? (alphaMode == AlphaMode::Masked ? *gbufferMaskedPipeline : *gbufferPipeline)
+            : alphaMode == AlphaMode::Masked ? *alphaTestPipeline
+            : alphaMode == AlphaMode::Blended ? *blendedPipeline
+            : depthPrepass ? *prepassShadingPipeline : *lvePipeline;
+        pipeline.bind(frameInfo.commandBuffer);
+        frameInfo.renderStats.pipelineBinds++;
+        bound = alphaMode;
+        return true;
+    }
+
+    void SimpleRenderSystem::beginLodFrame(const FrameInfo& frameInfo) {
+        lodScale = computeLodScale(frameInfo);
+        lodCameraPosition = frameInfo.camera.getInverseView()[3];
+        lodFrame++;
+        if (lodFrame % LOD_STATE_LIFETIME == 0) {
+            for (auto it = lodStates.begin(); it != lodStates.end();) {
+                it = it->second.lastFrame + LOD_STATE_LIFETIME < lodFrame ? lodStates.erase(it) : std::next(it);
+            }
+        }
+    }
+
+    void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo) {
+        beginLodFrame(frameInfo);
+        output = usesDeferred() ? Output::GBuffer : Output::Forward;
+
+        if (drawSubmission == DrawSubmission::Instanced) {
+            renderInstanced(frameInfo);
+            return;
+        }
+        if (drawSubmission == DrawSubmission::GpuCulled) {
+            // no per-object work on the CPU at all
+            recordPasses(frameInfo, [&](bool depthOnly) { renderGpuCulled(frameInfo, false, depthOnly); });
+            return;
+        }
+        queueVisibleGameObjects(frameInfo);
+        writeQueuedObjects(frameInfo);
+        if (drawSubmission == DrawSubmission::Indirect) {
+            renderIndirect(frameInfo);
+            return;
+        }
+        recordPasses(frameInfo, [&](bool depthOnly) {
+            recordQueuedDraws(frameInfo, 0, static_cast<uint32_t>(renderQueue.size()), depthOnly);
+        });
+    }
+
+    uint32_t SimpleRenderSystem::queueGameObjects(FrameInfo& frameInfo) {
+        assert(supportsParallelRecording() && "Only PerObject draws are recorded in ranges");
+        beginLodFrame(frameInfo);
+        queueVisibleGameObjects(frameInfo);
+        writeQueuedObjects(frameInfo); // the descriptor allocator is single threaded, so the set is made here
+        return static_cast<uint32_t>(renderQueue.size());
+    }
+
+    void SimpleRenderSystem::recordGameObjects(FrameInfo& frameInfo, uint32_t first, uint32_t count, bool depthOnly) {
+        assert(first + count <= renderQueue.size() && "Draw range out of the queue");
+        assert((!depthOnly || depthPrepass) && "Depth-only ranges need the depth prepass on");
+        bindPipeline(frameInfo, depthOnly); // every command buffer starts with nothing bound
+        RenderStats& stats = frameInfo.renderStats;
+        const uint32_t drawCalls = stats.drawCalls;
+        const uint32_t instances = stats.instances;
+        recordQueuedDraws(frameInfo, first, count, depthOnly);
+        if (depthOnly) {
+            stats.prepassDrawCalls += stats.drawCalls - drawCalls; // the shading range counts them
+            stats.drawCalls = drawCalls;
+            stats.instances = instances;
+        }
+    }
+
+    // --- Record in key order, skipping binds of state that is already bound ---
+    // Draw i reads entry i of the object buffer through firstInstance, push constants only change
+    // with the texture slot or the vertex buffer. Depth-only draws leave textures alone and skip
+    // the buckets that aren't opaque.
+    void SimpleRenderSystem::recordQueuedDraws(FrameInfo& frameInfo, uint32_t first, uint32_t count, bool depthOnly) {
+        if (count == 0) return;
+        bindInstanceSet(frameInfo, queuedObjectSet);
+
+        LveModel::Mesh* boundMesh = nullptr;
+        TextureHandle boundTexture{};
+        SimplePushConstantData pushed{};
+        AlphaMode boundBucket = AlphaMode::Opaque; // see bindPipeline
+        bool pushedAny = false;
+        for (uint32_t i = first; i < first + count; i++) {
+            const DrawPacket& packet = renderQueue[i];
+            LveModel::Mesh& mesh = *packet.mesh;
+            TextureHandle texture = mesh.fragmentBuffer.diffuseTexture;
+
+            // the queue is sorted by bucket, so this switches pipelines at most twice
+            if (depthOnly) {
+                if (mesh.fragmentBuffer.alphaMode != AlphaMode::Opaque) continue;
+            }
+            else if (!bindBucket(frameInfo, mesh.fragmentBuffer.alphaMode, boundBucket)) {
+                continue;
+            }
+
+            // --- Push constants ---
+            SimplePushConstantData push{};
+            push.textureIndex = depthOnly ? 0 : texture.index;
+            push.vertexAddress = vertexPulling ? mesh.getVertexAddress() : 0;
+            if (!pushedAny || push.textureIndex != pushed.textureIndex || push.vertexAddress != pushed.vertexAddress) {
+                vkCmdPushConstants(
+                    frameInfo.commandBuffer,
+                    pipelineLayout,
+                    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                    0,
+                    sizeof(SimplePushConstantData),
+                    &push);
+                pushed = push;
+                pushedAny = true;
+            }
+
+            if (textureBinding != TextureBinding::Bindless && !depthOnly) {
+                if (texture != boundTexture) {
+                    if (!bindMeshTexture(frameInfo, texture)) continue;
+                    boundTexture = texture;
+                }
+                else {
+                    frameInfo.renderStats.redundantBindsSkipped++;
+                }
+            }
 
-        // Loop over all objects
+            // --- Bind and draw model ---
+            if (&mesh != boundMesh) {
+                if (vertexPulling) {
+                    mesh.bindIndexBuffer(frameInfo.commandBuffer);
+                }
+                else {
+                    mesh.bind(frameInfo.commandBuffer);
+                }
+                boundMesh = &mesh;
+                frameInfo.renderStats.vertexBufferBinds++;
+            }
+            else {
+                frameInfo.renderStats.redundantBindsSkipped++;
+            }
+            mesh.draw(frameInfo.commandBuffer, 1, i, packet.lod);
+            frameInfo.renderStats.drawCalls++;
+            frameInfo.renderStats.instances++;
+        }
+    }
+
+    // Queue every visible mesh of every object with its sort key, so equal meshes end up next to each other
+    void SimpleRenderSystem::queueVisibleGameObjects(FrameInfo& frameInfo, QueuedBuckets buckets) {
+        // Bindless draws don't change descriptors between textures, so only the mesh matters there
+        const glm::vec3 cameraPosition{ frameInfo.camera.getInverseView()[3] };
+        renderQueue.clear();
+        cullCandidates.clear();
+        cullBounds.clear();
         for (auto& kv : frameInfo.gameObjects) {
 			auto& obj = kv.second;
 
 			if (obj.model == nullptr) continue;
 
-            // Loop over all meshes in the model
-            for (auto& kv : obj.model->meshes) {
-                uint32_t id = kv.first;
-                auto& mesh = kv.second;
+            const glm::mat4& modelMatrix = frameInfo.transforms.getMatrix(obj.transformSlot);
+            float depth01 = glm::length(obj.transform.translation - cameraPosition) / MAX_SORT_DISTANCE;
 
-                // --- Push constants ---
-                SimplePushConstantData push{};
-                push.modelMatrix = obj.transform.mat4();
-                push.normalMatrix = obj.transform.normalMatrix();
+            for (uint32_t m = 0; m < obj.model->meshes.size(); m++) {
+                auto& mesh = obj.model->meshes[m];
+                if (buckets != QueuedBuckets::All && (mesh.fragmentBuffer.alphaMode == AlphaMode::Blended) != (buckets == QueuedBuckets::Blended)) continue;
+                uint32_t material = textureBinding == TextureBinding::Bindless ? 0 : mesh.fragmentBuffer.diffuseTexture.index;
+                const uint32_t meshId = mesh.getId();
+                assert(meshId < (1u << SortKey::MESH_BITS) && "Mesh id doesn't fit the sort key's mesh field");
+                uint64_t key;
+                switch (mesh.fragmentBuffer.alphaMode) {
+                case AlphaMode::Opaque:
+                    key = SortKey::make(SortKey::OPAQUE_PASS, 0, material, meshId, depth01);
+                    break;
+                case AlphaMode::Masked:
+                    key = SortKey::make(SortKey::ALPHA_TEST_PASS, 0, material, meshId, depth01);
+                    break;
+                default: {
+                    // sorted by the mesh's own center, merged static chunks all sit at the origin
+                    glm::vec3 center{ modelMatrix * glm::vec4{ glm::vec3{ mesh.boundingSphere }, 1.f } };
+                    float meshDepth01 = glm::length(center - cameraPosition) / MAX_SORT_DISTANCE;
+                    key = SortKey::make(SortKey::TRANSPARENT_PASS, 0, material, meshId, meshDepth01, true);
+                    break;
+                }
+                }
+                uint64_t lodKey = (static_cast<uint64_t>(obj.getId()) << 32) | m;
+                if (!frustumCulling) {
+                    submitDraw(frameInfo, key, lodKey, { &mesh, modelMatrix });
+                    continue;
+                }
+
+                glm::vec3 center, extent;
+                transformBounds(modelMatrix, mesh.boundsMin, mesh.boundsMax, center, extent);
+                cullBounds.push(center, extent);
+                cullCandidates.push_back({ key, lodKey, { &mesh, modelMatrix } });
+            }
+        }
 
+        if (frustumCulling) {
+            // all meshes are tested in SIMD batches, only the survivors reach the queue
+            cullBoundsVisibility(frameInfo, cullCandidates.size());
+            for (size_t i = 0; i < cullCandidates.size(); i++) {
+                if (cullVisibility[i]) {
+                    submitDraw(frameInfo, cullCandidates[i].key, cullCandidates[i].lodKey, cullCandidates[i].packet);
+                }
+            }
+        }
+        renderQueue.sort();
+    }
+
+    // Objects sharing a model become one instanced draw per mesh, their transforms go to this
+    // frame's instance buffer (set = 2) and the shader picks them with gl_InstanceIndex
+    void SimpleRenderSystem::renderInstanced(FrameInfo& frameInfo) {
+        instancedObjectSet = VK_NULL_HANDLE;
+        // whole objects are culled here, against the union of their mesh bounds
+        cullObjects.clear();
+        cullBounds.clear();
+        for (auto& kv : frameInfo.gameObjects) {
+            auto& obj = kv.second;
+            if (obj.model == nullptr) continue;
+
+            cullObjects.emplace_back(&obj, frameInfo.transforms.getMatrix(obj.transformSlot));
+            if (frustumCulling) {
+                glm::vec3 center, extent;
+                transformBounds(cullObjects.back().second, obj.model->boundsMin, obj.model->boundsMax, center, extent);
+                cullBounds.push(center, extent);
+            }
+        }
+        if (frustumCulling) {
+            cullBoundsVisibility(frameInfo, cullObjects.size());
+        }
+
+        // one group per model and LOD, the LOD is picked for the whole object. Groups keep their
+        // slot and instance capacity across frames, so a steady scene doesn't touch the heap.
+        activeGroups.clear();
+        uint32_t instanceCount = 0;
+        auto addInstance = [&](LveModel* model, uint32_t lod, const InstanceData& instance) {
+            uint64_t groupKey = (static_cast<uint64_t>(model->getId()) << 8) | lod;
+            auto it = groupIndices.find(groupKey);
+            if (it == groupIndices.end()) {
+                it = groupIndices.emplace(groupKey, static_cast<uint32_t>(instanceGroups.size())).first;
+                instanceGroups.emplace_back();
+            }
+            InstanceGroup& group = instanceGroups[it->second];
+            if (group.lastFrame != lodFrame) {
+                group.model = model;
+                group.lod = lod;
+                group.instances.clear();
+                group.lastFrame = lodFrame;
+                activeGroups.push_back(it->second);
+            }
+            group.instances.push_back(instance);
+            instanceCount++;
+        };
+        for (size_t i = 0; i < cullObjects.size(); i++) {
+            if (frustumCulling && !cullVisibility[i]) continue;
+            auto& obj = *cullObjects[i].first;
+            InstanceData instance = InstanceData::pack(cullObjects[i].second);
+            if (lodScale <= 0.f) {
+                addInstance(obj.model.get(), 0, instance);
+                continue;
+            }
+
+            glm::vec3 localCenter = (obj.model->boundsMin + obj.model->boundsMax) * 0.5f;
+            float localRadius = glm::length(obj.model->boundsMax - obj.model->boundsMin) * 0.5f;
+            float pixelsPerUnit = lodPixelsPerUnit(lodScale, cullObjects[i].second, glm::vec4{ localCenter, localRadius }, lodCameraPosition);
+            LodState state = updateLod((static_cast<uint64_t>(obj.getId()) << 32) | INSTANCED_LOD_MESH, obj.model->selectLod(pixelsPerUnit), frameInfo.frameTime);
+            if (state.previousLod != state.lod) {
+                InstanceData outgoing = instance;
+                outgoing.normalScale.w = state.progress;
+                addInstance(obj.model.get(), state.previousLod, outgoing);
+                instance.normalScale.w = -state.progress;
+            }
+            addInstance(obj.model.get(), state.lod, instance);
+        }
+        if (instanceCount == 0) return;
+
+        LveBuffer& instanceBuffer = getFrameBuffer(
+            instanceBuffers, frameInfo.frameIndex, sizeof(InstanceData), instanceCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+        VkDeviceSize offset = 0;
+        for (uint32_t g : activeGroups) {
+            auto& instances = instanceGroups[g].instances;
+            VkDeviceSize size = sizeof(InstanceData) * instances.size();
+            instanceBuffer.writeToBuffer(instances.data(), size, offset);
+            offset += size;
+        }
+        instancedObjectSet = writeInstanceSet(frameInfo, instanceBuffer, offset);
+        bindInstanceSet(frameInfo, instancedObjectSet);
+
+        recordPasses(frameInfo, [&](bool depthOnly) { recordInstanced(frameInfo, depthOnly); });
+    }
+
+    // The draws of this frame's instance groups, with their instance set bound
+    void SimpleRenderSystem::recordInstanced(FrameInfo& frameInfo, bool depthOnly) {
+        // one walk over the groups per bucket, the prepass only needs the opaque one
+        AlphaMode boundBucket = AlphaMode::Opaque;
+        for (AlphaMode bucket : { AlphaMode::Opaque, AlphaMode::Masked, AlphaMode::Blended }) {
+            if (depthOnly && bucket != AlphaMode::Opaque) break;
+            uint32_t firstInstance = 0;
+            for (uint32_t g : activeGroups) {
+                auto& group = instanceGroups[g];
+                uint32_t count = static_cast<uint32_t>(group.instances.size());
+
+                for (auto& mesh : group.model->meshes) {
+                    if (mesh.fragmentBuffer.alphaMode != bucket) continue;
+                    TextureHandle texture = mesh.fragmentBuffer.diffuseTexture;
+                    if (!bindBucket(frameInfo, bucket, boundBucket)) continue;
+
+                    // matrices come from the instance buffer, only the texture slot is per mesh
+                    SimplePushConstantData push{};
+                    push.textureIndex = texture.index;
+                    vkCmdPushConstants(
+                        frameInfo.commandBuffer,
+                        pipelineLayout,
+                        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                        0,
+                        sizeof(SimplePushConstantData),
+                        &push);
+
+                    if (!depthOnly && !bindMeshTexture(frameInfo, texture)) continue;
+
+                    mesh.bind(frameInfo.commandBuffer);
+                    frameInfo.renderStats.vertexBufferBinds++;
+                    mesh.draw(frameInfo.commandBuffer, count, firstInstance, group.lod);
+                    frameInfo.renderStats.drawCalls++;
+                    frameInfo.renderStats.instances += count;
+                }
+                firstInstance += count;
+            }
+        }
+    }
+
+    // Every queued draw becomes a VkDrawIndexedIndirectCommand whose firstInstance points at its
+    // matrices in the instance buffer. Draws of the same mesh are contiguous after sorting and go
+    // out in a single indirect call, so recording cost follows the number of distinct meshes
+    // rather than the number of objects.
+    void SimpleRenderSystem::renderIndirect(FrameInfo& frameInfo) {
+        uint32_t drawCount = static_cast<uint32_t>(renderQueue.size());
+        if (drawCount == 0) return;
+
+        LveBuffer& indirectBuffer = getFrameBuffer(
+            indirectBuffers, frameInfo.frameIndex, sizeof(VkDrawIndexedIndirectCommand), drawCount, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+        auto* commands = static_cast<VkDrawIndexedIndirectCommand*>(indirectBuffer.getMappedMemory());
+
+        // the matrices are already in the object buffer, in queue order
+        for (uint32_t i = 0; i < drawCount; i++) {
+            const DrawPacket& packet = renderQueue[i];
+            // meshes without indices are drawn directly below, their command is never read
+            const bool indexed = packet.mesh->hasIndexBuffer;
+            VkDrawIndexedIndirectCommand& command = commands[i];
+            command.indexCount = indexed ? packet.mesh->lods[packet.lod].indexCount : 0;
+            command.instanceCount = 1;
+            command.firstIndex = indexed ? packet.mesh->lods[packet.lod].firstIndex : 0;
+            command.vertexOffset = 0;
+            command.firstInstance = i;
+        }
+        bindInstanceSet(frameInfo, queuedObjectSet);
+
+        recordPasses(frameInfo, [&](bool depthOnly) {
+            const bool multiDraw = lveDevice.getFeatureSupport().multiDrawIndirect;
+            constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+            TextureHandle boundTexture{};
+            AlphaMode boundBucket = AlphaMode::Opaque;
+            uint32_t first = 0;
+            while (first < drawCount) {
+                LveModel::Mesh& mesh = *renderQueue[first].mesh;
+                uint32_t last = first + 1;
+                while (last < drawCount && renderQueue[last].mesh == &mesh) last++;
+                uint32_t count = last - first;
+
+                if (depthOnly && mesh.fragmentBuffer.alphaMode != AlphaMode::Opaque) {
+                    first = last;
+                    continue;
+                }
+                if (!bindBucket(frameInfo, mesh.fragmentBuffer.alphaMode, boundBucket)) {
+                    first = last;
+                    continue;
+                }
+
+                TextureHandle texture = mesh.fragmentBuffer.diffuseTexture;
+                SimplePushConstantData push{};
+                push.textureIndex = texture.index;
                 vkCmdPushConstants(
                     frameInfo.commandBuffer,
                     pipelineLayout,
@@ -98,29 +880,207 @@ namespace lve {
                     sizeof(SimplePushConstantData),
                     &push);
 
+                uint32_t bucketStart = first;
+                first = last;
 
-                // Defensive check
-                if (frameInfo.textureDescriptorSets.count(id) == 0) {
-                    printf("Descriptor set missing for mesh ID: %u", id);
-                    continue;
+                if (!depthOnly && textureBinding != TextureBinding::Bindless) {
+                    if (texture != boundTexture) {
+                        if (!bindMeshTexture(frameInfo, texture)) continue;
+                        boundTexture = texture;
+                    }
+                    else {
+                        frameInfo.renderStats.redundantBindsSkipped++;
+                    }
+                }
+                mesh.bind(frameInfo.commandBuffer);
+                frameInfo.renderStats.vertexBufferBinds++;
+
+                if (!mesh.hasIndexBuffer) {
+                    // the commands are indexed, these few go out directly with the same instance offsets
+                    for (uint32_t i = bucketStart; i < last; i++) {
+                        mesh.draw(frameInfo.commandBuffer, 1, i);
+                    }
+                    frameInfo.renderStats.drawCalls += count;
+                }
+                else if (multiDraw) {
+                    vkCmdDrawIndexedIndirect(frameInfo.commandBuffer, indirectBuffer.getBuffer(), bucketStart * stride, count, stride);
+                    frameInfo.renderStats.drawCalls++;
+                }
+                else {
+                    for (uint32_t i = bucketStart; i < last; i++) {
+                        vkCmdDrawIndexedIndirect(frameInfo.commandBuffer, indirectBuffer.getBuffer(), i * stride, 1, stride);
+                    }
+                    frameInfo.renderStats.drawCalls += count;
                 }
-                VkDescriptorSet set = frameInfo.textureDescriptorSets.at(id);
-                assert(set != VK_NULL_HANDLE && "Descriptor set is null!");
+                frameInfo.renderStats.instances += count;
+            }
+        });
+    }
+
+    // Draws whatever the cull pass of this frame left in the indirect buffer, one call per mesh.
+    // With draw counts the GPU also decides how many commands each call reads. The late phase of
+    // occlusion culling has its own commands, for the objects the early phase didn't draw.
+    void SimpleRenderSystem::renderGpuCulled(FrameInfo& frameInfo, bool late, bool depthOnly) {
+        uint32_t drawCount = gpuCulling->getDrawCount();
+        if (drawCount == 0) return;
+
+        LveBuffer& indirectBuffer = gpuCulling->getIndirectBuffer(frameInfo.frameIndex, late);
+        LveBuffer& countBuffer = gpuCulling->getCountBuffer(frameInfo.frameIndex, late);
+        bindInstanceSet(frameInfo, writeInstanceSet(frameInfo, gpuCulling->getInstanceBuffer(), sizeof(InstanceData) * drawCount));
 
-                // --- Bind the texture descriptor set (set = 1) ---
-                vkCmdBindDescriptorSets(
+        const bool multiDraw = lveDevice.getFeatureSupport().multiDrawIndirect;
+        constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+        // one walk over the cull buckets per render bucket, the prepass only needs the opaque one
+        AlphaMode boundBucket = AlphaMode::Opaque;
+        for (AlphaMode alphaMode : { AlphaMode::Opaque, AlphaMode::Masked, AlphaMode::Blended }) {
+            if (depthOnly && alphaMode != AlphaMode::Opaque) break;
+            TextureHandle boundTexture{};
+            const auto& buckets = gpuCulling->getBuckets();
+            for (uint32_t b = 0; b < buckets.size(); b++) {
+                const auto& bucket = buckets[b];
+                LveModel::Mesh& mesh = *bucket.mesh;
+                if (mesh.fragmentBuffer.alphaMode != alphaMode) continue;
+                if (!bindBucket(frameInfo, alphaMode, boundBucket)) continue;
+                TextureHandle texture = mesh.fragmentBuffer.diffuseTexture;
+
+                SimplePushConstantData push{};
+                push.textureIndex = texture.index;
+                vkCmdPushConstants(
                     frameInfo.commandBuffer,
-                    VK_PIPELINE_BIND_POINT_GRAPHICS,
                     pipelineLayout,
-                    1, 1,
-                    &frameInfo.textureDescriptorSets.at(id),
-                    0, nullptr);
+                    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                    0,
+                    sizeof(SimplePushConstantData),
+                    &push);
 
-                // --- Bind and draw model ---
+                if (!depthOnly && textureBinding != TextureBinding::Bindless) {
+                    if (texture != boundTexture) {
+                        if (!bindMeshTexture(frameInfo, texture)) continue;
+                        boundTexture = texture;
+                    }
+                    else {
+                        frameInfo.renderStats.redundantBindsSkipped++;
+                    }
+                }
                 mesh.bind(frameInfo.commandBuffer);
-                mesh.draw(frameInfo.commandBuffer);
+                frameInfo.renderStats.vertexBufferBinds++;
+
+                VkDeviceSize offset = bucket.firstDraw * stride;
+                if (gpuCulling->usesDrawCount()) {
+                    vkCmdDrawIndexedIndirectCount(
+                        frameInfo.commandBuffer,
+                        indirectBuffer.getBuffer(), offset,
+                        countBuffer.getBuffer(), b * sizeof(uint32_t),
+                        bucket.drawCount, stride);
+                    frameInfo.renderStats.drawCalls++;
+                }
+                else if (multiDraw) {
+                    vkCmdDrawIndexedIndirect(frameInfo.commandBuffer, indirectBuffer.getBuffer(), offset, bucket.drawCount, stride);
+                    frameInfo.renderStats.drawCalls++;
+                }
+                else {
+                    for (uint32_t i = 0; i < bucket.drawCount; i++) {
+                        vkCmdDrawIndexedIndirect(frameInfo.commandBuffer, indirectBuffer.getBuffer(), offset + i * stride, 1, stride);
+                    }
+                    frameInfo.renderStats.drawCalls += bucket.drawCount;
+                }
+                if (!late) {
+                    frameInfo.renderStats.instances += bucket.drawCount; // before culling, the visible count stays on the GPU
+                }
             }
         }
     }
 
+    // Grows this frame's host-visible buffer if needed, the old one is retired once its frame is done
+    LveBuffer& SimpleRenderSystem::getFrameBuffer(std::vector<std::unique_ptr<LveBuffer>>& buffers, int frameIndex,
+        VkDeviceSize instanceSize, uint32_t count, VkBufferUsageFlags usage) {
+        auto& buffer = buffers[frameIndex];
+        if (!buffer || buffer->getInstanceCount() < count) {
+            uint32_t capacity = 256;
+            while (capacity < count) capacity *= 2;
+            buffer = std::make_unique<LveBuffer>(
+                lveDevice,
+                instanceSize,
+                capacity,
+                usage,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            buffer->map();
+        }
+        return *buffer;
+    }
+
+    // Packs the queued draws into this frame's object buffer, draw i at entry i, for
+    // recordQueuedDraws and renderIndirect
+    void SimpleRenderSystem::writeQueuedObjects(FrameInfo& frameInfo) {
+        queuedObjectSet = VK_NULL_HANDLE;
+        uint32_t drawCount = static_cast<uint32_t>(renderQueue.size());
+        if (drawCount == 0) return;
+
+        LveBuffer& objectBuffer = getFrameBuffer(
+            instanceBuffers, frameInfo.frameIndex, sizeof(InstanceData), drawCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        auto* objects = static_cast<InstanceData*>(objectBuffer.getMappedMemory());
+        for (uint32_t i = 0; i < drawCount; i++) {
+            objects[i] = InstanceData::pack(renderQueue[i].modelMatrix, renderQueue[i].lodFade);
+        }
+        queuedObjectSet = writeInstanceSet(frameInfo, objectBuffer, sizeof(InstanceData) * drawCount);
+    }
+
+    // Transient set, recycled with the frame's descriptor pools
+    VkDescriptorSet SimpleRenderSystem::writeInstanceSet(FrameInfo& frameInfo, LveBuffer& instanceBuffer, VkDeviceSize size) {
+        auto bufferInfo = instanceBuffer.descriptorInfo(size);
+        VkDescriptorSet instanceSet;
+        if (!LveDescriptorWriter(*instanceSetLayout, frameInfo.frameDescriptorAllocator)
+            .writeBuffer(0, &bufferInfo)
+            .build(instanceSet)) {
+            throw std::runtime_error("failed to allocate instance descriptor set!");
+        }
+        return instanceSet;
+    }
+
+    void SimpleRenderSystem::bindInstanceSet(FrameInfo& frameInfo, VkDescriptorSet instanceSet) {
+        assert(instanceSet != VK_NULL_HANDLE && "No object buffer written for these draws");
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            2, 1,
+            &instanceSet,
+            0, nullptr);
+        frameInfo.renderStats.descriptorBinds++;
+    }
+
+    bool SimpleRenderSystem::bindMeshTexture(FrameInfo& frameInfo, TextureHandle texture) {
+        // Defensive check
+        assert(frameInfo.resourceManager.isValid(texture) && "Mesh references a stale texture handle!");
+        if (textureBinding == TextureBinding::PushDescriptors) {
+            // --- Push the texture (set = 1), no descriptor set involved ---
+            const LveTexture* diffuse = frameInfo.resourceManager.getTexture(texture);
+            VkDescriptorImageInfo diffuseInfo{};
+            diffuseInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            diffuseInfo.imageView = diffuse->getImageView();
+            diffuseInfo.sampler = diffuse->getSampler();
+            textureUpdateTemplate->push(frameInfo.commandBuffer, &diffuseInfo);
+            frameInfo.renderStats.descriptorBinds++;
+        }
+        else if (textureBinding == TextureBinding::PerTextureSets) {
+            if (texture.index >= frameInfo.textureDescriptorSets.size()) {
+                printf("Descriptor set missing for texture slot: %u", texture.index);
+                return false;
+            }
+            VkDescriptorSet set = frameInfo.textureDescriptorSets[texture.index];
+            assert(set != VK_NULL_HANDLE && "Descriptor set is null!");
+
+            // --- Bind the texture descriptor set (set = 1) ---
+            vkCmdBindDescriptorSets(
+                frameInfo.commandBuffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                pipelineLayout,
+                1, 1,
+                &set,
+                0, nullptr);
+            frameInfo.renderStats.descriptorBinds++;
+        }
+        return true;
+    }
+
 }  // namespace lve
\ No newline at end of file
@@ -6,29 +6,275 @@
 #include "../lve_pipeline.h"
 #include "../lve_frame_info.h"
 #include "../lve_descriptors.h"
+#include "../lve_buffer.h"
+#include "../lve_render_queue.h"
+#include "../lve_frustum.h"
+#include "../lve_occlusion.h"
+#include "../lve_parallel_recorder.h"
+#include "gpu_cull_system.h"
 
 // std
+#include <array>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace lve {
 	class SimpleRenderSystem {
 	public:
-		SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
+		// How the diffuse texture (set 1) reaches each draw; the layout passed for set 1 must match
+		enum class TextureBinding {
+			PerTextureSets,  // one prebuilt set per texture, bound per draw
+			PushDescriptors, // pushed per draw through an update template, layout has the push descriptor flag
+			Bindless,        // bindless texture table bound once, draws select their slot in push constants
+		};
+
+		// How draws are issued. Every mode reads the object matrices from a storage buffer the
+		// system owns (InstanceData, its layout is appended as set 2) at gl_InstanceIndex, so push
+		// constants only carry what changes per mesh.
+		enum class DrawSubmission {
+			PerObject, // one vkCmdDrawIndexed per object and mesh, firstInstance selects its matrices
+			Instanced, // objects sharing a model become one instanced draw per mesh
+			Indirect,  // one indirect command per object and mesh, one indirect call per mesh
+			GpuCulled, // like Indirect, but the commands come from GpuCullSystem's compute pass
+		};
+
+		// With vertexPulling the pipeline has no vertex input, the shader fetches vertices through
+		// the mesh's buffer device address instead (needs DeviceFeatureSupport::bufferDeviceAddress).
+		// Vertex pulling only works with PerObject submission.
+		// With lodCrossFade a LOD change fades over a few frames with a dither pattern instead of
+		// popping, which puts a discard in the fragment shader. GpuCulled doesn't fade, and neither
+		// do meshes that aren't opaque.
+		//
+		// Meshes draw in the bucket of their material's AlphaMode, each with its own pipeline, in
+		// order: opaque, masked (alpha test, alpha-to-coverage under MSAA), then blended. Only the
+		// masked and blended shaders discard, so the opaque ones keep early depth testing. The queued
+		// modes (PerObject, Indirect) sort opaque and masked draws by state and front to back within
+		// it, blended ones back to front; Instanced and GpuCulled draw their blended meshes unsorted.
+		SimpleRenderSystem(
+			LveDevice& device,
+			VkRenderPass renderPass,
+			std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+			TextureBinding textureBinding = TextureBinding::PerTextureSets,
+			bool vertexPulling = false,
+			DrawSubmission drawSubmission = DrawSubmission::PerObject,
+			bool lodCrossFade = false);
 		~SimpleRenderSystem();
 
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
+		// Records the GPU culling pass for GpuCulled, call before the render pass begins
+		void cullGameObjects(FrameInfo& frameInfo);
 		void renderGameObjects(FrameInfo &frameInfo);
+		// GpuCulled uploads the scene once, models and transforms changing afterwards need this
+		void invalidateStaticScene();
+		// CPU frustum culling of the other submission modes, on by default
+		void setFrustumCulling(bool enabled) { frustumCulling = enabled; }
+
+		// Two-phase Hi-Z occlusion culling for GpuCulled. With it on, the frame's render pass has to be
+		// split: after renderGameObjects end it, cullLateGameObjects, resume it, renderLateGameObjects.
+		// The other modes rasterize the objects' occluders on the CPU in cullGameObjects instead and
+		// test what survives frustum culling against them, so it needs frustum culling on there.
+		void setOcclusionCulling(bool enabled);
+		bool hasLatePass() const { return gpuCulling && gpuCulling->usesOcclusionCulling(); }
+		void cullLateGameObjects(FrameInfo& frameInfo, const LveDepthTarget& depth);
+		void renderLateGameObjects(FrameInfo& frameInfo);
+
+		// Each mesh draws the coarsest LOD whose error projects to at most a pixel, picked per mesh
+		// (per object when instancing, in the cull pass for GpuCulled). The bias is in powers of
+		// two, positive picks coarser levels.
+		void setLodSelection(bool enabled) { lodSelection = enabled; }
+		void setLodBias(float bias) { lodBias = bias; }
+
+		// Depth prepass: the draws are recorded twice, first into depth only with a position-only
+		// pipeline, then shaded with an EQUAL depth test and depth writes off, so the lighting
+		// shader runs once per pixel whatever the overdraw, for a second geometry pass. Only opaque
+		// meshes are in the prepass, the others depth test against it as usual.
+		void setDepthPrepass(bool enabled);
+		bool usesDepthPrepass() const { return depthPrepass; }
+
+		// PerObject draws can be recorded on several threads instead of renderGameObjects:
+		// queueGameObjects on the calling thread returns the draw count, then recordGameObjects
+		// records disjoint ranges of the queue, each into its own command buffer with its own
+		// RenderStats (see FrameInfo::withCommandBuffer). Recording only reads the system. With the
+		// depth prepass every range is also recorded depthOnly, and all of those have to execute
+		// before the shading ones.
+		bool supportsParallelRecording() const { return drawSubmission == DrawSubmission::PerObject && !usesDeferred(); }
+		uint32_t queueGameObjects(FrameInfo& frameInfo);
+		void recordGameObjects(FrameInfo& frameInfo, uint32_t first, uint32_t count, bool depthOnly = false);
+
+		// Static command buffers (PerObject only): the opaque and masked meshes, unculled and at full
+		// detail, are recorded once per frame in flight into a secondary command buffer that is
+		// replayed every frame instead of renderGameObjects. The blended ones are sorted by the
+		// camera, so renderBlendedGameObjects still draws them every frame after the replay. They are re-recorded after invalidateStaticScene and
+		// when the render pass (see LveRenderer::getSwapChainGeneration) or extent changes; a new
+		// system (MSAA, other modes) starts over. The frame's pass has to be begun with secondary
+		// contents.
+		void setStaticCommandBuffers(bool enabled);
+		bool usesStaticCommandBuffers() const { return staticCommandBuffers && drawSubmission == DrawSubmission::PerObject && !usesDeferred(); }
+		VkCommandBuffer getStaticCommandBuffer(FrameInfo& frameInfo, VkRenderPass renderPass, uint32_t renderPassGeneration);
+
+		// Deferred shading (see DeferredRenderSystem): renderGameObjects and renderLateGameObjects
+		// draw the opaque and masked buckets into the G-buffer pass given here, with pipelines of
+		// their own, and renderBlendedGameObjects draws the blended bucket forward afterwards in the
+		// swap chain pass, from what they prepared this frame. The depth prepass, static command
+		// buffers and parallel recording are skipped. A null render pass goes back to forward.
+		void setDeferred(VkRenderPass gbufferRenderPass);
+		bool usesDeferred() const { return gbufferPipeline != nullptr; }
+		// Deferred, or with static command buffers, where it culls and sorts them itself
+		void renderBlendedGameObjects(FrameInfo& frameInfo);
 
 	private:
+		// What the draws being recorded go into, which picks the buckets and pipelines
+		enum class Output {
+			Forward,  // every bucket, shaded
+			GBuffer,  // opaque and masked, albedo and normals only
+			Blended,  // the blended bucket after a G-buffer pass
+		};
+
+		// Which meshes queueVisibleGameObjects queues
+		enum class QueuedBuckets {
+			All,
+			DepthWriting, // opaque and masked
+			Blended,
+		};
+
 		void createPipelineLayout(std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
 		void createPipeline(VkRenderPass renderPass);
+		float computeLodScale(const FrameInfo& frameInfo) const;
+		void rasterizeOccluders(FrameInfo& frameInfo);
+		void cullBoundsVisibility(FrameInfo& frameInfo, size_t count);
+		void beginLodFrame(const FrameInfo& frameInfo);
+		void queueVisibleGameObjects(FrameInfo& frameInfo, QueuedBuckets buckets = QueuedBuckets::All);
+		void recordQueuedDraws(FrameInfo& frameInfo, uint32_t first, uint32_t count, bool depthOnly);
+		void renderInstanced(FrameInfo& frameInfo);
+		void recordInstanced(FrameInfo& frameInfo, bool depthOnly);
+		void renderIndirect(FrameInfo& frameInfo);
+		void bindPipeline(FrameInfo& frameInfo, bool depthOnly = false);
+		// Switches to the bucket's shading pipeline when bound is another one; the sets and push
+		// constants stay, every pipeline has the same layout. False when the output skips the bucket.
+		bool bindBucket(FrameInfo& frameInfo, AlphaMode alphaMode, AlphaMode& bound);
+		void renderGpuCulled(FrameInfo& frameInfo, bool late, bool depthOnly);
+
+		// Records draw(true) after the prepass pipeline when the prepass is on, then draw(false)
+		// after the shading one. Prepass draws are counted apart from the shaded ones.
+		template <typename Draw>
+		void recordPasses(FrameInfo& frameInfo, Draw&& draw) {
+			if (depthPrepass && output == Output::Forward) {
+				bindPipeline(frameInfo, true);
+				RenderStats& stats = frameInfo.renderStats;
+				const uint32_t drawCalls = stats.drawCalls;
+				const uint32_t instances = stats.instances;
+				draw(true);
+				stats.prepassDrawCalls += stats.drawCalls - drawCalls;
+				stats.drawCalls = drawCalls;
+				stats.instances = instances;
+			}
+			bindPipeline(frameInfo, false);
+			draw(false);
+		}
+		LveBuffer& getFrameBuffer(std::vector<std::unique_ptr<LveBuffer>>& buffers, int frameIndex,
+			VkDeviceSize instanceSize, uint32_t count, VkBufferUsageFlags usage);
+		void writeQueuedObjects(FrameInfo& frameInfo);
+		VkDescriptorSet writeInstanceSet(FrameInfo& frameInfo, LveBuffer& instanceBuffer, VkDeviceSize size);
+		void bindInstanceSet(FrameInfo& frameInfo, VkDescriptorSet instanceSet);
+		bool bindMeshTexture(FrameInfo& frameInfo, TextureHandle texture);
+
+		using InstanceData = GpuCullSystem::InstanceData; // the cull pass reads the same layout
+
+		struct DrawPacket {
+			LveModel::Mesh* mesh;
+			glm::mat4 modelMatrix;
+			uint32_t lod = 0;
+			float lodFade = 0.f; // > 0 fading out, < 0 fading in, see the dithered fragment shaders
+		};
+
+		struct CullCandidate {
+			uint64_t key;
+			uint64_t lodKey;
+			DrawPacket packet;
+		};
+
+		struct InstanceGroup {
+			LveModel* model = nullptr;
+			uint32_t lod = 0;
+			uint32_t lastFrame = 0; // lodFrame it was last filled in
+			std::vector<InstanceData> instances;
+		};
+
+		// Level an object (or one of its meshes) draws; while a cross-fade runs previousLod differs
+		// and progress goes from 0 to 1
+		struct LodState {
+			uint32_t lod;
+			uint32_t previousLod;
+			float progress;
+			uint32_t lastFrame;
+		};
+
+		struct StaticCommands {
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			bool valid = false;
+			uint32_t renderPassGeneration = 0;
+			VkExtent2D extent{};
+			RenderStats stats{}; // of the recording, added to the frame's on every replay
+			VkDescriptorSet objectSet = VK_NULL_HANDLE; // staticObjectBuffers[frame index], rewritten with the commands
+		};
+
+		void recordStaticCommands(FrameInfo& frameInfo, VkRenderPass renderPass, StaticCommands& commands);
+		LodState updateLod(uint64_t lodKey, uint32_t lod, float frameTime);
+		void submitDraw(FrameInfo& frameInfo, uint64_t key, uint64_t lodKey, DrawPacket packet);
 
 		LveDevice& lveDevice;
+		TextureBinding textureBinding;
+		bool vertexPulling;
+		DrawSubmission drawSubmission;
+		bool lodCrossFade;
+
+		LveRenderQueue<DrawPacket> renderQueue;
+		VkDescriptorSet queuedObjectSet = VK_NULL_HANDLE; // matrices of the queued draws, in queue order
+
+		bool frustumCulling = true;
+		LveBoundsSoA cullBounds; // scratch, reused every frame
+		std::vector<uint8_t> cullVisibility;
+		std::vector<CullCandidate> cullCandidates;
+		std::vector<std::pair<LveGameObject*, glm::mat4>> cullObjects;
+		bool occlusionCulling = false;
+		std::unique_ptr<LveOcclusionBuffer> occlusionBuffer; // created on first use, owns the worker threads
+
+		bool lodSelection = true;
+		float lodBias = 0.f;
+		float lodScale = 0.f; // this frame's, 0 when LODs are off
+		glm::vec3 lodCameraPosition{ 0.f };
+		std::unordered_map<uint64_t, LodState> lodStates; // cross-fade only, per lodKey
+		uint32_t lodFrame = 0;
+
+		bool staticCommandBuffers = false;
+		VkCommandPool staticCommandPool = VK_NULL_HANDLE; // created on first use
+		std::array<StaticCommands, LveSwapChain::MAX_FRAMES_IN_FLIGHT> staticCommands; // per frame index
+		std::vector<std::unique_ptr<LveBuffer>> staticObjectBuffers; // their matrices, same indexing
+		std::unique_ptr<LveDescriptorPool> staticDescriptorPool; // their object sets, outlive the frame's pools
+
+		std::unique_ptr<LveDescriptorSetLayout> instanceSetLayout;
+		std::vector<std::unique_ptr<LveBuffer>> instanceBuffers; // one per frame in flight, grown on demand
+		std::vector<std::unique_ptr<LveBuffer>> indirectBuffers; // Indirect only, same as instanceBuffers
+		std::unique_ptr<GpuCullSystem> gpuCulling; // GpuCulled only
+		std::vector<InstanceGroup> instanceGroups; // reused every frame to keep their allocations
+		std::unordered_map<uint64_t, uint32_t> groupIndices; // model id and LOD to instanceGroups slot
+		std::vector<uint32_t> activeGroups; // slots with instances this frame, in draw order
+		VkDescriptorSet instancedObjectSet = VK_NULL_HANDLE; // their matrices this frame
+		std::unique_ptr<LveDescriptorUpdateTemplate> textureUpdateTemplate; // PushDescriptors only
+
+		bool depthPrepass = false;
+		Output output = Output::Forward;
 
 		std::unique_ptr<LvePipeline> lvePipeline;
+		std::unique_ptr<LvePipeline> depthPrepassPipeline; // positions only, no color writes
+		std::unique_ptr<LvePipeline> prepassShadingPipeline; // lvePipeline with an EQUAL depth test and no depth writes
+		std::unique_ptr<LvePipeline> alphaTestPipeline; // Masked meshes, both faces
+		std::unique_ptr<LvePipeline> blendedPipeline; // Blended meshes, no depth writes
+		std::unique_ptr<LvePipeline> gbufferPipeline; // deferred only, into the G-buffer pass
+		std::unique_ptr<LvePipeline> gbufferMaskedPipeline;
 		VkPipelineLayout pipelineLayout;
 	};
 }  // namespace lve
\ No newline at end of file
@@ -1,7 +1,40 @@
-C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\simple_shader.vert -o Shaders\simple_shader.vert.spv
-C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\simple_shader.frag -o Shaders\simple_shader.frag.spv
-C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\light.vert -o Shaders\light.vert.spv
-C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\light.frag -o Shaders\light.frag.spv
-C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\skybox.vert -o Shaders\skybox.vert.spv
-C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\skybox.frag -o Shaders\skybox.frag.spv
-pause
\ No newline at end of file
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\simple_shader.vert -o Shaders\simple_shader.vert.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\simple_shader.frag -o Shaders\simple_shader.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DLOD_DITHER Shaders\simple_shader.frag -o Shaders\simple_shader_dither.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\light.vert -o Shaders\light.vert.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\light.frag -o Shaders\light.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\skybox.vert -o Shaders\skybox.vert.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\skybox.frag -o Shaders\skybox.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\simple_shader_bindless.frag -o Shaders\simple_shader_bindless.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DLOD_DITHER Shaders\simple_shader_bindless.frag -o Shaders\simple_shader_bindless_dither.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DALPHA_TEST Shaders\simple_shader.frag -o Shaders\simple_shader_alpha_test.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DALPHA_TO_COVERAGE Shaders\simple_shader.frag -o Shaders\simple_shader_alpha_coverage.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DALPHA_BLEND Shaders\simple_shader.frag -o Shaders\simple_shader_alpha_blend.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DALPHA_TEST Shaders\simple_shader_bindless.frag -o Shaders\simple_shader_bindless_alpha_test.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DALPHA_TO_COVERAGE Shaders\simple_shader_bindless.frag -o Shaders\simple_shader_bindless_alpha_coverage.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DALPHA_BLEND Shaders\simple_shader_bindless.frag -o Shaders\simple_shader_bindless_alpha_blend.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe --target-env=vulkan1.2 Shaders\simple_shader_pulled.vert -o Shaders\simple_shader_pulled.vert.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\cull_frustum.comp -o Shaders\cull_frustum.comp.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DOCCLUSION Shaders\cull_frustum.comp -o Shaders\cull_occlusion.comp.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\depth_pyramid_init.comp -o Shaders\depth_pyramid_init.comp.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DMULTISAMPLED Shaders\depth_pyramid_init.comp -o Shaders\depth_pyramid_init_ms.comp.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\depth_pyramid.comp -o Shaders\depth_pyramid.comp.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\depth_prepass.vert -o Shaders\depth_prepass.vert.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe --target-env=vulkan1.2 -DVERTEX_PULLING Shaders\depth_prepass.vert -o Shaders\depth_prepass_pulled.vert.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\depth_prepass.frag -o Shaders\depth_prepass.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\gbuffer.frag -o Shaders\gbuffer.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\gbuffer_bindless.frag -o Shaders\gbuffer_bindless.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DLOD_DITHER Shaders\gbuffer.frag -o Shaders\gbuffer_dither.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DALPHA_TEST Shaders\gbuffer.frag -o Shaders\gbuffer_alpha_test.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DLOD_DITHER Shaders\gbuffer_bindless.frag -o Shaders\gbuffer_bindless_dither.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe -DALPHA_TEST Shaders\gbuffer_bindless.frag -o Shaders\gbuffer_bindless_alpha_test.frag.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\tiled_lighting.comp -o Shaders\tiled_lighting.comp.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\deferred_composite.vert -o Shaders\deferred_composite.vert.spv || goto :error
+C:\Dev\Tools\VulkanSDK\InstallationFolder\Bin\glslc.exe Shaders\deferred_composite.frag -o Shaders\deferred_composite.frag.spv || goto :error
+if "%1"=="" pause
+exit /b 0
+
+:error
+echo Shader compilation failed, the .spv files in Shaders are out of date
+if "%1"=="" pause
+exit /b 1
\ No newline at end of file
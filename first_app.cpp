@@ -3,6 +3,8 @@
 #include "lve_camera.h"
 #include "input_controller.h"
 #include "lve_buffer.h"
+#include "lve_benchmarks.h"
+#include "lve_occlusion.h"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -11,16 +13,27 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cassert>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <random>
 #include <stdexcept>
+#include <thread>
 
 namespace lve {
 
+    static const char* drawSubmissionName(SimpleRenderSystem::DrawSubmission drawSubmission) {
+        const char* names[] = { "per-object", "instanced", "indirect", "GPU culled" };
+        return names[static_cast<int>(drawSubmission)];
+    }
+
     FirstApp::FirstApp() { 
-        defaultTexture = LveTexture::createFromFile(lveDevice, "Textures/white.png");
-        assert(defaultTexture && "Default texture pointer is null!");
+        defaultTexture = resourceManager.loadTexture("Textures/white.png");
+        assert(resourceManager.isValid(defaultTexture) && "Default texture handle is invalid!");
 
         // Load skybox cubemap (you'll need to provide the 6 face texture paths)
         std::array<std::string, 6> skyboxPaths = {
@@ -35,18 +48,41 @@ namespace lve {
 
         loadGameObjects();
 
-        uint32_t totalMeshCount = 0;
-        for (auto& kv : gameObjects) {
-            auto& obj = kv.second;
-			totalMeshCount += obj.getMeshCount();
+        // persistent sets (global UBO and light buffers + one per texture), grows into new pools on demand
+        globalAllocator = LveDescriptorAllocator::Builder(lveDevice)
+            .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0.5f)
+            .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.5f)
+            .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.f)
+            .build();
+
+        // transient sets, recycled with vkResetDescriptorPool once their frame slot comes around again
+        frameAllocators = std::vector<std::unique_ptr<LveDescriptorAllocator>>(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto& allocator : frameAllocators) {
+            allocator = LveDescriptorAllocator::Builder(lveDevice)
+                .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.f)
+                .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.f)
+                .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.f)
+                .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f) // depth pyramid levels
+                .build();
+        }
+        frameMemory = std::vector<std::unique_ptr<LveLinearAllocator>>(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto& memory : frameMemory) {
+            memory = std::make_unique<LveLinearAllocator>();
         }
 
-        globalPool = LveDescriptorPool::Builder(lveDevice)
-            .setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT + totalMeshCount)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, totalMeshCount)
-            .build();
-        createSystemsAndDescriptorLayouts();
+        // one texture table bound once per frame, per-texture sets stay around as the fallback path
+        if (LveBindlessTextureTable::isSupported(lveDevice)) {
+            bindlessTextures = std::make_unique<LveBindlessTextureTable>(lveDevice);
+        }
+
+        createDescriptorLayoutsAndGlobalSets();
+        if (isTextureBindingSupported(SimpleRenderSystem::TextureBinding::Bindless)) {
+            textureBinding = SimpleRenderSystem::TextureBinding::Bindless;
+        }
+        else if (isTextureBindingSupported(SimpleRenderSystem::TextureBinding::PushDescriptors)) {
+            textureBinding = SimpleRenderSystem::TextureBinding::PushDescriptors;
+        }
+        createSystems();
         createDescriptorSets();
     }
 
@@ -82,15 +118,31 @@ namespace lve {
             camera.setPerspectiveProjection(glm::radians(60.f), aspect, 0.1f, 100.f);
 
             if (auto commandBuffer = lveRenderer.beginFrame()) {
+                auto cpuStart = std::chrono::high_resolution_clock::now();
+                const uint64_t heapAllocationsBefore = getHeapAllocationCount();
+                const uint32_t swapChainGeneration = lveRenderer.getSwapChainGeneration();
+                renderStats = {};
                 int frameIndex = lveRenderer.getFrameIndex();
+                frameAllocators[frameIndex]->resetPools(); // the slot's fence was waited on in beginFrame
+                frameMemory[frameIndex]->reset();
+                transformStore.sync(gameObjects); // rebuilds only the matrices whose transform changed
                 FrameInfo frameInfo{
                     frameIndex,
                     frameTime,
                     commandBuffer,
                     camera,
+                    lveRenderer.getExtent(),
                     globalDescriptorSets[frameIndex],
+                    *frameAllocators[frameIndex],
+                    *frameMemory[frameIndex],
                     textureDescriptorSets,
-                    gameObjects
+                    textureBinding == SimpleRenderSystem::TextureBinding::Bindless
+                        ? bindlessTextures->getDescriptorSet()
+                        : VK_NULL_HANDLE,
+                    resourceManager,
+                    gameObjects,
+                    transformStore,
+                    renderStats
                 };
 
                 //update
@@ -98,17 +150,83 @@ namespace lve {
                 ubo.projection = camera.getProjection();
                 ubo.view = camera.getView();
 				ubo.inverseView = camera.getInverseView();
-				lightSystem->update(frameInfo, ubo);
+				lightClusters.update(frameInfo, ubo);
                 uboBuffers[frameIndex]->writeToBuffer(&ubo);
                 uboBuffers[frameIndex]->flush();
 
                 //render
-                lveRenderer.beginSwapChainRenderPass(commandBuffer);
-                skyboxRenderSystem->render(frameInfo);
-                simpleRenderSystem->renderGameObjects(frameInfo);
-				lightSystem->render(frameInfo);
-                lveRenderer.endSwapChainRenderPass(commandBuffer);
+                simpleRenderSystem->cullGameObjects(frameInfo); // compute, has to run outside the render pass
+                if (deferredRenderSystem) {
+                    // opaque and masked meshes into the G-buffer, lit per tile, then everything
+                    // forward (skybox, blended meshes, light billboards) on top of the composite
+                    deferredRenderSystem->beginGBufferPass(frameInfo);
+                    simpleRenderSystem->renderGameObjects(frameInfo);
+                    deferredRenderSystem->endGBufferPass(frameInfo);
+                    if (simpleRenderSystem->hasLatePass()) {
+                        simpleRenderSystem->cullLateGameObjects(frameInfo, deferredRenderSystem->getDepthTarget());
+                        deferredRenderSystem->beginGBufferPass(frameInfo, true);
+                        simpleRenderSystem->renderLateGameObjects(frameInfo);
+                        deferredRenderSystem->endGBufferPass(frameInfo);
+                    }
+                    deferredRenderSystem->light(frameInfo);
+
+                    lveRenderer.beginSwapChainRenderPass(commandBuffer);
+                    deferredRenderSystem->composite(frameInfo);
+                    skyboxRenderSystem->render(frameInfo);
+                    simpleRenderSystem->renderBlendedGameObjects(frameInfo);
+                    lightSystem->render(frameInfo);
+                    lveRenderer.endSwapChainRenderPass(commandBuffer);
+                }
+                else if (simpleRenderSystem->usesStaticCommandBuffers()) {
+                    // the objects replay their cached commands, only the skybox, blended meshes and lights are recorded
+                    parallelRecorder->beginFrame(
+                        frameIndex, lveRenderer.getSwapChainRenderPass(), lveRenderer.getCurrentFramebuffer(), lveRenderer.getExtent());
+                    parallelRecorder->record(1, [&](uint32_t, VkCommandBuffer jobCommandBuffer) {
+                        FrameInfo jobInfo = frameInfo.withCommandBuffer(jobCommandBuffer, renderStats); // single jobs run on this thread
+                        skyboxRenderSystem->render(jobInfo);
+                    });
+                    parallelRecorder->add(simpleRenderSystem->getStaticCommandBuffer(
+                        frameInfo, lveRenderer.getSwapChainRenderPass(), lveRenderer.getSwapChainGeneration()));
+                    parallelRecorder->record(1, [&](uint32_t, VkCommandBuffer jobCommandBuffer) {
+                        FrameInfo jobInfo = frameInfo.withCommandBuffer(jobCommandBuffer, renderStats);
+                        simpleRenderSystem->renderBlendedGameObjects(jobInfo);
+                        lightSystem->render(jobInfo);
+                    });
+                    lveRenderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                    parallelRecorder->execute(commandBuffer);
+                    lveRenderer.endSwapChainRenderPass(commandBuffer);
+                }
+                else if (parallelRecording && simpleRenderSystem->supportsParallelRecording()) {
+                    // everything is recorded into secondary command buffers, the primary only executes them
+                    parallelRecorder->beginFrame(
+                        frameIndex, lveRenderer.getSwapChainRenderPass(), lveRenderer.getCurrentFramebuffer(), lveRenderer.getExtent());
+                    recordSceneParallel(*parallelRecorder, frameInfo);
+                    lveRenderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                    parallelRecorder->execute(commandBuffer);
+                    lveRenderer.endSwapChainRenderPass(commandBuffer);
+                }
+                else {
+                    lveRenderer.beginSwapChainRenderPass(commandBuffer);
+                    skyboxRenderSystem->render(frameInfo);
+                    simpleRenderSystem->renderGameObjects(frameInfo);
+                    if (simpleRenderSystem->hasLatePass()) {
+                        // occlusion culling against the depth drawn so far, then the newly visible objects
+                        lveRenderer.endSwapChainRenderPass(commandBuffer);
+                        simpleRenderSystem->cullLateGameObjects(frameInfo, lveRenderer.getCurrentDepthTarget());
+                        lveRenderer.resumeSwapChainRenderPass(commandBuffer);
+                        simpleRenderSystem->renderLateGameObjects(frameInfo);
+                    }
+                    lightSystem->render(frameInfo);
+                    lveRenderer.endSwapChainRenderPass(commandBuffer);
+                }
                 lveRenderer.endFrame();
+                checkFrameAllocations(getHeapAllocationCount() - heapAllocationsBefore,
+                    swapChainGeneration == lveRenderer.getSwapChainGeneration()); // a resize rebuilds everything
+
+                const double cpuMilliseconds = std::chrono::duration<double, std::milli>(
+                    std::chrono::high_resolution_clock::now() - cpuStart).count();
+                accumulateStats(frameTime, cpuMilliseconds);
+                updateShadingComparison(frameTime, cpuMilliseconds);
             }
         }
 
@@ -119,11 +237,19 @@ namespace lve {
 
         //Obj1
         auto gameObj = LveGameObject::createGameObject();
-        std::shared_ptr<LveModel> lveModel = LveModel::createModelFromFile(lveDevice, "C://Dev//Work//CODING//VULKAN_PROJECTS//VulkanProject1//VulkanProject1//Models//city//city.obj");
+        std::shared_ptr<LveModel> lveModel = LveModel::createModelFromFile(lveDevice, resourceManager, "C://Dev//Work//CODING//VULKAN_PROJECTS//VulkanProject1//VulkanProject1//Models//city//city.obj");
         gameObj.model = lveModel;
+        gameObj.occluder = LveOccluder::createFromModel(*lveModel);
+        gameObj.isStatic = true;
             //gameObj.transform.translation = { 0.0f, 0.0f, 2.5f };
         gameObjects.emplace(gameObj.getId(), std::move(gameObj));
 
+        // the city's meshes, merged per texture and chunk before anything is drawn
+        LveStaticBatcher::Stats batching = LveStaticBatcher::batch(lveDevice, resourceManager, gameObjects);
+        std::cout << "static batching: " << batching.objects << " objects, " << batching.drawsBefore << " draws -> "
+            << batching.drawsAfter << " draws in " << batching.chunks << " chunks ("
+            << batching.vertices << " vertices, " << batching.triangles << " triangles)" << std::endl;
+
         //Lights
         /*{
             auto lightObj = LveGameObject::makeLight(2.f, 0.1f, glm::vec3(1.f, 0.f, 0.f));
@@ -143,38 +269,51 @@ namespace lve {
             gameObjects.emplace(lightObj.getId(), std::move(lightObj));
         }
     }
+    // Only allocates sets for textures that don't have one yet (or whose slot was reused), so it
+    // can be called again after spawning objects without touching the existing sets
     void FirstApp::createDescriptorSets() {
         for (auto& kv : gameObjects) {
             auto& obj = kv.second;
 
             if (obj.model == nullptr) continue;
-            for (auto& kv : obj.model->meshes) {
-                auto& mesh = kv.second;
-                auto id = kv.first;
-
-                if (!mesh.fragmentBuffer.diffuseTexture) {
+            for (auto& mesh : obj.model->meshes) {
+                if (!resourceManager.isValid(mesh.fragmentBuffer.diffuseTexture)) {
                     mesh.fragmentBuffer.diffuseTexture = defaultTexture;
+                    resourceManager.retain(defaultTexture);
                 }
+            }
+        }
 
-                VkDescriptorImageInfo diffuseInfo{};
-                diffuseInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                diffuseInfo.imageView = mesh.fragmentBuffer.diffuseTexture->getImageView();
-                diffuseInfo.sampler = mesh.fragmentBuffer.diffuseTexture->getSampler();
-
+        textureDescriptorSets.resize(resourceManager.getTextureCapacity(), VK_NULL_HANDLE);
+        textureDescriptorGenerations.resize(resourceManager.getTextureCapacity(), 0);
+        resourceManager.forEachTexture([&](TextureHandle handle, LveTexture& texture) {
+            if (textureDescriptorSets[handle.index] != VK_NULL_HANDLE &&
+                textureDescriptorGenerations[handle.index] == handle.generation) {
+                return;
+            }
 
-                VkDescriptorSet descriptorSet;
-                LveDescriptorWriter(*textureSetLayout, *globalPool)
-                    .writeImage(0, &diffuseInfo) //diffuse at binding 0
-                    .build(descriptorSet);
+            VkDescriptorImageInfo diffuseInfo{};
+            diffuseInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            diffuseInfo.imageView = texture.getImageView();
+            diffuseInfo.sampler = texture.getSampler();
 
-                textureDescriptorSets[id] = descriptorSet;
+            // a reused slot gets a fresh set, the old one may still be bound by a frame in flight
+            if (!LveDescriptorWriter(*textureSetLayout, *globalAllocator)
+                .writeImage(0, &diffuseInfo) //diffuse at binding 0
+                .build(textureDescriptorSets[handle.index])) {
+                throw std::runtime_error("failed to allocate texture descriptor set!");
             }
-        }
+            if (bindlessTextures) {
+                bindlessTextures->writeTexture(handle.index, diffuseInfo); // same slot as the handle
+            }
+            textureDescriptorGenerations[handle.index] = handle.generation;
+        });
 	}
 
     void FirstApp::handleStatusBar() {
         if (statusBar.reloadResources) {
             statusBar.reloadResources = false;
+            steadyFrames = 0; // whatever changes may grow buffers over the next frames
 
             if (statusBar.command == "MSAA1") {
                 lveDevice.setMsaaSampleCount(VK_SAMPLE_COUNT_1_BIT);
@@ -188,34 +327,491 @@ namespace lve {
             if (statusBar.command == "MSAA8") {
                 lveDevice.setMsaaSampleCount(VK_SAMPLE_COUNT_8_BIT);
             }
+            if (statusBar.command == "TEXTURE_BINDING") {
+                // cycle sets -> push descriptors -> bindless, skipping what the GPU can't do
+                using TextureBinding = SimpleRenderSystem::TextureBinding;
+                const TextureBinding order[] = { TextureBinding::PerTextureSets, TextureBinding::PushDescriptors, TextureBinding::Bindless };
+                int current = static_cast<int>(textureBinding);
+                for (int i = 1; i <= 3; i++) {
+                    TextureBinding next = order[(current + i) % 3];
+                    if (isTextureBindingSupported(next)) {
+                        textureBinding = next;
+                        break;
+                    }
+                }
+                const char* names[] = { "per-texture sets", "push descriptors", "bindless" };
+                std::cout << "texture binding: " << names[static_cast<int>(textureBinding)] << std::endl;
+            }
+            if (statusBar.command == "VERTEX_PULLING") {
+                vertexPulling = lveDevice.getFeatureSupport().bufferDeviceAddress && !vertexPulling;
+                if (vertexPulling) {
+                    drawSubmission = SimpleRenderSystem::DrawSubmission::PerObject; // the instanced shader uses regular vertex input
+                }
+                std::cout << "vertex pulling: " << (vertexPulling ? "on" : "off") << std::endl;
+            }
+            if (statusBar.command == "DRAW_SUBMISSION") {
+                // cycle per-object -> instanced -> indirect -> GPU culled, the indirect modes need
+                // non-zero firstInstance in their commands
+                using DrawSubmission = SimpleRenderSystem::DrawSubmission;
+                int next = (static_cast<int>(drawSubmission) + 1) % 4;
+                if (next >= static_cast<int>(DrawSubmission::Indirect) && !lveDevice.getFeatureSupport().drawIndirectFirstInstance) {
+                    next = static_cast<int>(DrawSubmission::PerObject);
+                }
+                drawSubmission = static_cast<DrawSubmission>(next);
+                vertexPulling = vertexPulling && drawSubmission == DrawSubmission::PerObject;
+                std::cout << "draw submission: " << drawSubmissionName(drawSubmission) << std::endl;
+            }
+            if (statusBar.command == "FRUSTUM_CULLING") {
+                statusBar.command = "";
+                frustumCulling = !frustumCulling;
+                simpleRenderSystem->setFrustumCulling(frustumCulling);
+                std::cout << "CPU frustum culling: " << (frustumCulling ? "on" : "off") << std::endl;
+                return; // nothing to rebuild
+            }
+            if (statusBar.command == "OCCLUSION_CULLING") {
+                statusBar.command = "";
+                occlusionCulling = !occlusionCulling;
+                simpleRenderSystem->setOcclusionCulling(occlusionCulling);
+                if (drawSubmission == SimpleRenderSystem::DrawSubmission::GpuCulled) {
+                    std::cout << "GPU occlusion culling: " << (occlusionCulling ? "on" : "off") << std::endl;
+                }
+                else {
+                    std::cout << "CPU occlusion culling: " << (occlusionCulling ? "on" : "off")
+                        << (frustumCulling ? "" : " (needs CPU frustum culling, F11)") << std::endl;
+                }
+                return;
+            }
+            if (statusBar.command == "LOD_SELECTION") {
+                statusBar.command = "";
+                lodSelection = !lodSelection;
+                simpleRenderSystem->setLodSelection(lodSelection);
+                std::cout << "LOD selection: " << (lodSelection ? "on" : "off") << std::endl;
+                return;
+            }
+            if (statusBar.command == "LOD_BIAS_DOWN" || statusBar.command == "LOD_BIAS_UP") {
+                lodBias += statusBar.command == "LOD_BIAS_UP" ? 0.5f : -0.5f;
+                statusBar.command = "";
+                simpleRenderSystem->setLodBias(lodBias);
+                std::cout << "LOD bias: " << lodBias << " (max error " << std::exp2(lodBias) << " px)" << std::endl;
+                return;
+            }
+            if (statusBar.command == "LOD_CROSS_FADE") {
+                lodCrossFade = !lodCrossFade;
+                std::cout << "LOD cross-fade: " << (lodCrossFade ? "on" : "off")
+                    << (drawSubmission == SimpleRenderSystem::DrawSubmission::GpuCulled ? " (not with GPU culling)" : "") << std::endl;
+            }
+            if (statusBar.command == "PARALLEL_RECORDING") {
+                statusBar.command = "";
+                parallelRecording = !parallelRecording;
+                if (parallelRecording && !parallelRecorder) {
+                    parallelRecorder = std::make_unique<LveParallelRecorder>(lveDevice);
+                }
+                std::cout << "parallel recording: " << (parallelRecording ? "on" : "off");
+                if (parallelRecording) {
+                    std::cout << " (" << parallelRecorder->getThreadCount() << " threads"
+                        << (drawSubmission == SimpleRenderSystem::DrawSubmission::PerObject ? ")" : ", per-object draw submission only)");
+                }
+                std::cout << std::endl;
+                return;
+            }
+            if (statusBar.command == "STATIC_COMMAND_BUFFERS") {
+                statusBar.command = "";
+                staticCommandBuffers = !staticCommandBuffers;
+                if (staticCommandBuffers && !parallelRecorder) {
+                    parallelRecorder = std::make_unique<LveParallelRecorder>(lveDevice);
+                }
+                simpleRenderSystem->setStaticCommandBuffers(staticCommandBuffers);
+                std::cout << "static command buffers: " << (staticCommandBuffers ? "on" : "off")
+                    << (staticCommandBuffers && drawSubmission != SimpleRenderSystem::DrawSubmission::PerObject
+                        ? " (per-object draw submission only)" : "") << std::endl;
+                return;
+            }
+            if (statusBar.command == "DEFERRED_SHADING") {
+                deferredShading = !deferredShading;
+                std::cout << "shading: " << (deferredShading ? "tiled deferred" : "forward") << std::endl;
+                // falls through to the rebuild, the G-buffer pipelines need their render pass
+            }
+            if (statusBar.command == "DEPTH_PREPASS") {
+                statusBar.command = "";
+                depthPrepass = !depthPrepass;
+                simpleRenderSystem->setDepthPrepass(depthPrepass);
+                std::cout << "depth prepass: " << (depthPrepass ? "on" : "off") << std::endl;
+                return;
+            }
+            if (statusBar.command == "SHADING_COMPARISON") {
+                statusBar.command = "";
+                if (shadingComparison.running) return;
+                shadingComparison = {};
+                shadingComparison.running = true;
+                shadingComparison.deferredBefore = deferredShading;
+                std::cout << "comparing forward and deferred shading..." << std::endl;
+                if (deferredShading) {
+                    deferredShading = false; // forward first
+                    resetSystem();
+                }
+                return;
+            }
+            if (statusBar.command == "RECORDING_BENCHMARK") {
+                statusBar.command = "";
+                benchmarkParallelRecording();
+                return;
+            }
+            if (statusBar.command == "STATS") {
+                statusBar.command = "";
+                printStats = !printStats;
+                statsWindow = {};
+                return;
+            }
+            if (statusBar.command == "INSTANCE_BENCHMARK") {
+                statusBar.command = "";
+                toggleInstanceBenchmarkScene();
+                return;
+            }
+            if (statusBar.command == "DESCRIPTOR_BENCHMARK") {
+                statusBar.command = "";
+                benchmarkDescriptorUpdates(lveDevice, *resourceManager.getTexture(defaultTexture));
+                return; // nothing to rebuild
+            }
+            if (statusBar.command == "BVH_BENCHMARK") {
+                statusBar.command = "";
+                benchmarkBvh();
+                return;
+            }
+            if (statusBar.command == "OCCLUSION_BENCHMARK") {
+                statusBar.command = "";
+                benchmarkSoftwareOcclusion();
+                return;
+            }
+            if (statusBar.command == "TRANSFORM_BENCHMARK") {
+                statusBar.command = "";
+                benchmarkTransforms();
+                return;
+            }
+            if (statusBar.command == "LIGHT_STRESS") {
+                statusBar.command = "";
+                cycleLightStressScene();
+                return;
+            }
+            if (statusBar.command == "LIGHT_BENCHMARK") {
+                statusBar.command = "";
+                benchmarkLightClusters(lveDevice);
+                return;
+            }
 
 			statusBar.command = "";
             resetSystem();
         }
     }
 
-    void FirstApp::resetSystem() {
-        vkDeviceWaitIdle(lveDevice.device());
+    // 10k copies of the same model on a grid, to compare the draw submission modes (F3)
+    void FirstApp::toggleInstanceBenchmarkScene() {
+        if (!benchmarkObjectIds.empty()) {
+            for (auto id : benchmarkObjectIds) {
+                gameObjects.erase(id);
+            }
+            benchmarkObjectIds.clear();
+            simpleRenderSystem->invalidateStaticScene(); // its buckets point at the removed meshes
+            std::cout << "instance benchmark scene removed" << std::endl;
+            return;
+        }
 
-        lveRenderer.recreateSwapChain();
+        constexpr int GRID_SIZE = 100;
+        constexpr float SPACING = 0.5f;
+        std::shared_ptr<LveModel> model = LveModel::createModelFromFile(lveDevice, resourceManager, "Models/smooth_vase.obj");
+        for (int z = 0; z < GRID_SIZE; z++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                auto obj = LveGameObject::createGameObject();
+                obj.model = model;
+                obj.transform.translation = { (x - GRID_SIZE / 2) * SPACING, 0.f, (z - GRID_SIZE / 2) * SPACING };
+                obj.transform.scale = glm::vec3{ 0.5f };
+                benchmarkObjectIds.push_back(obj.getId());
+                gameObjects.emplace(obj.getId(), std::move(obj));
+            }
+        }
+        createDescriptorSets(); // assigns the default texture to the new meshes
+        simpleRenderSystem->invalidateStaticScene();
+
+        printStats = true;
+        statsWindow = {};
+        std::cout << "instance benchmark scene: " << benchmarkObjectIds.size() << " objects, draw submission "
+            << drawSubmissionName(drawSubmission) << std::endl;
+    }
 
-        uint32_t totalMeshCount = 0;
+    // Skybox, the queued draws split in ranges, then the lights, each job into its own secondary
+    // command buffer. The queue is built on this thread, the ranges are recorded on the workers.
+    void FirstApp::recordSceneParallel(LveParallelRecorder& recorder, FrameInfo& frameInfo) {
+        // a few ranges per thread so uneven ones balance out, but not so short that the cost of
+        // a command buffer and the rebinds at its start show
+        constexpr uint32_t RANGES_PER_THREAD = 4;
+        constexpr uint32_t MIN_DRAWS_PER_RANGE = 256;
+
+        const uint32_t drawCount = simpleRenderSystem->queueGameObjects(frameInfo);
+        const uint32_t rangeCount = std::min(
+            recorder.getThreadCount() * RANGES_PER_THREAD, (drawCount + MIN_DRAWS_PER_RANGE - 1) / MIN_DRAWS_PER_RANGE);
+        const uint32_t passCount = simpleRenderSystem->usesDepthPrepass() ? 2 : 1; // depth-only ranges go first
+        const uint32_t jobCount = rangeCount * passCount + 2;
+
+        recordingStats.assign(jobCount, RenderStats{});
+        recorder.record(jobCount, [&](uint32_t job, VkCommandBuffer jobCommandBuffer) {
+            FrameInfo jobInfo = frameInfo.withCommandBuffer(jobCommandBuffer, recordingStats[job]);
+            if (job == 0) {
+                skyboxRenderSystem->render(jobInfo);
+            }
+            else if (job == jobCount - 1) {
+                lightSystem->render(jobInfo);
+            }
+            else {
+                const uint32_t range = (job - 1) % rangeCount;
+                const bool depthOnly = passCount == 2 && job - 1 < rangeCount;
+                uint32_t first = static_cast<uint32_t>(uint64_t{ drawCount } * range / rangeCount);
+                uint32_t last = static_cast<uint32_t>(uint64_t{ drawCount } * (range + 1) / rangeCount);
+                simpleRenderSystem->recordGameObjects(jobInfo, first, last - first, depthOnly);
+            }
+        });
+        for (const auto& stats : recordingStats) {
+            frameInfo.renderStats.accumulate(stats);
+        }
+    }
+
+    // Random small point lights without billboards spread over the scene's bounds, each press
+    // goes to the next count: 1k, 2k, 5k, 10k, then none
+    void FirstApp::cycleLightStressScene() {
+        constexpr uint32_t LIGHT_COUNTS[] = { 0, 1000, 2000, 5000, 10000 };
+        const uint32_t current = static_cast<uint32_t>(stressLightIds.size());
+        uint32_t next = 0;
+        for (uint32_t i = 0; i + 1 < std::size(LIGHT_COUNTS); i++) {
+            if (LIGHT_COUNTS[i] == current) next = LIGHT_COUNTS[i + 1];
+        }
+
+        for (auto id : stressLightIds) {
+            gameObjects.erase(id);
+        }
+        stressLightIds.clear();
+        if (next == 0) {
+            std::cout << "light stress scene removed" << std::endl;
+            return;
+        }
+
+        glm::vec3 sceneMin{ -20.f, -10.f, -20.f };
+        glm::vec3 sceneMax{ 20.f, 0.f, 20.f };
+        bool first = true;
         for (auto& kv : gameObjects) {
             auto& obj = kv.second;
-            totalMeshCount += obj.getMeshCount();
+            if (obj.model == nullptr) continue;
+            const glm::mat4 modelMatrix = obj.transform.mat4();
+            glm::vec3 a{ modelMatrix * glm::vec4{ obj.model->boundsMin, 1.f } };
+            glm::vec3 b{ modelMatrix * glm::vec4{ obj.model->boundsMax, 1.f } };
+            sceneMin = first ? glm::min(a, b) : glm::min(sceneMin, glm::min(a, b));
+            sceneMax = first ? glm::max(a, b) : glm::max(sceneMax, glm::max(a, b));
+            first = false;
         }
 
-        globalPool = LveDescriptorPool::Builder(lveDevice)
-            .setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT + totalMeshCount)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, totalMeshCount)
-            .build();
-        createSystemsAndDescriptorLayouts();
-        createDescriptorSets();
+        std::mt19937 rng{ 7 };
+        std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+        std::uniform_real_distribution<float> range{ 1.f, 4.f };
+        stressLightIds.reserve(next);
+        for (uint32_t i = 0; i < next; i++) {
+            glm::vec3 color{ unit(rng), unit(rng), unit(rng) };
+            auto lightObj = LveGameObject::makeLight(1.f, 0.f, color / std::max(std::max(color.r, color.g), std::max(color.b, 0.01f)), range(rng));
+            lightObj.transform.translation = glm::mix(sceneMin, sceneMax, glm::vec3{ unit(rng), unit(rng), unit(rng) });
+            stressLightIds.push_back(lightObj.getId());
+            gameObjects.emplace(lightObj.getId(), std::move(lightObj));
+        }
+        std::cout << "light stress scene: " << next << " point lights" << std::endl;
+    }
+
+    // Records the instance benchmark scene (F9) without culling, with 1, 2, 4... threads up to the
+    // hardware count, into secondary command buffers that are never submitted
+    void FirstApp::benchmarkParallelRecording() {
+        if (!simpleRenderSystem->supportsParallelRecording()) {
+            std::cout << "recording benchmark: needs per-object draw submission (F3)" << std::endl;
+            return;
+        }
+        using Clock = std::chrono::high_resolution_clock;
+        constexpr int ITERATIONS = 20;
+        vkDeviceWaitIdle(lveDevice.device()); // the queue rewrites frame 0's object buffer
+
+        const bool addedScene = benchmarkObjectIds.empty();
+        const bool wasPrintingStats = printStats;
+        if (addedScene) {
+            toggleInstanceBenchmarkScene();
+        }
+        transformStore.sync(gameObjects);
+        simpleRenderSystem->setFrustumCulling(false); // every object gets drawn
+
+        LveCamera camera{};
+        camera.setPerspectiveProjection(glm::radians(60.f), lveRenderer.getAspectRatio(), 0.1f, 100.f);
+        RenderStats stats{};
+        FrameInfo frameInfo{
+            0,
+            0.f,
+            VK_NULL_HANDLE, // only the secondaries are recorded
+            camera,
+            lveRenderer.getExtent(),
+            globalDescriptorSets[0],
+            *frameAllocators[0],
+            *frameMemory[0],
+            textureDescriptorSets,
+            textureBinding == SimpleRenderSystem::TextureBinding::Bindless
+                ? bindlessTextures->getDescriptorSet()
+                : VK_NULL_HANDLE,
+            resourceManager,
+            gameObjects,
+            transformStore,
+            stats
+        };
+
+        const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        double singleThreadMs = 0.0;
+        for (uint32_t threads = 1; ; threads = std::min(threads * 2, hardwareThreads)) {
+            LveParallelRecorder recorder{ lveDevice, threads };
+            double queueMs = 0.0;
+            double recordMs = 0.0;
+            for (int i = -1; i < ITERATIONS; i++) { // the first round allocates the command buffers
+                stats = {};
+                auto start = Clock::now();
+                recorder.beginFrame(0, lveRenderer.getSwapChainRenderPass(), VK_NULL_HANDLE, lveRenderer.getExtent());
+                recordSceneParallel(recorder, frameInfo);
+                if (i >= 0) {
+                    recordMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                }
+            }
+            // the queue is built on one thread whatever the count, time it apart
+            for (int i = 0; i < ITERATIONS; i++) {
+                auto start = Clock::now();
+                simpleRenderSystem->queueGameObjects(frameInfo);
+                queueMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            }
+            recordMs /= ITERATIONS;
+            queueMs /= ITERATIONS;
+            if (threads == 1) {
+                singleThreadMs = recordMs;
+                std::cout << "Parallel recording benchmark (" << stats.drawCalls << " draws, " << ITERATIONS
+                    << " iterations):" << std::endl;
+            }
+            std::cout << "	" << threads << (threads == 1 ? " thread" : " threads")
+                << ": " << recordMs << " ms per frame (queue " << queueMs << " ms), speedup "
+                << singleThreadMs / recordMs << "x" << std::endl;
+
+            if (threads == hardwareThreads) break;
+        }
+
+        simpleRenderSystem->setFrustumCulling(frustumCulling);
+        if (addedScene) {
+            toggleInstanceBenchmarkScene();
+        }
+        printStats = wasPrintingStats;
+    }
+
+    // Debug builds only (the count stays 0 otherwise). Once nothing was rebuilt for a few frames
+    // every buffer and container has grown to fit, so heap allocations left are per-frame ones.
+    // Reported once until the next change, from the start of recording to present.
+    void FirstApp::checkFrameAllocations(uint64_t allocations, bool steady) {
+        constexpr uint32_t WARMUP_FRAMES = 8;
+        if (!steady) {
+            steadyFrames = 0;
+            return;
+        }
+        if (steadyFrames < WARMUP_FRAMES) {
+            steadyFrames++;
+            frameAllocationsReported = false;
+            return;
+        }
+        if (allocations > 0 && !frameAllocationsReported) {
+            std::cout << "[debug] frame made " << allocations << " heap allocations" << std::endl;
+            frameAllocationsReported = true;
+        }
+    }
+
+    void FirstApp::accumulateStats(float frameTime, double cpuMilliseconds) {
+        if (!printStats) return;
+
+        statsWindow.elapsed += frameTime;
+        statsWindow.frames++;
+        statsWindow.cpuMilliseconds += cpuMilliseconds;
+        statsWindow.total.accumulate(renderStats);
+        if (statsWindow.elapsed < 1.f) return;
+
+        float frames = static_cast<float>(statsWindow.frames);
+        std::cout << "frame " << statsWindow.elapsed * 1000.f / frames << " ms"
+            << " | cpu " << statsWindow.cpuMilliseconds / frames << " ms"
+            << " | draws " << statsWindow.total.drawCalls / frames
+            << " (prepass " << statsWindow.total.prepassDrawCalls / frames << ")"
+            << " | instances " << statsWindow.total.instances / frames
+            << " | culled " << statsWindow.total.culled / frames
+            << " | occluded " << statsWindow.total.occluded / frames
+            << " (" << statsWindow.total.occludedTriangles / frames << " tris)"
+            << " | binds: pipeline " << statsWindow.total.pipelineBinds / frames
+            << ", descriptor " << statsWindow.total.descriptorBinds / frames
+            << ", vertex " << statsWindow.total.vertexBufferBinds / frames
+            << " (skipped " << statsWindow.total.redundantBindsSkipped / frames << ")"
+            << " | lights " << statsWindow.total.lights / frames
+            << " (" << statsWindow.total.lightClusterEntries / frames << " cluster entries)" << std::endl;
+        statsWindow = {};
+    }
+
+    // Runs over the frames after SHADING_COMPARISON (key 7): a warm-up and the measured frames with
+    // forward shading, then the same with deferred. Frame time is wall clock from one frame to the
+    // next, so it shows the GPU's cost as long as the present mode doesn't cap the frame rate.
+    void FirstApp::updateShadingComparison(float frameTime, double cpuMilliseconds) {
+        constexpr uint32_t WARMUP_FRAMES = 30; // past the rebuild and its first frames
+        constexpr uint32_t MEASURED_FRAMES = 300;
+        ShadingComparison& comparison = shadingComparison;
+        if (!comparison.running) return;
+        if (++comparison.frames <= WARMUP_FRAMES) return;
+        comparison.elapsed += frameTime;
+        comparison.cpuMilliseconds += cpuMilliseconds;
+        if (comparison.frames < WARMUP_FRAMES + MEASURED_FRAMES) return;
+
+        const float frameMilliseconds = comparison.elapsed * 1000.f / MEASURED_FRAMES;
+        const double frameCpuMilliseconds = comparison.cpuMilliseconds / MEASURED_FRAMES;
+        if (!comparison.measuringDeferred) {
+            comparison.forwardMilliseconds = frameMilliseconds;
+            comparison.forwardCpuMilliseconds = frameCpuMilliseconds;
+            comparison.measuringDeferred = true;
+            comparison.frames = 0;
+            comparison.elapsed = 0.f;
+            comparison.cpuMilliseconds = 0.0;
+            deferredShading = true;
+            steadyFrames = 0;
+            resetSystem();
+            return;
+        }
+
+        std::cout << "shading comparison over " << MEASURED_FRAMES << " frames, "
+            << renderStats.lights << " lights:" << std::endl;
+        std::cout << "\tforward  " << comparison.forwardMilliseconds << " ms/frame (cpu "
+            << comparison.forwardCpuMilliseconds << " ms)" << std::endl;
+        std::cout << "\tdeferred " << frameMilliseconds << " ms/frame (cpu "
+            << frameCpuMilliseconds << " ms), "
+            << comparison.forwardMilliseconds / frameMilliseconds << "x" << std::endl;
+        comparison.running = false;
+        if (deferredShading != comparison.deferredBefore) {
+            deferredShading = comparison.deferredBefore;
+            steadyFrames = 0;
+            resetSystem();
+        }
+    }
+
+    bool FirstApp::isTextureBindingSupported(SimpleRenderSystem::TextureBinding binding) const {
+        switch (binding) {
+        case SimpleRenderSystem::TextureBinding::PushDescriptors: return pushTextureSetLayout != nullptr;
+        case SimpleRenderSystem::TextureBinding::Bindless: return bindlessTextures != nullptr;
+        default: return true;
+        }
+    }
+
+    void FirstApp::resetSystem() {
+        // Old pools, buffers and pipelines are released through the device deletion queue once
+        // the frames still using them have finished, so there is no need to drain the GPU here
+        lveRenderer.recreateSwapChain();
 
+        // Descriptor sets don't depend on the render pass, only the pipelines have to be rebuilt
+        createSystems();
+        createDescriptorSets();
     }
 
-    void FirstApp::createSystemsAndDescriptorLayouts() {
+    void FirstApp::createDescriptorLayoutsAndGlobalSets() {
         uboBuffers = std::vector<std::unique_ptr<LveBuffer>>(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < uboBuffers.size(); i++) {
             uboBuffers[i] = std::make_unique<LveBuffer>(
@@ -228,10 +824,13 @@ namespace lve {
         }
 
         // - GLOBAL (UBO) layout (set=0) -
-        globalSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
-            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+        globalSetLayout = &LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT) // compute: tiled lighting
 			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT) //Skybox cubemap
-            .build();
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT) // point lights
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT) // light cluster ranges
+            .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT) // light indices of the clusters
+            .build(descriptorLayoutCache);
 
         globalDescriptorSets = std::vector<VkDescriptorSet>(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < globalDescriptorSets.size(); i++) {
@@ -242,29 +841,72 @@ namespace lve {
             skyboxInfo.imageView = skyboxCubemap->getImageView();
             skyboxInfo.sampler = skyboxCubemap->getSampler();
 
-            LveDescriptorWriter(*globalSetLayout, *globalPool)
+            // fixed size, refilled every frame, so the sets never have to be written again
+            auto lightInfos = lightClusters.descriptorInfos(i);
+
+            LveDescriptorWriter(*globalSetLayout, *globalAllocator)
                 .writeBuffer(0, &bufferInfo)
                 .writeImage(1, &skyboxInfo) // Skybox cubemap at binding 1
+                .writeBuffer(2, &lightInfos[0])
+                .writeBuffer(3, &lightInfos[1])
+                .writeBuffer(4, &lightInfos[2])
                 .build(globalDescriptorSets[i]);
         }
 
         // - TEXTURE layout (set=1) -
-        textureSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+        textureSetLayout = &LveDescriptorSetLayout::Builder(lveDevice)
             .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT) //for now only 1 texture type
-            .build();
+            .build(descriptorLayoutCache);
 		// NOTE: will write to the texture set when creating the actual textures
 
+        // same binding, but pushed per draw instead of allocated (not cacheable, it carries a create flag)
+        if (lveDevice.getFeatureSupport().pushDescriptors) {
+            pushTextureSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+                .setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR)
+                .build();
+        }
+    }
+
+    void FirstApp::createSystems() {
 		// - Systems -
+        VkDescriptorSetLayout textureLayout = textureSetLayout->getDescriptorSetLayout();
+        if (textureBinding == SimpleRenderSystem::TextureBinding::PushDescriptors) {
+            textureLayout = pushTextureSetLayout->getDescriptorSetLayout();
+        }
+        else if (textureBinding == SimpleRenderSystem::TextureBinding::Bindless) {
+            textureLayout = bindlessTextures->getSetLayout().getDescriptorSetLayout();
+        }
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts = {
             globalSetLayout->getDescriptorSetLayout(),
-            textureSetLayout->getDescriptorSetLayout()
+            textureLayout
         };
 
         simpleRenderSystem = std::make_unique<SimpleRenderSystem>(
             lveDevice,
             lveRenderer.getSwapChainRenderPass(),
-            descriptorSetLayouts
+            descriptorSetLayouts,
+            textureBinding,
+            vertexPulling,
+            drawSubmission,
+            lodCrossFade
         );
+        simpleRenderSystem->setFrustumCulling(frustumCulling);
+        simpleRenderSystem->setOcclusionCulling(occlusionCulling);
+        simpleRenderSystem->setLodSelection(lodSelection);
+        simpleRenderSystem->setLodBias(lodBias);
+        simpleRenderSystem->setStaticCommandBuffers(staticCommandBuffers);
+        simpleRenderSystem->setDepthPrepass(depthPrepass);
+
+        deferredRenderSystem.reset();
+        if (deferredShading) {
+            deferredRenderSystem = std::make_unique<DeferredRenderSystem>(
+                lveDevice,
+                lveRenderer.getSwapChainRenderPass(),
+                globalSetLayout->getDescriptorSetLayout()
+            );
+            simpleRenderSystem->setDeferred(deferredRenderSystem->getGBufferRenderPass());
+        }
 
         lightSystem = std::make_unique<LightSystem>(
             lveDevice,
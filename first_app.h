@@ -5,10 +5,17 @@
 #include "lve_renderer.h"
 #include "lve_window.h"
 #include "lve_descriptors.h"
+#include "lve_linear_allocator.h"
+#include "lve_parallel_recorder.h"
+#include "lve_transform_store.h"
+#include "lve_static_batcher.h"
+#include "lve_light_clusters.h"
+#include "lve_bindless_textures.h"
 #include "Systems/simple_render_system.h"
+#include "Systems/deferred_render_system.h"
 #include "Systems/light_system.h"
 #include "Systems/skybox_render_system.h"
-#include "lve_texture.h"
+#include "lve_resource_manager.h"
 #include "lve_cubemap.h"
 #include "lve_utils.h"
 
@@ -35,26 +42,88 @@ namespace lve {
 		void loadGameObjects();
 		void handleStatusBar();
 		void resetSystem();
-		void createSystemsAndDescriptorLayouts();
+		void createDescriptorLayoutsAndGlobalSets();
+		void createSystems();
 		void createDescriptorSets();
+		bool isTextureBindingSupported(SimpleRenderSystem::TextureBinding binding) const;
+		void toggleInstanceBenchmarkScene();
+		void cycleLightStressScene();
+		void recordSceneParallel(LveParallelRecorder& recorder, FrameInfo& frameInfo);
+		void benchmarkParallelRecording();
+		void accumulateStats(float frameTime, double cpuMilliseconds);
+		void updateShadingComparison(float frameTime, double cpuMilliseconds);
+		void checkFrameAllocations(uint64_t allocations, bool steady);
 
 		LveWindow lveWindow{ WIDTH, HEIGHT, "Vulkan Engine" };
 		LveDevice lveDevice{ lveWindow };
 		LveRenderer lveRenderer{ lveWindow, lveDevice };
 
 		//note: order of declarations matters
-		std::unique_ptr<LveDescriptorPool> globalPool{};
+		LveResourceManager resourceManager{ lveDevice };
+		LveDescriptorLayoutCache descriptorLayoutCache{ lveDevice };
+		LveLightClusters lightClusters{ lveDevice }; // point light buffers of the global sets
+		std::unique_ptr<LveDescriptorAllocator> globalAllocator{};
+		std::vector<std::unique_ptr<LveDescriptorAllocator>> frameAllocators; // one per frame in flight
+		std::vector<std::unique_ptr<LveLinearAllocator>> frameMemory; // one per frame in flight
 		LveGameObject::Map gameObjects;
-		std::shared_ptr<LveTexture> defaultTexture; //fallback texture
+		LveTransformStore transformStore; // world and normal matrices of gameObjects
+		TextureHandle defaultTexture{}; //fallback texture
 		std::shared_ptr<LveCubemap> skyboxCubemap; //skybox cubemap
 		StatusBar statusBar;
 
 		std::vector<std::unique_ptr<LveBuffer>> uboBuffers;
 		std::vector<VkDescriptorSet> globalDescriptorSets;
-		std::unique_ptr<LveDescriptorSetLayout> globalSetLayout;
-		std::unique_ptr<LveDescriptorSetLayout> textureSetLayout;
-		std::unordered_map<id_t, VkDescriptorSet> textureDescriptorSets;
+		LveDescriptorSetLayout* globalSetLayout = nullptr; // owned by descriptorLayoutCache
+		LveDescriptorSetLayout* textureSetLayout = nullptr;
+		std::vector<VkDescriptorSet> textureDescriptorSets; // one per texture, indexed by TextureHandle::index
+		std::vector<uint32_t> textureDescriptorGenerations; // generation each set was written for
+		std::unique_ptr<LveDescriptorSetLayout> pushTextureSetLayout{}; // null without push descriptors
+		std::unique_ptr<LveBindlessTextureTable> bindlessTextures{}; // null when descriptor indexing is missing
+		SimpleRenderSystem::TextureBinding textureBinding = SimpleRenderSystem::TextureBinding::PerTextureSets;
+		bool vertexPulling = false;
+		SimpleRenderSystem::DrawSubmission drawSubmission = SimpleRenderSystem::DrawSubmission::PerObject;
+		bool frustumCulling = true;
+		bool occlusionCulling = false; // GpuCulled only
+		bool lodSelection = true;
+		float lodBias = 0.f; // powers of two of the allowed screen space error
+		bool lodCrossFade = false;
+		bool parallelRecording = false; // PerObject only, the other modes record few commands
+		bool staticCommandBuffers = false; // PerObject only, takes precedence over parallelRecording
+		bool depthPrepass = false;
+		bool deferredShading = false; // takes precedence over static command buffers and parallel recording
+		std::unique_ptr<LveParallelRecorder> parallelRecorder{}; // created when either is first turned on
+		std::vector<RenderStats> recordingStats; // per job of recordSceneParallel
+
+		// Render stats of the current frame, and a ~1s window of them printed while printStats is on
+		struct StatsWindow {
+			float elapsed = 0.f;
+			uint32_t frames = 0;
+			double cpuMilliseconds = 0.0; // recording + submit, excludes the fence wait
+			RenderStats total{};
+		};
+		RenderStats renderStats{};
+		StatsWindow statsWindow{};
+		bool printStats = false;
+
+		// Forward against deferred shading in the current scene, one after the other over the
+		// frames after the command, then the mode it started with is restored
+		struct ShadingComparison {
+			bool running = false;
+			bool deferredBefore = false;
+			bool measuringDeferred = false;
+			uint32_t frames = 0; // of the current mode, warm-up included
+			float elapsed = 0.f; // of its measured frames
+			double cpuMilliseconds = 0.0;
+			float forwardMilliseconds = 0.f;
+			double forwardCpuMilliseconds = 0.0;
+		};
+		ShadingComparison shadingComparison{};
+		uint32_t steadyFrames = 0; // frames since anything was rebuilt, for checkFrameAllocations
+		bool frameAllocationsReported = false;
+		std::vector<LveGameObject::id_t> benchmarkObjectIds;
+		std::vector<LveGameObject::id_t> stressLightIds; // random point lights of cycleLightStressScene
 		std::unique_ptr<SimpleRenderSystem> simpleRenderSystem{};
+		std::unique_ptr<DeferredRenderSystem> deferredRenderSystem{}; // null unless deferredShading
 		std::unique_ptr<LightSystem> lightSystem{};
 		std::unique_ptr<SkyboxRenderSystem> skyboxRenderSystem{};
 	};
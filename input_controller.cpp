@@ -89,6 +89,98 @@ namespace lve {
             statusBar->reloadResources = true;
             statusBar->command = "MSAA8";
         }
+        if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "TEXTURE_BINDING";
+        }
+        if (key == GLFW_KEY_F6 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "DESCRIPTOR_BENCHMARK";
+        }
+        if (key == GLFW_KEY_F7 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "VERTEX_PULLING";
+        }
+        if (key == GLFW_KEY_F3 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "DRAW_SUBMISSION";
+        }
+        if (key == GLFW_KEY_F9 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "INSTANCE_BENCHMARK";
+        }
+        if (key == GLFW_KEY_F10 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "STATS";
+        }
+        if (key == GLFW_KEY_F11 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "FRUSTUM_CULLING";
+        }
+        if (key == GLFW_KEY_F12 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "BVH_BENCHMARK";
+        }
+        if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "OCCLUSION_CULLING";
+        }
+        if (key == GLFW_KEY_1 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "OCCLUSION_BENCHMARK";
+        }
+        if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "LOD_SELECTION";
+        }
+        if (key == GLFW_KEY_LEFT_BRACKET && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "LOD_BIAS_DOWN";
+        }
+        if (key == GLFW_KEY_RIGHT_BRACKET && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "LOD_BIAS_UP";
+        }
+        if (key == GLFW_KEY_F && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "LOD_CROSS_FADE";
+        }
+        if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "PARALLEL_RECORDING";
+        }
+        if (key == GLFW_KEY_2 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "RECORDING_BENCHMARK";
+        }
+        if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "STATIC_COMMAND_BUFFERS";
+        }
+        if (key == GLFW_KEY_3 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "TRANSFORM_BENCHMARK";
+        }
+        if (key == GLFW_KEY_Z && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "DEPTH_PREPASS";
+        }
+        if (key == GLFW_KEY_4 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "LIGHT_STRESS";
+        }
+        if (key == GLFW_KEY_5 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "LIGHT_BENCHMARK";
+        }
+        if (key == GLFW_KEY_6 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "DEFERRED_SHADING";
+        }
+        if (key == GLFW_KEY_7 && action == GLFW_PRESS) {
+            statusBar->reloadResources = true;
+            statusBar->command = "SHADING_COMPARISON";
+        }
     }
 
     void InputController::mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
@@ -0,0 +1,581 @@
+#include "lve_benchmarks.h"
+
+#include "lve_descriptors.h"
+#include "lve_bvh.h"
+#include "lve_camera.h"
+#include "lve_frustum.h"
+#include "lve_light_clusters.h"
+#include "lve_occlusion.h"
+#include "lve_transform_store.h"
+
+//libs
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace lve {
+
+    namespace {
+
+        using Clock = std::chrono::high_resolution_clock;
+
+        double elapsedMicroseconds(Clock::time_point start) {
+            return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        }
+
+        void printResult(const char* name, double microseconds, uint32_t iterations) {
+            std::cout << "\t" << name << ": " << microseconds << " us ("
+                << microseconds * 1000.0 / iterations << " ns/update)" << std::endl;
+        }
+
+        void printQueries(const char* name, double bvhMicroseconds, double linearMicroseconds, uint32_t queries, size_t hits) {
+            std::cout << "\t" << name << ": bvh " << bvhMicroseconds / queries << " us/query, linear "
+                << linearMicroseconds / queries << " us/query (" << hits / queries << " hits/query)" << std::endl;
+        }
+
+        // Unit cube around the origin with front faces facing out
+        LveOccluder makeBoxOccluder() {
+            LveOccluder box;
+            for (int i = 0; i < 8; i++) {
+                box.positions.push_back({ (i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f });
+            }
+            const uint32_t faces[6][4] = { { 0, 2, 6, 4 }, { 1, 5, 7, 3 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 6, 7, 5 } };
+            for (const auto& face : faces) {
+                glm::vec3 outward = box.positions[face[0]] + box.positions[face[2]];
+                glm::vec3 normal = glm::cross(box.positions[face[1]] - box.positions[face[0]], box.positions[face[2]] - box.positions[face[0]]);
+                // clockwise on screen with -Y up means the winding normal points away from the viewer
+                bool flip = glm::dot(normal, outward) > 0.f;
+                uint32_t a = face[0], b = flip ? face[3] : face[1], c = face[2], d = flip ? face[1] : face[3];
+                box.indices.insert(box.indices.end(), { a, b, c, a, c, d });
+            }
+            return box;
+        }
+
+    }  // namespace
+
+    void benchmarkDescriptorUpdates(LveDevice& device, const LveTexture& texture) {
+        constexpr uint32_t ITERATIONS = 10000;
+
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = texture.getImageView();
+        imageInfo.sampler = texture.getSampler();
+
+        auto setLayout = LveDescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .build();
+        auto allocator = LveDescriptorAllocator::Builder(device)
+            .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.f)
+            .build();
+
+        VkDescriptorSet set;
+        if (!allocator->allocateDescriptor(setLayout->getDescriptorSetLayout(), set)) {
+            throw std::runtime_error("failed to allocate benchmark descriptor set!");
+        }
+
+        std::cout << "descriptor update benchmark (" << ITERATIONS << " updates):" << std::endl;
+
+        // writer, rebuilds the VkWriteDescriptorSet vector every time
+        auto start = Clock::now();
+        for (uint32_t i = 0; i < ITERATIONS; i++) {
+            LveDescriptorWriter(*setLayout, *allocator)
+                .writeImage(0, &imageInfo)
+                .overwrite(set);
+        }
+        printResult("LveDescriptorWriter::overwrite", elapsedMicroseconds(start), ITERATIONS);
+
+        // what a fresh set per draw used to cost
+        start = Clock::now();
+        for (uint32_t i = 0; i < ITERATIONS; i++) {
+            VkDescriptorSet transientSet;
+            LveDescriptorWriter(*setLayout, *allocator)
+                .writeImage(0, &imageInfo)
+                .build(transientSet);
+        }
+        printResult("allocate + write", elapsedMicroseconds(start), ITERATIONS);
+        allocator->resetPools();
+
+        if (!device.getFeatureSupport().descriptorUpdateTemplates) {
+            std::cout << "\tupdate templates not supported" << std::endl;
+            return;
+        }
+
+        if (!allocator->allocateDescriptor(setLayout->getDescriptorSetLayout(), set)) {
+            throw std::runtime_error("failed to allocate benchmark descriptor set!");
+        }
+        auto updateTemplate = LveDescriptorUpdateTemplate::Builder(device)
+            .addEntry(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0)
+            .setDescriptorSetLayout(setLayout->getDescriptorSetLayout())
+            .build();
+
+        start = Clock::now();
+        for (uint32_t i = 0; i < ITERATIONS; i++) {
+            updateTemplate->update(set, &imageInfo);
+        }
+        printResult("vkUpdateDescriptorSetWithTemplate", elapsedMicroseconds(start), ITERATIONS);
+
+        if (!device.getFeatureSupport().pushDescriptors) {
+            std::cout << "\tpush descriptors not supported" << std::endl;
+            return;
+        }
+
+        auto pushSetLayout = LveDescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR)
+            .build();
+        VkDescriptorSetLayout pushLayout = pushSetLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &pushLayout;
+        VkPipelineLayout pipelineLayout;
+        if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        auto pushTemplate = LveDescriptorUpdateTemplate::Builder(device)
+            .addEntry(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0)
+            .setPushDescriptors(pipelineLayout, 0)
+            .build();
+
+        // recorded only, the command buffer is never submitted
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = device.getCommandPool();
+        allocInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer;
+        vkAllocateCommandBuffers(device.device(), &allocInfo, &commandBuffer);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+        start = Clock::now();
+        for (uint32_t i = 0; i < ITERATIONS; i++) {
+            pushTemplate->push(commandBuffer, &imageInfo);
+        }
+        printResult("vkCmdPushDescriptorSetWithTemplateKHR", elapsedMicroseconds(start), ITERATIONS);
+
+        vkEndCommandBuffer(commandBuffer);
+        vkFreeCommandBuffers(device.device(), device.getCommandPool(), 1, &commandBuffer);
+        pushTemplate.reset();
+        vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+    }
+
+    void benchmarkBvh() {
+        constexpr uint32_t OBJECT_COUNT = 100000;
+        constexpr uint32_t QUERY_COUNT = 1000;
+        constexpr uint32_t UPDATE_COUNT = 1000;
+        constexpr float WORLD_SIZE = 2000.f;
+        constexpr float QUERY_RADIUS = 25.f;
+
+        // city-like layout: spread on the ground plane, a limited height range
+        std::mt19937 rng{ 1337 };
+        std::uniform_real_distribution<float> ground{ -WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f };
+        std::uniform_real_distribution<float> height{ -50.f, 0.f }; // -Y is up
+        std::uniform_real_distribution<float> size{ 0.5f, 5.f };
+        std::uniform_real_distribution<float> unit{ -1.f, 1.f };
+
+        std::vector<LveAabb> boxes(OBJECT_COUNT);
+        for (auto& box : boxes) {
+            glm::vec3 center{ ground(rng), height(rng), ground(rng) };
+            glm::vec3 extent{ size(rng), size(rng), size(rng) };
+            box = { center - extent, center + extent };
+        }
+
+        std::cout << "BVH benchmark (" << OBJECT_COUNT << " objects, " << QUERY_COUNT << " queries each):" << std::endl;
+
+        LveBvh bvh;
+        auto start = Clock::now();
+        bvh.build(boxes);
+        std::cout << "\tbinned SAH build: " << elapsedMicroseconds(start) / 1000.0 << " ms, "
+            << bvh.getNodeCount() << " nodes, SAH cost " << bvh.getCost() << std::endl;
+
+        std::stringstream stream;
+        start = Clock::now();
+        bvh.serialize(stream);
+        double saveMicroseconds = elapsedMicroseconds(start);
+        LveBvh loaded;
+        start = Clock::now();
+        bool loadedOk = loaded.deserialize(stream);
+        std::cout << "\tsave " << saveMicroseconds / 1000.0 << " ms, load " << elapsedMicroseconds(start) / 1000.0
+            << " ms, " << stream.str().size() / 1024 << " KiB" << (loadedOk ? "" : " (load FAILED)") << std::endl;
+
+        // --- Frustum queries from random viewpoints, linear scan is the SIMD box test ---
+        std::vector<std::array<glm::vec4, 6>> frusta(QUERY_COUNT);
+        for (auto& planes : frusta) {
+            LveCamera camera{};
+            camera.setPerspectiveProjection(glm::radians(60.f), 16.f / 9.f, 0.1f, 300.f);
+            camera.setViewYXZ({ ground(rng), -10.f, ground(rng) }, { 0.f, unit(rng) * glm::pi<float>(), 0.f });
+            planes = camera.getFrustumPlanes();
+        }
+        LveBoundsSoA soa;
+        soa.reserve(OBJECT_COUNT);
+        for (const auto& box : boxes) {
+            soa.push(box.center(), (box.max - box.min) * 0.5f);
+        }
+
+        std::vector<uint32_t> results;
+        size_t hits = 0;
+        start = Clock::now();
+        for (const auto& planes : frusta) {
+            results.clear();
+            bvh.queryFrustum(planes, results);
+            hits += results.size();
+        }
+        double bvhMicroseconds = elapsedMicroseconds(start);
+        std::vector<uint8_t> visible;
+        start = Clock::now();
+        for (const auto& planes : frusta) {
+            cullBoxes(planes, soa, visible);
+        }
+        printQueries("frustum", bvhMicroseconds, elapsedMicroseconds(start), QUERY_COUNT, hits);
+
+        // --- Sphere and box queries (light volumes, triggers) ---
+        std::vector<glm::vec3> centers(QUERY_COUNT);
+        for (auto& center : centers) {
+            center = { ground(rng), height(rng), ground(rng) };
+        }
+
+        hits = 0;
+        start = Clock::now();
+        for (const auto& center : centers) {
+            results.clear();
+            bvh.querySphere(center, QUERY_RADIUS, results);
+            hits += results.size();
+        }
+        bvhMicroseconds = elapsedMicroseconds(start);
+        size_t linearHits = 0;
+        start = Clock::now();
+        for (const auto& center : centers) {
+            for (const auto& box : boxes) {
+                glm::vec3 offset = glm::clamp(center, box.min, box.max) - center;
+                linearHits += glm::dot(offset, offset) <= QUERY_RADIUS * QUERY_RADIUS ? 1 : 0;
+            }
+        }
+        printQueries("sphere", bvhMicroseconds, elapsedMicroseconds(start), QUERY_COUNT, hits);
+
+        hits = 0;
+        start = Clock::now();
+        for (const auto& center : centers) {
+            results.clear();
+            bvh.queryAabb({ center - glm::vec3{ QUERY_RADIUS }, center + glm::vec3{ QUERY_RADIUS } }, results);
+            hits += results.size();
+        }
+        bvhMicroseconds = elapsedMicroseconds(start);
+        start = Clock::now();
+        for (const auto& center : centers) {
+            LveAabb query{ center - glm::vec3{ QUERY_RADIUS }, center + glm::vec3{ QUERY_RADIUS } };
+            for (const auto& box : boxes) {
+                linearHits += box.overlaps(query) ? 1 : 0;
+            }
+        }
+        printQueries("box", bvhMicroseconds, elapsedMicroseconds(start), QUERY_COUNT, hits);
+
+        // --- Rays (picking), closest box hit ---
+        hits = 0;
+        start = Clock::now();
+        for (const auto& center : centers) {
+            glm::vec3 direction = glm::normalize(glm::vec3{ unit(rng), unit(rng) * 0.2f, unit(rng) } + glm::vec3{ 0.f, 0.f, 0.001f });
+            LveBvh::RayHit hit;
+            hits += bvh.raycast(center, direction, WORLD_SIZE, hit) ? 1 : 0;
+        }
+        bvhMicroseconds = elapsedMicroseconds(start);
+        std::cout << "\tray: bvh " << bvhMicroseconds / QUERY_COUNT << " us/query (" << hits << " of "
+            << QUERY_COUNT << " rays hit)" << std::endl;
+
+        // --- Moving objects: refit everything, or update a few ---
+        for (auto& box : boxes) {
+            glm::vec3 offset{ unit(rng), 0.f, unit(rng) };
+            box.min += offset;
+            box.max += offset;
+        }
+        start = Clock::now();
+        bvh.refit(boxes);
+        std::cout << "\trefit: " << elapsedMicroseconds(start) / 1000.0 << " ms, SAH cost " << bvh.getCost() << std::endl;
+
+        std::uniform_int_distribution<uint32_t> pick{ 0, OBJECT_COUNT - 1 };
+        start = Clock::now();
+        for (uint32_t i = 0; i < UPDATE_COUNT; i++) {
+            uint32_t primitive = pick(rng);
+            LveAabb box = boxes[primitive];
+            box.min.y -= 1.f;
+            bvh.update(primitive, box);
+        }
+        std::cout << "\tincremental update: " << elapsedMicroseconds(start) * 1000.0 / UPDATE_COUNT << " ns/object" << std::endl;
+
+        if (linearHits == 0) {
+            std::cout << "\t(no linear hits)" << std::endl; // keeps the scans from being optimized out
+        }
+    }
+
+    void benchmarkSoftwareOcclusion() {
+        constexpr uint32_t BLOCKS = 32; // BLOCKS * BLOCKS buildings
+        constexpr float BLOCK_SIZE = 20.f;
+        constexpr uint32_t TEST_BOX_COUNT = 10000;
+        constexpr uint32_t ITERATIONS = 50;
+        const float worldSize = BLOCKS * BLOCK_SIZE;
+
+        std::mt19937 rng{ 1337 };
+        std::uniform_real_distribution<float> footprint{ 8.f, 16.f };
+        std::uniform_real_distribution<float> height{ 10.f, 60.f };
+        std::uniform_real_distribution<float> ground{ -worldSize * 0.5f, worldSize * 0.5f };
+        std::uniform_real_distribution<float> size{ 0.5f, 3.f };
+
+        // --- Scene: one scaled box per block, small objects scattered between them ---
+        const LveOccluder building = makeBoxOccluder();
+        std::vector<glm::mat4> buildings;
+        for (uint32_t z = 0; z < BLOCKS; z++) {
+            for (uint32_t x = 0; x < BLOCKS; x++) {
+                float buildingHeight = height(rng);
+                glm::mat4 modelMatrix{ 1.f };
+                modelMatrix[0][0] = footprint(rng);
+                modelMatrix[1][1] = buildingHeight;
+                modelMatrix[2][2] = footprint(rng);
+                modelMatrix[3] = glm::vec4{ (x + 0.5f) * BLOCK_SIZE - worldSize * 0.5f, -buildingHeight * 0.5f,
+                    (z + 0.5f) * BLOCK_SIZE - worldSize * 0.5f, 1.f }; // standing on y = 0, -Y is up
+                buildings.push_back(modelMatrix);
+            }
+        }
+        LveBoundsSoA testBoxes;
+        testBoxes.reserve(TEST_BOX_COUNT);
+        for (uint32_t i = 0; i < TEST_BOX_COUNT; i++) {
+            glm::vec3 extent{ size(rng), size(rng), size(rng) };
+            testBoxes.push({ ground(rng), -extent.y, ground(rng) }, extent);
+        }
+
+        // street level view down the city
+        LveCamera camera{};
+        camera.setPerspectiveProjection(glm::radians(60.f), 16.f / 9.f, 0.1f, 1000.f);
+        camera.setViewYXZ({ 0.f, -2.f, -worldSize * 0.5f - 5.f }, { 0.f, 0.3f, 0.f });
+        const glm::mat4 viewProjection = camera.getProjection() * camera.getView();
+
+        const uint32_t submittedTriangles = building.getTriangleCount() * static_cast<uint32_t>(buildings.size());
+        std::cout << "Software occlusion benchmark (" << submittedTriangles << " occluder triangles, "
+            << TEST_BOX_COUNT << " boxes, " << ITERATIONS << " iterations):" << std::endl;
+
+        const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        for (uint32_t threads = 1; ; threads = std::min(threads * 2, hardwareThreads)) {
+            LveOcclusionBuffer buffer{ 320, 192, threads };
+            std::vector<uint8_t> visible(TEST_BOX_COUNT);
+
+            double rasterMicroseconds = 0.0;
+            double testMicroseconds = 0.0;
+            uint32_t occluded = 0;
+            for (uint32_t i = 0; i < ITERATIONS; i++) {
+                auto start = Clock::now();
+                buffer.begin(viewProjection);
+                for (const auto& modelMatrix : buildings) {
+                    buffer.addOccluder(building, modelMatrix);
+                }
+                buffer.rasterize();
+                rasterMicroseconds += elapsedMicroseconds(start);
+
+                std::fill(visible.begin(), visible.end(), uint8_t{ 1 }); // no frustum culling, every box is tested
+                start = Clock::now();
+                occluded = buffer.testBoxes(testBoxes, visible);
+                testMicroseconds += elapsedMicroseconds(start);
+            }
+
+            double rasterMs = rasterMicroseconds / 1000.0 / ITERATIONS;
+            double testMs = testMicroseconds / 1000.0 / ITERATIONS;
+            double trianglesPerSecond = buffer.getRasterizedTriangleCount() / (rasterMs / 1000.0);
+            double boxesPerSecond = TEST_BOX_COUNT / (testMs / 1000.0);
+            std::cout << "	" << threads << (threads == 1 ? " thread" : " threads")
+                << ": rasterize " << rasterMs << " ms (" << buffer.getRasterizedTriangleCount() << " binned, "
+                << trianglesPerSecond / 1e6 / threads << " Mtri/s per thread), test " << testMs << " ms ("
+                << boxesPerSecond / 1e6 / threads << " Mbox/s per thread), " << occluded << " occluded" << std::endl;
+
+            if (threads == hardwareThreads) break;
+        }
+    }
+
+    void benchmarkTransforms() {
+        constexpr uint32_t OBJECT_COUNT = 100000;
+        constexpr uint32_t ITERATIONS = 20;
+        constexpr uint32_t MOVING_STRIDE = 100; // 1% of the objects move every frame
+
+        std::mt19937 rng{ 1337 };
+        std::uniform_real_distribution<float> position{ -100.f, 100.f };
+        std::uniform_real_distribution<float> angle{ -glm::two_pi<float>(), glm::two_pi<float>() };
+        std::uniform_real_distribution<float> scale{ 0.25f, 4.f };
+
+        std::vector<TransformComponent> transforms(OBJECT_COUNT);
+        for (auto& transform : transforms) {
+            transform.translation = { position(rng), position(rng), position(rng) };
+            transform.rotation = { angle(rng), angle(rng), angle(rng) };
+            transform.scale = { scale(rng), scale(rng), scale(rng) };
+        }
+
+        std::cout << "Transform benchmark (" << OBJECT_COUNT << " transforms, " << ITERATIONS << " iterations):" << std::endl;
+
+        // --- Scalar: what every draw paid before, two matrices with their own sines and cosines ---
+        std::vector<glm::mat4> scalarMatrices(OBJECT_COUNT);
+        std::vector<glm::mat3> scalarNormalMatrices(OBJECT_COUNT);
+        auto start = Clock::now();
+        for (uint32_t i = 0; i < ITERATIONS; i++) {
+            for (uint32_t t = 0; t < OBJECT_COUNT; t++) {
+                scalarMatrices[t] = transforms[t].mat4();
+                scalarNormalMatrices[t] = transforms[t].normalMatrix();
+            }
+        }
+        double scalarMs = elapsedMicroseconds(start) / 1000.0 / ITERATIONS;
+        std::cout << "\tscalar mat4 + normalMatrix: " << scalarMs << " ms" << std::endl;
+
+        // --- Store: every slot dirty, then steady frames ---
+        LveTransformStore store;
+        std::vector<uint32_t> slots(OBJECT_COUNT);
+        for (uint32_t t = 0; t < OBJECT_COUNT; t++) {
+            slots[t] = store.allocate();
+        }
+        double rebuildMs = 0.0;
+        for (uint32_t i = 0; i < ITERATIONS; i++) {
+            for (uint32_t t = 0; t < OBJECT_COUNT; t++) {
+                store.set(slots[t], transforms[t]);
+            }
+            start = Clock::now();
+            store.update();
+            rebuildMs += elapsedMicroseconds(start) / 1000.0;
+
+            for (uint32_t t = 0; t < OBJECT_COUNT; t++) {
+                transforms[t].rotation.y += 1e-3f; // all dirty again for the next round
+            }
+        }
+        rebuildMs /= ITERATIONS;
+        std::cout << "\tSIMD rebuild, all dirty: " << rebuildMs << " ms (" << scalarMs / rebuildMs << "x, "
+            << rebuildMs * 1e6 / OBJECT_COUNT << " ns/transform)" << std::endl;
+
+        for (uint32_t t = 0; t < OBJECT_COUNT; t++) {
+            store.set(slots[t], transforms[t]);
+        }
+        store.update();
+        float maxError = 0.f;
+        for (uint32_t t = 0; t < OBJECT_COUNT; t++) {
+            glm::mat4 expected = transforms[t].mat4();
+            glm::mat3 expectedNormal = transforms[t].normalMatrix();
+            for (int column = 0; column < 3; column++) {
+                for (int row = 0; row < 3; row++) {
+                    maxError = std::max(maxError, std::abs(store.getMatrix(slots[t])[column][row] - expected[column][row]));
+                    maxError = std::max(maxError, std::abs(store.getNormalMatrix(slots[t])[column][row] - expectedNormal[column][row]));
+                }
+            }
+        }
+
+        start = Clock::now();
+        for (uint32_t i = 0; i < ITERATIONS; i++) {
+            for (uint32_t t = 0; t < OBJECT_COUNT; t++) {
+                store.set(slots[t], transforms[t]);
+            }
+            store.update();
+        }
+        double staticMs = elapsedMicroseconds(start) / 1000.0 / ITERATIONS;
+        std::cout << "\tset + update, nothing moved: " << staticMs << " ms (" << store.getUpdatedCount() << " rebuilt)" << std::endl;
+
+        start = Clock::now();
+        for (uint32_t i = 0; i < ITERATIONS; i++) {
+            for (uint32_t t = i % MOVING_STRIDE; t < OBJECT_COUNT; t += MOVING_STRIDE) {
+                transforms[t].translation.x += 0.01f;
+            }
+            for (uint32_t t = 0; t < OBJECT_COUNT; t++) {
+                store.set(slots[t], transforms[t]);
+            }
+            store.update();
+        }
+        double movingMs = elapsedMicroseconds(start) / 1000.0 / ITERATIONS;
+        std::cout << "\tset + update, 1% moved: " << movingMs << " ms (" << store.getUpdatedCount() << " rebuilt)" << std::endl;
+        std::cout << "\tmax difference to scalar: " << maxError << std::endl;
+    }
+
+    void benchmarkLightClusters(LveDevice& device) {
+        constexpr uint32_t LIGHT_COUNTS[] = { 1000, 2000, 5000, 10000 };
+        constexpr uint32_t ITERATIONS = 20;
+        constexpr uint32_t SAMPLE_POINTS = 100000;
+        const VkExtent2D extent{ 1920, 1080 };
+
+        LveCamera camera;
+        camera.setPerspectiveProjection(glm::radians(50.f), static_cast<float>(extent.width) / extent.height, 0.1f, 100.f);
+        camera.setViewDirection(glm::vec3{ 0.f }, glm::vec3{ 0.f, 0.f, 1.f });
+        const glm::mat4 viewProjection = camera.getProjection() * camera.getView();
+
+        std::mt19937 rng{ 1337 };
+        std::uniform_real_distribution<float> lateral{ -60.f, 60.f };
+        std::uniform_real_distribution<float> depth{ -5.f, 105.f };
+        std::uniform_real_distribution<float> range{ 1.f, 6.f };
+
+        LveLightClusters clusters{ device };
+        std::cout << "Light cluster benchmark (" << LveLightClusters::GRID_X << "x" << LveLightClusters::GRID_Y << "x"
+            << LveLightClusters::GRID_Z << " clusters, " << extent.width << "x" << extent.height << ", " << ITERATIONS << " iterations):" << std::endl;
+
+        for (uint32_t lightCount : LIGHT_COUNTS) {
+            std::vector<GpuPointLight> lights(lightCount);
+            for (auto& light : lights) {
+                light.position = { lateral(rng), lateral(rng), depth(rng), range(rng) };
+                light.color = { 1.f, 1.f, 1.f, 1.f };
+            }
+
+            auto start = Clock::now();
+            for (uint32_t i = 0; i < ITERATIONS; i++) {
+                clusters.bin(lights, camera, extent);
+            }
+            double binMs = elapsedMicroseconds(start) / 1000.0 / ITERATIONS;
+            const LveLightClusters::Stats& stats = clusters.getStats();
+            const auto& ranges = clusters.getClusterRanges();
+            const auto& indices = clusters.getLightIndices();
+
+            // every light that reaches a sampled point has to be in the list of the point's cluster,
+            // found the way the fragment shader finds it
+            const float sliceScale = LveLightClusters::GRID_Z / std::log(camera.getFar() / camera.getNear());
+            const float sliceBias = -sliceScale * std::log(camera.getNear());
+            const glm::vec2 tileSize = glm::ceil(glm::vec2{ extent.width, extent.height } / glm::vec2{ LveLightClusters::GRID_X, LveLightClusters::GRID_Y });
+            uint64_t bruteForceTests = 0;
+            uint64_t clusterTests = 0;
+            uint32_t missed = 0;
+            uint32_t samples = 0;
+            std::vector<uint8_t> inList(lightCount);
+            for (uint32_t s = 0; s < SAMPLE_POINTS; s++) {
+                glm::vec3 point{ lateral(rng), lateral(rng), depth(rng) };
+                glm::vec4 clip = viewProjection * glm::vec4{ point, 1.f };
+                if (clip.w <= camera.getNear() || clip.w >= camera.getFar()) continue;
+                glm::vec2 ndc = glm::vec2{ clip } / clip.w;
+                if (glm::any(glm::greaterThanEqual(glm::abs(ndc), glm::vec2{ 1.f }))) continue;
+                samples++;
+
+                glm::vec2 pixel = (ndc * 0.5f + 0.5f) * glm::vec2{ extent.width, extent.height };
+                uint32_t x = std::min(static_cast<uint32_t>(pixel.x / tileSize.x), LveLightClusters::GRID_X - 1);
+                uint32_t y = std::min(static_cast<uint32_t>(pixel.y / tileSize.y), LveLightClusters::GRID_Y - 1);
+                float slice = std::log(clip.w) * sliceScale + sliceBias; // w is the view space depth
+                uint32_t z = static_cast<uint32_t>(std::min(std::max(slice, 0.f), static_cast<float>(LveLightClusters::GRID_Z - 1)));
+                const glm::uvec2& cluster = ranges[(z * LveLightClusters::GRID_Y + y) * LveLightClusters::GRID_X + x];
+
+                for (uint32_t i = 0; i < cluster.y; i++) inList[indices[cluster.x + i]] = 1;
+                for (uint32_t l = 0; l < lightCount; l++) {
+                    glm::vec3 offset = glm::vec3{ lights[l].position } - point;
+                    if (glm::dot(offset, offset) < lights[l].position.w * lights[l].position.w && !inList[l]) missed++;
+                }
+                for (uint32_t i = 0; i < cluster.y; i++) inList[indices[cluster.x + i]] = 0;
+                bruteForceTests += lightCount;
+                clusterTests += cluster.y;
+            }
+
+            std::cout << "\t" << lightCount << " lights: bin " << binMs << " ms (" << binMs * 1e6 / lightCount << " ns/light), "
+                << stats.visibleLights << " visible, " << stats.entries << " entries, max " << stats.maxPerCluster << " per cluster";
+            if (stats.droppedEntries > 0) std::cout << ", " << stats.droppedEntries << " dropped";
+            std::cout << std::endl;
+            std::cout << "\t\tper shaded point: " << static_cast<double>(clusterTests) / std::max(samples, 1u) << " lights looped over vs "
+                << lightCount << " brute force (" << static_cast<double>(bruteForceTests) / std::max<uint64_t>(clusterTests, 1) << "x fewer), "
+                << missed << " lights missed in " << samples << " samples" << std::endl;
+        }
+    }
+
+}  // namespace lve
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "lve_device.h"
+#include "lve_texture.h"
+
+namespace lve {
+
+    // In-app microbenchmarks triggered from the status bar, results go to the console.
+    // They run between frames on the main thread, so nothing they touch is in flight.
+
+    // Cost of 10k descriptor writes: vkUpdateDescriptorSets through LveDescriptorWriter,
+    // allocate + write, update templates and (when supported) push descriptors
+    void benchmarkDescriptorUpdates(LveDevice& device, const LveTexture& texture);
+
+    // LveBvh on a synthetic 100k box scene: build, save/load, refit and update, then frustum,
+    // sphere, box and ray queries against linear scans over the same boxes
+    void benchmarkBvh();
+
+    // LveOcclusionBuffer on a synthetic city of box buildings: rasterize and box test times for
+    // 1, 2, 4... threads up to the hardware count, with the throughput per thread
+    void benchmarkSoftwareOcclusion();
+
+    // LveTransformStore on 100k random transforms: full SIMD rebuilds against TransformComponent's
+    // scalar mat4 and normalMatrix, then frames where nothing or 1% of the objects move
+    void benchmarkTransforms();
+
+    // LveLightClusters binning 1k to 10k random point lights in front of a camera: bin time,
+    // entries per cluster against the brute force loop over every light, and a check that sampled
+    // points find every light reaching them in their own cluster
+    void benchmarkLightClusters(LveDevice& device);
+
+}  // namespace lve
@@ -0,0 +1,49 @@
+#include "lve_bindless_textures.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+    LveBindlessTextureTable::LveBindlessTextureTable(LveDevice& device) : lveDevice{ device } {
+        assert(isSupported(device) && "Bindless textures need descriptor indexing");
+        capacity = std::min(MAX_TEXTURES, device.getFeatureSupport().maxUpdateAfterBindSampledImages);
+
+        setLayout = LveDescriptorSetLayout::Builder(lveDevice)
+            .addBinding(
+                0,
+                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                VK_SHADER_STAGE_FRAGMENT_BIT,
+                capacity,
+                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)
+            .setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
+            .build();
+
+        pool = LveDescriptorPool::Builder(lveDevice)
+            .setMaxSets(1)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity)
+            .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+            .build();
+
+        if (!pool->allocateDescriptor(setLayout->getDescriptorSetLayout(), descriptorSet)) {
+            throw std::runtime_error("failed to allocate bindless texture set!");
+        }
+    }
+
+    // the set goes away with its pool, which is retired through the deletion queue
+    LveBindlessTextureTable::~LveBindlessTextureTable() {}
+
+    void LveBindlessTextureTable::writeTexture(uint32_t slot, const VkDescriptorImageInfo& imageInfo) {
+        if (slot >= capacity) {
+            throw std::runtime_error("bindless texture table is full!");
+        }
+
+        VkDescriptorImageInfo info = imageInfo;
+        LveDescriptorWriter(*setLayout, *pool)
+            .writeImage(0, slot, &info)
+            .overwrite(descriptorSet);
+    }
+
+}  // namespace lve
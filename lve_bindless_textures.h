@@ -0,0 +1,42 @@
+#pragma once
+
+#include "lve_device.h"
+#include "lve_descriptors.h"
+
+// std
+#include <memory>
+
+namespace lve {
+
+    // A single partially bound, update-after-bind array of combined image samplers holding every
+    // texture. Shaders index it with the slot the material carries (TextureHandle::index), so the
+    // set is bound once per pipeline instead of once per draw.
+    class LveBindlessTextureTable {
+    public:
+        static constexpr uint32_t MAX_TEXTURES = 4096;
+
+        static bool isSupported(const LveDevice& device) { return device.getFeatureSupport().descriptorIndexing; }
+
+        LveBindlessTextureTable(LveDevice& device);
+        ~LveBindlessTextureTable();
+
+        LveBindlessTextureTable(const LveBindlessTextureTable&) = delete;
+        LveBindlessTextureTable& operator=(const LveBindlessTextureTable&) = delete;
+
+        // Slots that no pending frame reads can be rewritten while the set is bound
+        void writeTexture(uint32_t slot, const VkDescriptorImageInfo& imageInfo);
+
+        uint32_t getCapacity() const { return capacity; }
+        VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+        LveDescriptorSetLayout& getSetLayout() const { return *setLayout; }
+
+    private:
+        LveDevice& lveDevice;
+        uint32_t capacity = 0;
+
+        std::unique_ptr<LveDescriptorSetLayout> setLayout;
+        std::unique_ptr<LveDescriptorPool> pool;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    };
+
+}  // namespace lve
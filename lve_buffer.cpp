@@ -48,8 +48,10 @@ namespace lve {
 
     LveBuffer::~LveBuffer() {
         unmap();
-        vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
-        vkFreeMemory(lveDevice.device(), memory, nullptr);
+        lveDevice.deletionQueue().retire([device = lveDevice.device(), buffer = buffer, memory = memory]() {
+            vkDestroyBuffer(device, buffer, nullptr);
+            vkFreeMemory(device, memory, nullptr);
+        });
     }
 
     /**
@@ -140,6 +142,19 @@ namespace lve {
         return vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
     }
 
+    /**
+     * Address shaders can dereference through GL_EXT_buffer_reference
+     *
+     * @note Buffer must have been created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+     */
+    VkDeviceAddress LveBuffer::getDeviceAddress() const {
+        assert((usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) && "Buffer was not created for device address access");
+        VkBufferDeviceAddressInfo addressInfo{};
+        addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+        addressInfo.buffer = buffer;
+        return vkGetBufferDeviceAddress(lveDevice.device(), &addressInfo);
+    }
+
     /**
      * Create a buffer info descriptor
      *
@@ -0,0 +1,475 @@
+#include "lve_bvh.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <numeric>
+#include <ostream>
+#include <utility>
+
+namespace lve {
+
+    namespace {
+        constexpr uint32_t INVALID_NODE = ~0u;
+        constexpr uint32_t MAX_STACK_DEPTH = 128;
+        // traversal holds one pending sibling per level above a node plus its two children, so a
+        // tree at most this deep never overflows the stack; deeper nodes stay leaves when building
+        constexpr uint32_t MAX_TREE_DEPTH = MAX_STACK_DEPTH - 1;
+        constexpr uint32_t INSIDE_BIT = 0x80000000u; // frustum query: whole subtree is inside
+        constexpr char BVH_MAGIC[4] = { 'L', 'B', 'V', 'H' };
+        constexpr uint32_t BVH_VERSION = 1;
+        constexpr float TRAVERSAL_COST = 1.f; // relative to testing one primitive
+
+        struct Bin {
+            LveAabb bounds = LveAabb::empty();
+            uint32_t count = 0;
+        };
+
+        template <typename T>
+        void writeVector(std::ostream& out, const std::vector<T>& values) {
+            uint64_t count = values.size();
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(sizeof(T) * values.size()));
+        }
+
+        template <typename T>
+        bool readVector(std::istream& in, std::vector<T>& values) {
+            uint64_t count = 0;
+            if (!in.read(reinterpret_cast<char*>(&count), sizeof(count))) return false;
+            if (count > std::numeric_limits<uint32_t>::max()) return false; // indices are 32 bit
+            values.resize(static_cast<size_t>(count));
+            return static_cast<bool>(in.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(sizeof(T) * count)));
+        }
+    }
+
+    LveAabb LveAabb::empty() {
+        constexpr float inf = std::numeric_limits<float>::infinity();
+        return { glm::vec3{ inf }, glm::vec3{ -inf } };
+    }
+
+    void LveAabb::grow(const glm::vec3& point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void LveAabb::grow(const LveAabb& other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    float LveAabb::surfaceArea() const {
+        glm::vec3 extent = max - min;
+        if (extent.x < 0.f) return 0.f; // empty
+        return 2.f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    bool LveAabb::overlaps(const LveAabb& other) const {
+        return min.x <= other.max.x && max.x >= other.min.x &&
+            min.y <= other.max.y && max.y >= other.min.y &&
+            min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    void LveBvh::build(const std::vector<LveAabb>& bounds) {
+        primitiveBounds = bounds;
+        nodes.clear();
+        uint32_t count = static_cast<uint32_t>(bounds.size());
+        primitiveIndices.resize(count);
+        std::iota(primitiveIndices.begin(), primitiveIndices.end(), 0u);
+        if (count == 0) {
+            parents.clear();
+            primitiveLeaves.clear();
+            return;
+        }
+
+        std::vector<glm::vec3> centroids(count);
+        for (uint32_t i = 0; i < count; i++) {
+            centroids[i] = bounds[i].center();
+        }
+
+        nodes.reserve(2 * count);
+        nodes.push_back({ LveAabb::empty(), 0, count });
+        updateNodeBounds(0);
+
+        // node and its depth, nodes at MAX_TREE_DEPTH stay leaves however many primitives they hold
+        std::vector<std::pair<uint32_t, uint32_t>> pending{ { 0, 0 } };
+        while (!pending.empty()) {
+            auto [nodeIndex, depth] = pending.back();
+            pending.pop_back();
+            if (depth == MAX_TREE_DEPTH) continue;
+            uint32_t leftChild = subdivide(nodeIndex, centroids);
+            if (leftChild != 0) {
+                pending.push_back({ leftChild, depth + 1 });
+                pending.push_back({ leftChild + 1, depth + 1 });
+            }
+        }
+        buildParentLinks();
+    }
+
+    // Splits the node with the cheapest of BIN_COUNT - 1 planes per axis, by the surface area
+    // heuristic. Returns the left child index, or 0 when the node stays a leaf.
+    uint32_t LveBvh::subdivide(uint32_t nodeIndex, std::vector<glm::vec3>& centroids) {
+        const uint32_t first = nodes[nodeIndex].leftOrFirst;
+        const uint32_t count = nodes[nodeIndex].count;
+        if (count <= 1) return 0;
+
+        LveAabb centroidBounds = LveAabb::empty();
+        for (uint32_t i = first; i < first + count; i++) {
+            centroidBounds.grow(centroids[primitiveIndices[i]]);
+        }
+
+        float bestCost = std::numeric_limits<float>::infinity();
+        int bestAxis = -1;
+        uint32_t bestSplit = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            float axisMin = centroidBounds.min[axis];
+            float extent = centroidBounds.max[axis] - axisMin;
+            if (extent <= 0.f) continue;
+
+            Bin bins[BIN_COUNT];
+            float scale = BIN_COUNT / extent;
+            for (uint32_t i = first; i < first + count; i++) {
+                uint32_t primitive = primitiveIndices[i];
+                uint32_t bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>((centroids[primitive][axis] - axisMin) * scale));
+                bins[bin].count++;
+                bins[bin].bounds.grow(primitiveBounds[primitive]);
+            }
+
+            // sweep from both sides, plane i separates bins [0, i] and [i + 1, BIN_COUNT)
+            float leftArea[BIN_COUNT - 1], rightArea[BIN_COUNT - 1];
+            uint32_t leftCount[BIN_COUNT - 1], rightCount[BIN_COUNT - 1];
+            LveAabb leftBox = LveAabb::empty(), rightBox = LveAabb::empty();
+            uint32_t leftSum = 0, rightSum = 0;
+            for (uint32_t i = 0; i < BIN_COUNT - 1; i++) {
+                leftSum += bins[i].count;
+                leftBox.grow(bins[i].bounds);
+                leftCount[i] = leftSum;
+                leftArea[i] = leftBox.surfaceArea();
+
+                uint32_t j = BIN_COUNT - 1 - i;
+                rightSum += bins[j].count;
+                rightBox.grow(bins[j].bounds);
+                rightCount[j - 1] = rightSum;
+                rightArea[j - 1] = rightBox.surfaceArea();
+            }
+            for (uint32_t i = 0; i < BIN_COUNT - 1; i++) {
+                if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+                float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i;
+                }
+            }
+        }
+
+        float nodeArea = nodes[nodeIndex].bounds.surfaceArea();
+        float leafCost = count * nodeArea;
+        if (count <= MAX_LEAF_SIZE && (bestAxis < 0 || TRAVERSAL_COST * nodeArea + bestCost >= leafCost)) return 0;
+
+        uint32_t middle = first;
+        if (bestAxis >= 0) {
+            float axisMin = centroidBounds.min[bestAxis];
+            float scale = BIN_COUNT / (centroidBounds.max[bestAxis] - axisMin);
+            uint32_t last = first + count;
+            while (middle < last) {
+                uint32_t primitive = primitiveIndices[middle];
+                uint32_t bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>((centroids[primitive][bestAxis] - axisMin) * scale));
+                if (bin <= bestSplit) {
+                    middle++;
+                }
+                else {
+                    std::swap(primitiveIndices[middle], primitiveIndices[--last]);
+                }
+            }
+        }
+        if (middle == first || middle == first + count) {
+            middle = first + count / 2; // coincident centroids, any split is as good
+        }
+
+        uint32_t leftChild = static_cast<uint32_t>(nodes.size());
+        nodes.push_back({ LveAabb::empty(), first, middle - first });
+        nodes.push_back({ LveAabb::empty(), middle, first + count - middle });
+        nodes[nodeIndex].leftOrFirst = leftChild;
+        nodes[nodeIndex].count = 0;
+        updateNodeBounds(leftChild);
+        updateNodeBounds(leftChild + 1);
+        return leftChild;
+    }
+
+    void LveBvh::updateNodeBounds(uint32_t nodeIndex) {
+        Node& node = nodes[nodeIndex];
+        node.bounds = LveAabb::empty();
+        if (node.isLeaf()) {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+                node.bounds.grow(primitiveBounds[primitiveIndices[i]]);
+            }
+        }
+        else {
+            node.bounds.grow(nodes[node.leftOrFirst].bounds);
+            node.bounds.grow(nodes[node.leftOrFirst + 1].bounds);
+        }
+    }
+
+    void LveBvh::buildParentLinks() {
+        parents.assign(nodes.size(), INVALID_NODE);
+        primitiveLeaves.assign(primitiveBounds.size(), INVALID_NODE);
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            const Node& node = nodes[i];
+            if (node.isLeaf()) {
+                for (uint32_t p = node.leftOrFirst; p < node.leftOrFirst + node.count; p++) {
+                    primitiveLeaves[primitiveIndices[p]] = i;
+                }
+            }
+            else {
+                parents[node.leftOrFirst] = i;
+                parents[node.leftOrFirst + 1] = i;
+            }
+        }
+    }
+
+    void LveBvh::refit(const std::vector<LveAabb>& bounds) {
+        assert(bounds.size() == primitiveBounds.size() && "Refit needs the same primitives as the build");
+        primitiveBounds = bounds;
+        // children are always created after their parent, so a reverse sweep is bottom up
+        for (size_t i = nodes.size(); i-- > 0;) {
+            updateNodeBounds(static_cast<uint32_t>(i));
+        }
+    }
+
+    void LveBvh::update(uint32_t primitive, const LveAabb& bounds) {
+        assert(primitive < primitiveBounds.size() && "Primitive out of range");
+        primitiveBounds[primitive] = bounds;
+        for (uint32_t node = primitiveLeaves[primitive]; node != INVALID_NODE; node = parents[node]) {
+            updateNodeBounds(node);
+        }
+    }
+
+    void LveBvh::queryFrustum(const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& results) const {
+        if (nodes.empty()) return;
+
+        // 0: outside, 1: intersecting, 2: fully inside
+        auto classify = [&](const LveAabb& box) {
+            glm::vec3 center = box.center();
+            glm::vec3 extent = box.max - center;
+            int result = 2;
+            for (const auto& plane : planes) {
+                float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+                float radius = std::fabs(plane.x) * extent.x + std::fabs(plane.y) * extent.y + std::fabs(plane.z) * extent.z;
+                if (distance < -radius) return 0;
+                if (distance < radius) result = 1;
+            }
+            return result;
+        };
+
+        uint32_t stack[MAX_STACK_DEPTH];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            uint32_t entry = stack[--stackSize];
+            const Node& node = nodes[entry & ~INSIDE_BIT];
+            bool inside = (entry & INSIDE_BIT) != 0;
+            if (!inside) {
+                int result = classify(node.bounds);
+                if (result == 0) continue;
+                inside = result == 2; // everything below is inside too, no more plane tests
+            }
+
+            if (node.isLeaf()) {
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+                    if (inside || classify(primitiveBounds[primitiveIndices[i]]) != 0) {
+                        results.push_back(primitiveIndices[i]);
+                    }
+                }
+                continue;
+            }
+            assert(stackSize + 2 <= MAX_STACK_DEPTH && "BVH too deep");
+            uint32_t flag = inside ? INSIDE_BIT : 0u;
+            stack[stackSize++] = node.leftOrFirst | flag;
+            stack[stackSize++] = (node.leftOrFirst + 1) | flag;
+        }
+    }
+
+    void LveBvh::querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& results) const {
+        if (nodes.empty()) return;
+
+        const float radiusSquared = radius * radius;
+        auto overlapsSphere = [&](const LveAabb& box) {
+            glm::vec3 closest = glm::clamp(center, box.min, box.max);
+            glm::vec3 offset = closest - center;
+            return glm::dot(offset, offset) <= radiusSquared;
+        };
+
+        uint32_t stack[MAX_STACK_DEPTH];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            const Node& node = nodes[stack[--stackSize]];
+            if (!overlapsSphere(node.bounds)) continue;
+
+            if (node.isLeaf()) {
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+                    if (overlapsSphere(primitiveBounds[primitiveIndices[i]])) {
+                        results.push_back(primitiveIndices[i]);
+                    }
+                }
+                continue;
+            }
+            assert(stackSize + 2 <= MAX_STACK_DEPTH && "BVH too deep");
+            stack[stackSize++] = node.leftOrFirst;
+            stack[stackSize++] = node.leftOrFirst + 1;
+        }
+    }
+
+    void LveBvh::queryAabb(const LveAabb& box, std::vector<uint32_t>& results) const {
+        if (nodes.empty()) return;
+
+        uint32_t stack[MAX_STACK_DEPTH];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            const Node& node = nodes[stack[--stackSize]];
+            if (!node.bounds.overlaps(box)) continue;
+
+            if (node.isLeaf()) {
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+                    if (primitiveBounds[primitiveIndices[i]].overlaps(box)) {
+                        results.push_back(primitiveIndices[i]);
+                    }
+                }
+                continue;
+            }
+            assert(stackSize + 2 <= MAX_STACK_DEPTH && "BVH too deep");
+            stack[stackSize++] = node.leftOrFirst;
+            stack[stackSize++] = node.leftOrFirst + 1;
+        }
+    }
+
+    bool LveBvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+        RayHit& hit, const RayIntersector& intersector) const {
+        if (nodes.empty()) return false;
+
+        const glm::vec3 inverseDirection = 1.f / direction; // infinities are fine for the slab test
+        float closest = maxDistance;
+        bool found = false;
+
+        // entry distance into the box, or infinity when it is missed or further than the closest hit
+        auto slab = [&](const LveAabb& box) {
+            glm::vec3 t0 = (box.min - origin) * inverseDirection;
+            glm::vec3 t1 = (box.max - origin) * inverseDirection;
+            glm::vec3 tMin = glm::min(t0, t1);
+            glm::vec3 tMax = glm::max(t0, t1);
+            float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.f));
+            float exit = std::min(std::min(tMax.x, tMax.y), tMax.z);
+            return enter <= exit && enter <= closest ? enter : std::numeric_limits<float>::infinity();
+        };
+
+        uint32_t stack[MAX_STACK_DEPTH];
+        uint32_t stackSize = 0;
+        if (slab(nodes[0].bounds) == std::numeric_limits<float>::infinity()) return false;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            const Node& node = nodes[stack[--stackSize]];
+            if (node.isLeaf()) {
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+                    uint32_t primitive = primitiveIndices[i];
+                    float distance = slab(primitiveBounds[primitive]);
+                    if (distance == std::numeric_limits<float>::infinity()) continue;
+                    if (intersector && !intersector(primitive, distance)) continue;
+                    if (distance <= closest) {
+                        closest = distance;
+                        hit = { primitive, distance };
+                        found = true;
+                    }
+                }
+                continue;
+            }
+
+            // visit the nearer child first, the farther one is skipped if a closer hit shows up
+            uint32_t nearChild = node.leftOrFirst, farChild = node.leftOrFirst + 1;
+            float nearDistance = slab(nodes[nearChild].bounds);
+            float farDistance = slab(nodes[farChild].bounds);
+            if (farDistance < nearDistance) {
+                std::swap(nearChild, farChild);
+                std::swap(nearDistance, farDistance);
+            }
+            assert(stackSize + 2 <= MAX_STACK_DEPTH && "BVH too deep");
+            if (farDistance != std::numeric_limits<float>::infinity()) stack[stackSize++] = farChild;
+            if (nearDistance != std::numeric_limits<float>::infinity()) stack[stackSize++] = nearChild;
+        }
+        return found;
+    }
+
+    void LveBvh::serialize(std::ostream& out) const {
+        out.write(BVH_MAGIC, sizeof(BVH_MAGIC));
+        out.write(reinterpret_cast<const char*>(&BVH_VERSION), sizeof(BVH_VERSION));
+        writeVector(out, nodes);
+        writeVector(out, primitiveIndices);
+        writeVector(out, primitiveBounds);
+    }
+
+    bool LveBvh::deserialize(std::istream& in) {
+        char magic[sizeof(BVH_MAGIC)];
+        uint32_t version = 0;
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, BVH_MAGIC, sizeof(magic)) != 0) return false;
+        if (!in.read(reinterpret_cast<char*>(&version), sizeof(version)) || version != BVH_VERSION) return false;
+        if (!readVector(in, nodes) || !readVector(in, primitiveIndices) || !readVector(in, primitiveBounds) || !isWellFormed()) {
+            nodes.clear();
+            primitiveIndices.clear();
+            primitiveBounds.clear();
+            return false;
+        }
+        buildParentLinks();
+        return true;
+    }
+
+    // What a loaded tree has to satisfy before it is traversed: every index in range, children
+    // after their parent (as build() appends them, which also rules out cycles), every node but
+    // the root with exactly one parent, each primitive in exactly one leaf and no node deeper
+    // than traversal can handle
+    bool LveBvh::isWellFormed() const {
+        const size_t primitiveCount = primitiveBounds.size();
+        if (primitiveIndices.size() != primitiveCount) return false;
+        if (nodes.empty()) return primitiveCount == 0;
+        if (nodes.size() >= INSIDE_BIT) return false;
+
+        std::vector<uint32_t> depths(nodes.size(), 0);
+        std::vector<bool> hasParent(nodes.size(), false);
+        std::vector<bool> seen(primitiveCount, false);
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            const Node& node = nodes[i];
+            if (i != 0 && !hasParent[i]) return false;
+            if (node.isLeaf()) {
+                if (node.leftOrFirst > primitiveCount || node.count > primitiveCount - node.leftOrFirst) return false;
+                for (uint32_t p = node.leftOrFirst; p < node.leftOrFirst + node.count; p++) {
+                    uint32_t primitive = primitiveIndices[p];
+                    if (primitive >= primitiveCount || seen[primitive]) return false;
+                    seen[primitive] = true;
+                }
+                continue;
+            }
+            if (node.leftOrFirst <= i || node.leftOrFirst >= nodes.size() - 1) return false;
+            if (hasParent[node.leftOrFirst] || hasParent[node.leftOrFirst + 1]) return false;
+            if (depths[i] + 1 > MAX_TREE_DEPTH) return false;
+            hasParent[node.leftOrFirst] = hasParent[node.leftOrFirst + 1] = true;
+            depths[node.leftOrFirst] = depths[node.leftOrFirst + 1] = depths[i] + 1;
+        }
+        return std::find(seen.begin(), seen.end(), false) == seen.end();
+    }
+
+    float LveBvh::getCost() const {
+        if (nodes.empty()) return 0.f;
+        float rootArea = nodes[0].bounds.surfaceArea();
+        if (rootArea <= 0.f) return 0.f;
+
+        float cost = 0.f;
+        for (const auto& node : nodes) {
+            cost += node.bounds.surfaceArea() * (node.isLeaf() ? static_cast<float>(node.count) : TRAVERSAL_COST);
+        }
+        return cost / rootArea;
+    }
+
+}  // namespace lve
@@ -0,0 +1,92 @@
+#pragma once
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <vector>
+
+namespace lve {
+
+    struct LveAabb {
+        glm::vec3 min{ 0.f };
+        glm::vec3 max{ 0.f };
+
+        static LveAabb empty();
+        void grow(const glm::vec3& point);
+        void grow(const LveAabb& other);
+        glm::vec3 center() const { return (min + max) * 0.5f; }
+        float surfaceArea() const;
+        bool overlaps(const LveAabb& other) const;
+    };
+
+    // Bounding volume hierarchy over arbitrary boxes (objects or meshes). Primitives are
+    // identified by their index in the bounds passed to build(), queries report those indices.
+    //
+    // Static content is built once with binned SAH (and can be saved/loaded), moving content is
+    // kept valid with refit() after many changes or update() for a few. Neither changes the tree
+    // shape, so quality drops as things move far; getCost() tells when a rebuild is worth it.
+    class LveBvh {
+    public:
+        static constexpr uint32_t MAX_LEAF_SIZE = 4;
+        static constexpr uint32_t BIN_COUNT = 16;
+
+        // Leaves have count > 0 and point at primitiveIndices[first, first + count),
+        // inner nodes have count == 0 and their children at leftChild and leftChild + 1
+        struct Node {
+            LveAabb bounds;
+            uint32_t leftOrFirst = 0;
+            uint32_t count = 0;
+            bool isLeaf() const { return count > 0; }
+        };
+
+        struct RayHit {
+            uint32_t primitive = ~0u;
+            float distance = 0.f;
+        };
+
+        // Exact test used by raycast(), returns true and the hit distance when the ray really hits
+        using RayIntersector = std::function<bool(uint32_t primitive, float& distance)>;
+
+        void build(const std::vector<LveAabb>& primitiveBounds);
+        void refit(const std::vector<LveAabb>& primitiveBounds);
+        void update(uint32_t primitive, const LveAabb& bounds);
+
+        void queryFrustum(const std::array<glm::vec4, 6>& planes, std::vector<uint32_t>& results) const;
+        void querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& results) const;
+        void queryAabb(const LveAabb& box, std::vector<uint32_t>& results) const;
+        // Closest hit along the ray, with the box entry distance unless an intersector is given
+        bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+            RayHit& hit, const RayIntersector& intersector = nullptr) const;
+
+        // Binary snapshot of a built tree, for static scenes that shouldn't be rebuilt at load
+        void serialize(std::ostream& out) const;
+        bool deserialize(std::istream& in);
+
+        // SAH cost relative to the root, compare against the value right after build()
+        float getCost() const;
+        bool isEmpty() const { return nodes.empty(); }
+        size_t getNodeCount() const { return nodes.size(); }
+        size_t getPrimitiveCount() const { return primitiveBounds.size(); }
+        const std::vector<Node>& getNodes() const { return nodes; }
+
+    private:
+        uint32_t subdivide(uint32_t nodeIndex, std::vector<glm::vec3>& centroids);
+        void updateNodeBounds(uint32_t nodeIndex);
+        void buildParentLinks();
+        bool isWellFormed() const;
+
+        std::vector<Node> nodes;
+        std::vector<uint32_t> primitiveIndices; // leaf ranges point into this
+        std::vector<LveAabb> primitiveBounds;
+        std::vector<uint32_t> parents;          // per node, ~0u for the root
+        std::vector<uint32_t> primitiveLeaves;  // per primitive, the leaf holding it
+    };
+
+}  // namespace lve
@@ -14,6 +14,8 @@ namespace lve {
 		projectionMatrix[3][0] = -(right + left) / (right - left);
 		projectionMatrix[3][1] = -(bottom + top) / (bottom - top);
 		projectionMatrix[3][2] = -near / (far - near);
+		nearPlane = near;
+		farPlane = far;
 	}
 
 	void LveCamera::setPerspectiveProjection(float fovy, float aspect, float near, float far) {
@@ -25,6 +27,8 @@ namespace lve {
 		projectionMatrix[2][2] = far / (far - near);
 		projectionMatrix[2][3] = 1.f;
 		projectionMatrix[3][2] = -(far * near) / (far - near);
+		nearPlane = near;
+		farPlane = far;
 	}
 
 	void LveCamera::setViewDirection(glm::vec3 position, glm::vec3 direction, glm::vec3 up) {
@@ -103,4 +107,26 @@ namespace lve {
 		inverseViewMatrix[3][1] = position.y;
 		inverseViewMatrix[3][2] = position.z;
 	}
+
+	std::array<glm::vec4, 6> LveCamera::getFrustumPlanes() const {
+		// Gribb/Hartmann extraction from the rows of projection * view, depth range is [0, 1]
+		const glm::mat4 m = projectionMatrix * viewMatrix;
+		const glm::vec4 row0{ m[0][0], m[1][0], m[2][0], m[3][0] };
+		const glm::vec4 row1{ m[0][1], m[1][1], m[2][1], m[3][1] };
+		const glm::vec4 row2{ m[0][2], m[1][2], m[2][2], m[3][2] };
+		const glm::vec4 row3{ m[0][3], m[1][3], m[2][3], m[3][3] };
+
+		std::array<glm::vec4, 6> planes = {
+			row3 + row0,
+			row3 - row0,
+			row3 + row1,
+			row3 - row1,
+			row2,
+			row3 - row2,
+		};
+		for (auto& plane : planes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return planes;
+	}
 }
\ No newline at end of file
@@ -5,6 +5,9 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+//std
+#include <array>
+
 namespace lve {
 	class LveCamera {
 	public:
@@ -18,10 +21,20 @@ namespace lve {
 		const glm::mat4& getProjection() const { return projectionMatrix; }
 		const glm::mat4& getView() const { return viewMatrix; }
 		const glm::mat4& getInverseView() const { return inverseViewMatrix; }
+		float getNear() const { return nearPlane; }
+		float getFar() const { return farPlane; }
 		const glm::vec3& getPosition() const { return glm::vec3(inverseViewMatrix[3]); }
+		// Pixels a length of 1 covers at distance 1 in front of a perspective camera, for screen space errors
+		float getPixelScale(float viewportHeight) const { return projectionMatrix[1][1] * viewportHeight * 0.5f; }
+
+		// World space planes (xyz normal pointing inside, w distance) in the order
+		// left, right, top, bottom, near, far. A point p is inside when dot(n, p) + w >= 0 for all.
+		std::array<glm::vec4, 6> getFrustumPlanes() const;
 	private:
 		glm::mat4 projectionMatrix{ 1.f };
 		glm::mat4 viewMatrix{ 1.f };
 		glm::mat4 inverseViewMatrix{ 1.f }; 
+		float nearPlane = 0.1f;
+		float farPlane = 100.f;
 	};
 }
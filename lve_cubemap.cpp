@@ -56,10 +56,13 @@ namespace lve {
     }
 
     LveCubemap::~LveCubemap() {
-        vkDestroySampler(lveDevice.device(), sampler, nullptr);
-        vkDestroyImageView(lveDevice.device(), imageView, nullptr);
-        vkDestroyImage(lveDevice.device(), image, nullptr);
-        vkFreeMemory(lveDevice.device(), memory, nullptr);
+        lveDevice.deletionQueue().retire(
+            [device = lveDevice.device(), sampler = sampler, imageView = imageView, image = image, memory = memory]() {
+                vkDestroySampler(device, sampler, nullptr);
+                vkDestroyImageView(device, imageView, nullptr);
+                vkDestroyImage(device, image, nullptr);
+                vkFreeMemory(device, memory, nullptr);
+            });
     }
 
     void LveCubemap::createCubemapImage(const std::array<std::string, 6>& filepaths) {
@@ -0,0 +1,62 @@
+#include "lve_deletion_queue.h"
+
+// std
+#include <cassert>
+
+namespace lve {
+
+    LveDeletionQueue::~LveDeletionQueue() {
+        assert(entries.empty() && "Deletion queue destroyed with pending entries, call flush() first");
+    }
+
+    void LveDeletionQueue::retire(Deleter deleter) {
+        // Nothing recorded or in flight can reference the object (e.g. while loading), so there
+        // is no reason to keep it around
+        if (!frameInProgress && completedFrames >= submittedFrames) {
+            deleter();
+            return;
+        }
+        entries.push_back({ submittedFrames, std::move(deleter) });
+    }
+
+    /**
+     * Called after the in-flight fence of the frame about to be recorded has been waited on
+     *
+     * @param completedFrames Number of submitted frames that are known to have finished executing
+     */
+    void LveDeletionQueue::beginFrame(uint64_t completedFrames) {
+        assert(!frameInProgress && "Deletion queue frame already in progress");
+        assert(completedFrames <= submittedFrames && "Cannot complete more frames than were submitted");
+
+        if (completedFrames > this->completedFrames) {
+            this->completedFrames = completedFrames;
+        }
+        frameInProgress = true;
+        collect();
+    }
+
+    void LveDeletionQueue::endFrame() {
+        assert(frameInProgress && "Deletion queue frame not in progress");
+        frameInProgress = false;
+        submittedFrames++;
+    }
+
+    void LveDeletionQueue::collect() {
+        // entries are pushed with non-decreasing frame tags, so the ready ones are always at the front
+        while (!entries.empty() && entries.front().frame < completedFrames) {
+            auto deleter = std::move(entries.front().deleter);
+            entries.pop_front();
+            deleter();
+        }
+    }
+
+    void LveDeletionQueue::flush() {
+        while (!entries.empty()) {
+            auto deleter = std::move(entries.front().deleter);
+            entries.pop_front();
+            deleter();
+        }
+        completedFrames = submittedFrames;
+    }
+
+}  // namespace lve
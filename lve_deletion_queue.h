@@ -0,0 +1,50 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace lve {
+
+    // Defers destruction of GPU objects until every frame that could have referenced them
+    // has finished executing. Entries are tagged with the index of the frame that is being
+    // recorded (or will be recorded next) when they are retired, and the renderer reports
+    // how many frames are known to be complete after each in-flight fence wait.
+    class LveDeletionQueue {
+    public:
+        using Deleter = std::function<void()>;
+
+        LveDeletionQueue() = default;
+        ~LveDeletionQueue();
+
+        LveDeletionQueue(const LveDeletionQueue&) = delete;
+        LveDeletionQueue& operator=(const LveDeletionQueue&) = delete;
+
+        void retire(Deleter deleter);
+
+        void beginFrame(uint64_t completedFrames);
+        void endFrame();
+
+        // Runs every pending deleter. Only valid once the device is idle.
+        void flush();
+
+        uint64_t getSubmittedFrameCount() const { return submittedFrames; }
+        uint64_t getCompletedFrameCount() const { return completedFrames; }
+        size_t getPendingCount() const { return entries.size(); }
+
+    private:
+        void collect();
+
+        struct Entry {
+            uint64_t frame;
+            Deleter deleter;
+        };
+
+        std::deque<Entry> entries;
+        uint64_t submittedFrames = 0;
+        uint64_t completedFrames = 0;
+        bool frameInProgress = false;
+    };
+
+}  // namespace lve
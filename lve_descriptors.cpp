@@ -1,6 +1,8 @@
 #include "lve_descriptors.h"
+#include "lve_utils.h"
 
 // std
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 
@@ -12,7 +14,8 @@ namespace lve {
         uint32_t binding,
         VkDescriptorType descriptorType,
         VkShaderStageFlags stageFlags,
-        uint32_t count) {
+        uint32_t count,
+        VkDescriptorBindingFlags flags) {
         assert(bindings.count(binding) == 0 && "Binding already in use");
         VkDescriptorSetLayoutBinding layoutBinding{};
         layoutBinding.binding = binding;
@@ -20,27 +23,57 @@ namespace lve {
         layoutBinding.descriptorCount = count;
         layoutBinding.stageFlags = stageFlags;
         bindings[binding] = layoutBinding;
+        if (flags != 0) {
+            bindingFlags[binding] = flags;
+        }
+        return *this;
+    }
+
+    LveDescriptorSetLayout::Builder& LveDescriptorSetLayout::Builder::setLayoutFlags(
+        VkDescriptorSetLayoutCreateFlags flags) {
+        layoutFlags = flags;
         return *this;
     }
 
     std::unique_ptr<LveDescriptorSetLayout> LveDescriptorSetLayout::Builder::build() const {
-        return std::make_unique<LveDescriptorSetLayout>(lveDevice, bindings);
+        return std::make_unique<LveDescriptorSetLayout>(lveDevice, bindings, bindingFlags, layoutFlags);
+    }
+
+    LveDescriptorSetLayout& LveDescriptorSetLayout::Builder::build(LveDescriptorLayoutCache& cache) const {
+        assert(bindingFlags.empty() && layoutFlags == 0 && "Layout cache does not key on binding/layout flags");
+        return cache.getLayout(bindings);
     }
 
     // *************** Descriptor Set Layout *********************
 
     LveDescriptorSetLayout::LveDescriptorSetLayout(
-        LveDevice& lveDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
+        LveDevice& lveDevice,
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+        const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags,
+        VkDescriptorSetLayoutCreateFlags layoutFlags)
         : lveDevice{ lveDevice }, bindings{ bindings } {
         std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+        std::vector<VkDescriptorBindingFlags> setLayoutBindingFlags{};
         for (auto kv : bindings) {
             setLayoutBindings.push_back(kv.second);
+            auto flags = bindingFlags.find(kv.first);
+            setLayoutBindingFlags.push_back(flags != bindingFlags.end() ? flags->second : 0);
         }
 
         VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
         descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
         descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
         descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
+        descriptorSetLayoutInfo.flags = layoutFlags;
+
+        // binding flags (partially bound, update after bind, ...) need descriptor indexing
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        if (!bindingFlags.empty()) {
+            bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+            bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+            bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
+            descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+        }
 
         if (vkCreateDescriptorSetLayout(
             lveDevice.device(),
@@ -99,11 +132,20 @@ namespace lve {
     }
 
     LveDescriptorPool::~LveDescriptorPool() {
-        vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+        // sets allocated from the pool may still be bound by frames in flight
+        lveDevice.deletionQueue().retire([device = lveDevice.device(), pool = descriptorPool]() {
+            vkDestroyDescriptorPool(device, pool, nullptr);
+        });
     }
     
     //it actually allocates a descriptor set (the name is not too sugestive)
     bool LveDescriptorPool::allocateDescriptor(
+        const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor) const {
+        // A full pool just fails here, LveDescriptorAllocator handles growing into new pools
+        return tryAllocateDescriptor(descriptorSetLayout, descriptor) == VK_SUCCESS;
+    }
+
+    VkResult LveDescriptorPool::tryAllocateDescriptor(
         const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor) const {
         VkDescriptorSetAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -111,12 +153,7 @@ namespace lve {
         allocInfo.pSetLayouts = &descriptorSetLayout;
         allocInfo.descriptorSetCount = 1;
 
-        // Might want to create a "DescriptorPoolManager" class that handles this case, and builds
-        // a new pool whenever an old pool fills up. But this is beyond our current scope
-        if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &descriptor) != VK_SUCCESS) {
-            return false;
-        }
-        return true;
+        return vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &descriptor);
     }
 
     void LveDescriptorPool::freeDescriptors(std::vector<VkDescriptorSet>& descriptors) const {
@@ -131,10 +168,227 @@ namespace lve {
         vkResetDescriptorPool(lveDevice.device(), descriptorPool, 0);
     }
 
+    // *************** Descriptor Allocator Builder *********************
+
+    LveDescriptorAllocator::Builder& LveDescriptorAllocator::Builder::addPoolSizeRatio(
+        VkDescriptorType descriptorType, float ratio) {
+        ratios.push_back({ descriptorType, ratio });
+        return *this;
+    }
+
+    LveDescriptorAllocator::Builder& LveDescriptorAllocator::Builder::setInitialSetsPerPool(uint32_t count) {
+        initialSetsPerPool = count;
+        return *this;
+    }
+
+    LveDescriptorAllocator::Builder& LveDescriptorAllocator::Builder::setMaxSetsPerPool(uint32_t count) {
+        maxSetsPerPool = count;
+        return *this;
+    }
+
+    LveDescriptorAllocator::Builder& LveDescriptorAllocator::Builder::setPoolFlags(
+        VkDescriptorPoolCreateFlags flags) {
+        poolFlags = flags;
+        return *this;
+    }
+
+    std::unique_ptr<LveDescriptorAllocator> LveDescriptorAllocator::Builder::build() const {
+        return std::make_unique<LveDescriptorAllocator>(
+            lveDevice, ratios, initialSetsPerPool, maxSetsPerPool, poolFlags);
+    }
+
+    // *************** Descriptor Allocator *********************
+
+    LveDescriptorAllocator::LveDescriptorAllocator(
+        LveDevice& lveDevice,
+        std::vector<PoolSizeRatio> ratios,
+        uint32_t initialSetsPerPool,
+        uint32_t maxSetsPerPool,
+        VkDescriptorPoolCreateFlags poolFlags)
+        : lveDevice{ lveDevice },
+        ratios{ ratios },
+        setsPerPool{ initialSetsPerPool },
+        maxSetsPerPool{ maxSetsPerPool },
+        poolFlags{ poolFlags } {
+        assert(!this->ratios.empty() && "Descriptor allocator needs at least one pool size ratio");
+        readyPools.push_back(takePool());
+    }
+
+    // pools release themselves through the device deletion queue
+    LveDescriptorAllocator::~LveDescriptorAllocator() {}
+
+    std::unique_ptr<LveDescriptorPool> LveDescriptorAllocator::takePool() {
+        LveDescriptorPool::Builder builder{ lveDevice };
+        builder.setMaxSets(setsPerPool).setPoolFlags(poolFlags);
+        for (auto& ratio : ratios) {
+            uint32_t count = std::max(1u, static_cast<uint32_t>(ratio.ratio * setsPerPool));
+            builder.addPoolSize(ratio.descriptorType, count);
+        }
+
+        // grow geometrically so a burst of allocations settles on a few large pools
+        setsPerPool = std::min(setsPerPool * 2, maxSetsPerPool);
+        return builder.build();
+    }
+
+    bool LveDescriptorAllocator::allocateDescriptor(
+        const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor) {
+        VkResult result = readyPools.back()->tryAllocateDescriptor(descriptorSetLayout, descriptor);
+        if (result == VK_SUCCESS) {
+            return true;
+        }
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+            return false;
+        }
+
+        fullPools.push_back(std::move(readyPools.back()));
+        readyPools.pop_back();
+        if (readyPools.empty()) {
+            readyPools.push_back(takePool());
+        }
+        return readyPools.back()->tryAllocateDescriptor(descriptorSetLayout, descriptor) == VK_SUCCESS;
+    }
+
+    void LveDescriptorAllocator::resetPools() {
+        for (auto& pool : readyPools) {
+            pool->resetPool();
+        }
+        for (auto& pool : fullPools) {
+            pool->resetPool();
+            readyPools.push_back(std::move(pool));
+        }
+        fullPools.clear();
+    }
+
+    // *************** Descriptor Layout Cache *********************
+
+    bool LveDescriptorLayoutCache::LayoutKey::operator==(const LayoutKey& other) const {
+        if (bindings.size() != other.bindings.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < bindings.size(); i++) {
+            const auto& a = bindings[i];
+            const auto& b = other.bindings[i];
+            if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+                a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t LveDescriptorLayoutCache::LayoutKeyHash::operator()(const LayoutKey& key) const {
+        size_t seed = 0;
+        for (const auto& b : key.bindings) {
+            hashCombine(seed, b.binding, static_cast<uint32_t>(b.descriptorType), b.descriptorCount, b.stageFlags);
+        }
+        return seed;
+    }
+
+    LveDescriptorSetLayout& LveDescriptorLayoutCache::getLayout(
+        const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding>& bindings) {
+        LayoutKey key{};
+        for (auto& kv : bindings) {
+            key.bindings.push_back(kv.second);
+        }
+        std::sort(key.bindings.begin(), key.bindings.end(),
+            [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+                return a.binding < b.binding;
+            });
+
+        auto it = layouts.find(key);
+        if (it != layouts.end()) {
+            return *it->second;
+        }
+
+        auto layout = std::make_unique<LveDescriptorSetLayout>(lveDevice, bindings);
+        auto& result = *layout;
+        layouts.emplace(std::move(key), std::move(layout));
+        return result;
+    }
+
+    // *************** Descriptor Update Template Builder *********************
+
+    LveDescriptorUpdateTemplate::Builder& LveDescriptorUpdateTemplate::Builder::addEntry(
+        uint32_t binding,
+        VkDescriptorType descriptorType,
+        size_t offset,
+        uint32_t count,
+        size_t stride,
+        uint32_t arrayElement) {
+        VkDescriptorUpdateTemplateEntry entry{};
+        entry.dstBinding = binding;
+        entry.dstArrayElement = arrayElement;
+        entry.descriptorCount = count;
+        entry.descriptorType = descriptorType;
+        entry.offset = offset;
+        entry.stride = stride;
+        entries.push_back(entry);
+        return *this;
+    }
+
+    LveDescriptorUpdateTemplate::Builder& LveDescriptorUpdateTemplate::Builder::setDescriptorSetLayout(
+        VkDescriptorSetLayout setLayout) {
+        createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+        createInfo.descriptorSetLayout = setLayout;
+        return *this;
+    }
+
+    LveDescriptorUpdateTemplate::Builder& LveDescriptorUpdateTemplate::Builder::setPushDescriptors(
+        VkPipelineLayout pipelineLayout, uint32_t set, VkPipelineBindPoint bindPoint) {
+        createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR;
+        createInfo.pipelineLayout = pipelineLayout;
+        createInfo.set = set;
+        createInfo.pipelineBindPoint = bindPoint;
+        return *this;
+    }
+
+    std::unique_ptr<LveDescriptorUpdateTemplate> LveDescriptorUpdateTemplate::Builder::build() const {
+        assert(!entries.empty() && "Update template needs at least one entry");
+        VkDescriptorUpdateTemplateCreateInfo info = createInfo;
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+        info.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+        info.pDescriptorUpdateEntries = entries.data();
+        return std::make_unique<LveDescriptorUpdateTemplate>(lveDevice, info);
+    }
+
+    // *************** Descriptor Update Template *********************
+
+    LveDescriptorUpdateTemplate::LveDescriptorUpdateTemplate(
+        LveDevice& lveDevice, const VkDescriptorUpdateTemplateCreateInfo& createInfo)
+        : lveDevice{ lveDevice },
+        templateType{ createInfo.templateType },
+        pipelineLayout{ createInfo.pipelineLayout },
+        set{ createInfo.set } {
+        assert(lveDevice.getFeatureSupport().descriptorUpdateTemplates && "Descriptor update templates are not supported");
+        assert((!isPushTemplate() || lveDevice.getFeatureSupport().pushDescriptors) && "Push descriptors are not enabled");
+        if (vkCreateDescriptorUpdateTemplate(lveDevice.device(), &createInfo, nullptr, &updateTemplate) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor update template!");
+        }
+    }
+
+    LveDescriptorUpdateTemplate::~LveDescriptorUpdateTemplate() {
+        // templates are only read while recording/updating, nothing in flight references them
+        vkDestroyDescriptorUpdateTemplate(lveDevice.device(), updateTemplate, nullptr);
+    }
+
+    void LveDescriptorUpdateTemplate::update(VkDescriptorSet set, const void* data) const {
+        assert(!isPushTemplate() && "Push templates can only be recorded into a command buffer");
+        vkUpdateDescriptorSetWithTemplate(lveDevice.device(), set, updateTemplate, data);
+    }
+
+    void LveDescriptorUpdateTemplate::push(VkCommandBuffer commandBuffer, const void* data) const {
+        assert(isPushTemplate() && "Template was not built for push descriptors");
+        lveDevice.cmdPushDescriptorSetWithTemplate(commandBuffer, updateTemplate, pipelineLayout, set, data);
+    }
+
     // *************** Descriptor Writer *********************
 
     LveDescriptorWriter::LveDescriptorWriter(LveDescriptorSetLayout& setLayout, LveDescriptorPool& pool)
-        : setLayout{ setLayout }, pool{ pool } {}
+        : setLayout{ setLayout }, pool{ &pool } {}
+
+    LveDescriptorWriter::LveDescriptorWriter(LveDescriptorSetLayout& setLayout, LveDescriptorAllocator& allocator)
+        : setLayout{ setLayout }, allocator{ &allocator } {}
 
     LveDescriptorWriter& LveDescriptorWriter::writeBuffer(
         uint32_t binding, VkDescriptorBufferInfo* bufferInfo) {
@@ -178,8 +432,30 @@ namespace lve {
         return *this;
     }
 
+    LveDescriptorWriter& LveDescriptorWriter::writeImage(
+        uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo* imageInfo) {
+        assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
+
+        auto& bindingDescription = setLayout.bindings[binding];
+
+        assert(arrayElement < bindingDescription.descriptorCount && "Array element out of range for binding");
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.descriptorType = bindingDescription.descriptorType;
+        write.dstBinding = binding;
+        write.dstArrayElement = arrayElement;
+        write.pImageInfo = imageInfo;
+        write.descriptorCount = 1;
+
+        writes.push_back(write);
+        return *this;
+    }
+
     bool LveDescriptorWriter::build(VkDescriptorSet& set) {
-        bool success = pool.allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
+        bool success = allocator != nullptr
+            ? allocator->allocateDescriptor(setLayout.getDescriptorSetLayout(), set)
+            : pool->allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
         if (!success) {
             return false;
         }
@@ -191,7 +467,7 @@ namespace lve {
         for (auto& write : writes) {
             write.dstSet = set;
         }
-        vkUpdateDescriptorSets(pool.lveDevice.device(), writes.size(), writes.data(), 0, nullptr);
+        vkUpdateDescriptorSets(setLayout.lveDevice.device(), writes.size(), writes.data(), 0, nullptr);
     }
 
 }  // namespace lve
\ No newline at end of file
@@ -9,6 +9,8 @@
 
 namespace lve {
 
+    class LveDescriptorLayoutCache;
+
     class LveDescriptorSetLayout {
     public:
         class Builder {
@@ -19,16 +21,25 @@ namespace lve {
                 uint32_t binding,
                 VkDescriptorType descriptorType,
                 VkShaderStageFlags stageFlags,
-                uint32_t count = 1);
+                uint32_t count = 1,
+                VkDescriptorBindingFlags bindingFlags = 0);
+            Builder& setLayoutFlags(VkDescriptorSetLayoutCreateFlags flags);
             std::unique_ptr<LveDescriptorSetLayout> build() const;
+            // Only for plain layouts, ones with binding/layout flags are owned by whoever builds them
+            LveDescriptorSetLayout& build(LveDescriptorLayoutCache& cache) const;
 
         private:
             LveDevice& lveDevice;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0;
         };
 
         LveDescriptorSetLayout(
-            LveDevice& lveDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+            LveDevice& lveDevice,
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags = {},
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0);
         ~LveDescriptorSetLayout();
         LveDescriptorSetLayout(const LveDescriptorSetLayout&) = delete;
         LveDescriptorSetLayout& operator=(const LveDescriptorSetLayout&) = delete;
@@ -72,6 +83,8 @@ namespace lve {
 
         bool allocateDescriptor(
             const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor) const;
+        VkResult tryAllocateDescriptor(
+            const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor) const;
 
         void freeDescriptors(std::vector<VkDescriptorSet>& descriptors) const;
 
@@ -84,19 +97,158 @@ namespace lve {
         friend class LveDescriptorWriter;
     };
 
+    // Hands out descriptor sets from a growing list of pools. When a pool runs out
+    // (VK_ERROR_OUT_OF_POOL_MEMORY / VK_ERROR_FRAGMENTED_POOL) it is parked as full and a new,
+    // larger one is taken, so sets can be allocated at any time without sizing anything up front.
+    // resetPools() recycles every pool at once, which is how the per-frame allocators are used.
+    class LveDescriptorAllocator {
+    public:
+        struct PoolSizeRatio {
+            VkDescriptorType descriptorType;
+            float ratio; // descriptors of this type per set
+        };
+
+        class Builder {
+        public:
+            Builder(LveDevice& lveDevice) : lveDevice{ lveDevice } {}
+
+            Builder& addPoolSizeRatio(VkDescriptorType descriptorType, float ratio);
+            Builder& setInitialSetsPerPool(uint32_t count);
+            Builder& setMaxSetsPerPool(uint32_t count);
+            Builder& setPoolFlags(VkDescriptorPoolCreateFlags flags);
+            std::unique_ptr<LveDescriptorAllocator> build() const;
+
+        private:
+            LveDevice& lveDevice;
+            std::vector<PoolSizeRatio> ratios{};
+            uint32_t initialSetsPerPool = 64;
+            uint32_t maxSetsPerPool = 4096;
+            VkDescriptorPoolCreateFlags poolFlags = 0;
+        };
+
+        LveDescriptorAllocator(
+            LveDevice& lveDevice,
+            std::vector<PoolSizeRatio> ratios,
+            uint32_t initialSetsPerPool,
+            uint32_t maxSetsPerPool,
+            VkDescriptorPoolCreateFlags poolFlags);
+        ~LveDescriptorAllocator();
+        LveDescriptorAllocator(const LveDescriptorAllocator&) = delete;
+        LveDescriptorAllocator& operator=(const LveDescriptorAllocator&) = delete;
+
+        bool allocateDescriptor(const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor);
+
+        // Returns every set to its pool, only valid once the GPU is done with all of them
+        void resetPools();
+
+        size_t getPoolCount() const { return fullPools.size() + readyPools.size(); }
+
+    private:
+        std::unique_ptr<LveDescriptorPool> takePool();
+
+        LveDevice& lveDevice;
+        std::vector<PoolSizeRatio> ratios;
+        uint32_t setsPerPool;
+        uint32_t maxSetsPerPool;
+        VkDescriptorPoolCreateFlags poolFlags;
+
+        std::vector<std::unique_ptr<LveDescriptorPool>> fullPools;
+        std::vector<std::unique_ptr<LveDescriptorPool>> readyPools; // back() is the one allocated from
+    };
+
+    // Deduplicates descriptor set layouts by their bindings, so systems asking for the same
+    // layout share one VkDescriptorSetLayout
+    class LveDescriptorLayoutCache {
+    public:
+        LveDescriptorLayoutCache(LveDevice& lveDevice) : lveDevice{ lveDevice } {}
+        LveDescriptorLayoutCache(const LveDescriptorLayoutCache&) = delete;
+        LveDescriptorLayoutCache& operator=(const LveDescriptorLayoutCache&) = delete;
+
+        LveDescriptorSetLayout& getLayout(
+            const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding>& bindings);
+
+        size_t size() const { return layouts.size(); }
+
+    private:
+        struct LayoutKey {
+            std::vector<VkDescriptorSetLayoutBinding> bindings; // sorted by binding
+
+            bool operator==(const LayoutKey& other) const;
+        };
+        struct LayoutKeyHash {
+            size_t operator()(const LayoutKey& key) const;
+        };
+
+        LveDevice& lveDevice;
+        std::unordered_map<LayoutKey, std::unique_ptr<LveDescriptorSetLayout>, LayoutKeyHash> layouts;
+    };
+
+    // Precompiled mapping from a caller-side struct to the bindings of a set, so a set is rewritten
+    // with a single vkUpdateDescriptorSetWithTemplate call instead of a VkWriteDescriptorSet array.
+    // Built with setPushDescriptors() the same data is pushed straight into the command buffer
+    // (VK_KHR_push_descriptor), which needs no descriptor set at all.
+    class LveDescriptorUpdateTemplate {
+    public:
+        class Builder {
+        public:
+            Builder(LveDevice& lveDevice) : lveDevice{ lveDevice } {}
+
+            // offset/stride locate the VkDescriptor*Info for the binding inside the data passed to update()/push()
+            Builder& addEntry(
+                uint32_t binding,
+                VkDescriptorType descriptorType,
+                size_t offset,
+                uint32_t count = 1,
+                size_t stride = 0,
+                uint32_t arrayElement = 0);
+            Builder& setDescriptorSetLayout(VkDescriptorSetLayout setLayout);
+            Builder& setPushDescriptors(
+                VkPipelineLayout pipelineLayout,
+                uint32_t set,
+                VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
+            std::unique_ptr<LveDescriptorUpdateTemplate> build() const;
+
+        private:
+            LveDevice& lveDevice;
+            std::vector<VkDescriptorUpdateTemplateEntry> entries{};
+            VkDescriptorUpdateTemplateCreateInfo createInfo{};
+        };
+
+        LveDescriptorUpdateTemplate(LveDevice& lveDevice, const VkDescriptorUpdateTemplateCreateInfo& createInfo);
+        ~LveDescriptorUpdateTemplate();
+        LveDescriptorUpdateTemplate(const LveDescriptorUpdateTemplate&) = delete;
+        LveDescriptorUpdateTemplate& operator=(const LveDescriptorUpdateTemplate&) = delete;
+
+        void update(VkDescriptorSet set, const void* data) const;
+        void push(VkCommandBuffer commandBuffer, const void* data) const;
+
+        bool isPushTemplate() const { return templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR; }
+        VkDescriptorUpdateTemplate getUpdateTemplate() const { return updateTemplate; }
+
+    private:
+        LveDevice& lveDevice;
+        VkDescriptorUpdateTemplate updateTemplate;
+        VkDescriptorUpdateTemplateType templateType;
+        VkPipelineLayout pipelineLayout;
+        uint32_t set;
+    };
+
     class LveDescriptorWriter {
     public:
         LveDescriptorWriter(LveDescriptorSetLayout& setLayout, LveDescriptorPool& pool);
+        LveDescriptorWriter(LveDescriptorSetLayout& setLayout, LveDescriptorAllocator& allocator);
 
         LveDescriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo);
         LveDescriptorWriter& writeImage(uint32_t binding, VkDescriptorImageInfo* imageInfo);
+        LveDescriptorWriter& writeImage(uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo* imageInfo);
 
         bool build(VkDescriptorSet& set);
         void overwrite(VkDescriptorSet& set);
 
     private:
         LveDescriptorSetLayout& setLayout;
-        LveDescriptorPool& pool;
+        LveDescriptorPool* pool = nullptr;
+        LveDescriptorAllocator* allocator = nullptr;
         std::vector<VkWriteDescriptorSet> writes;
     };
 }
\ No newline at end of file
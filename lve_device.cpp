@@ -1,6 +1,8 @@
 #include "lve_device.h"
 
 // std headers
+#include <algorithm>
+#include <cassert>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -58,6 +60,9 @@ namespace lve {
     }
 
     LveDevice::~LveDevice() {
+        vkDeviceWaitIdle(device_);
+        deletionQueue_.flush();
+
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
 
@@ -80,7 +85,7 @@ namespace lve {
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        appInfo.apiVersion = VK_API_VERSION_1_2; // optional features are only used when the GPU reports 1.2
 
         VkInstanceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -160,6 +165,63 @@ namespace lve {
         } else {
             msaaSamples = VK_SAMPLE_COUNT_1_BIT;
         }
+
+        queryFeatureSupport();
+    }
+
+    void LveDevice::queryFeatureSupport() {
+        featureSupport = {};
+        enabledDeviceExtensions = deviceExtensions;
+        if (properties.apiVersion < VK_API_VERSION_1_2) {
+            std::cout << "Vulkan 1.2 not supported, optional features disabled" << std::endl;
+            return;
+        }
+
+        VkPhysicalDeviceVulkan12Features features12{};
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &features12;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+        VkPhysicalDevicePushDescriptorPropertiesKHR pushDescriptorProperties{};
+        pushDescriptorProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+        VkPhysicalDeviceVulkan12Properties properties12{};
+        properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+        bool pushDescriptorsAvailable = isDeviceExtensionAvailable(physicalDevice, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+        if (pushDescriptorsAvailable) {
+            properties12.pNext = &pushDescriptorProperties;
+        }
+        VkPhysicalDeviceProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &properties12;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+        featureSupport.descriptorIndexing =
+            features12.runtimeDescriptorArray &&
+            features12.descriptorBindingPartiallyBound &&
+            features12.descriptorBindingSampledImageUpdateAfterBind &&
+            features12.shaderSampledImageArrayNonUniformIndexing;
+        featureSupport.bufferDeviceAddress = features12.bufferDeviceAddress;
+        featureSupport.multiDrawIndirect = features2.features.multiDrawIndirect;
+        featureSupport.drawIndirectFirstInstance = features2.features.drawIndirectFirstInstance;
+        featureSupport.drawIndirectCount = features12.drawIndirectCount;
+        featureSupport.maxUpdateAfterBindSampledImages = std::min({
+            properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            properties12.maxPerStageDescriptorUpdateAfterBindSamplers,
+            properties12.maxDescriptorSetUpdateAfterBindSampledImages });
+
+        featureSupport.descriptorUpdateTemplates = true;
+        if (pushDescriptorsAvailable) {
+            featureSupport.pushDescriptors = true;
+            featureSupport.maxPushDescriptors = pushDescriptorProperties.maxPushDescriptors;
+            enabledDeviceExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+        }
+
+        std::cout << "descriptor indexing: " << (featureSupport.descriptorIndexing ? "yes" : "no") << std::endl;
+        std::cout << "push descriptors: " << (featureSupport.pushDescriptors ? "yes" : "no") << std::endl;
+        std::cout << "buffer device address: " << (featureSupport.bufferDeviceAddress ? "yes" : "no") << std::endl;
+        std::cout << "multi draw indirect: " << (featureSupport.multiDrawIndirect ? "yes" : "no") << std::endl;
     }
 
     void LveDevice::createLogicalDevice() {
@@ -180,6 +242,25 @@ namespace lve {
 
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.multiDrawIndirect = featureSupport.multiDrawIndirect ? VK_TRUE : VK_FALSE;
+        deviceFeatures.drawIndirectFirstInstance = featureSupport.drawIndirectFirstInstance ? VK_TRUE : VK_FALSE;
+
+        // optional 1.2 features go through the pNext chain instead of pEnabledFeatures
+        VkPhysicalDeviceVulkan12Features enabledFeatures12 = {};
+        enabledFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        if (featureSupport.descriptorIndexing) {
+            enabledFeatures12.runtimeDescriptorArray = VK_TRUE;
+            enabledFeatures12.descriptorBindingPartiallyBound = VK_TRUE;
+            enabledFeatures12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            enabledFeatures12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        }
+        enabledFeatures12.bufferDeviceAddress = featureSupport.bufferDeviceAddress ? VK_TRUE : VK_FALSE;
+        enabledFeatures12.drawIndirectCount = featureSupport.drawIndirectCount ? VK_TRUE : VK_FALSE;
+
+        VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+        deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        deviceFeatures2.pNext = &enabledFeatures12;
+        deviceFeatures2.features = deviceFeatures;
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -187,9 +268,15 @@ namespace lve {
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-        createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        if (properties.apiVersion >= VK_API_VERSION_1_2) {
+            createInfo.pNext = &deviceFeatures2;
+            createInfo.pEnabledFeatures = nullptr;
+        }
+        else {
+            createInfo.pEnabledFeatures = &deviceFeatures;
+        }
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledDeviceExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledDeviceExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -207,6 +294,23 @@ namespace lve {
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+        if (featureSupport.pushDescriptors) {
+            pfnCmdPushDescriptorSetWithTemplate = (PFN_vkCmdPushDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(
+                device_,
+                "vkCmdPushDescriptorSetWithTemplateKHR");
+            featureSupport.pushDescriptors = pfnCmdPushDescriptorSetWithTemplate != nullptr;
+        }
+    }
+
+    void LveDevice::cmdPushDescriptorSetWithTemplate(
+        VkCommandBuffer commandBuffer,
+        VkDescriptorUpdateTemplate updateTemplate,
+        VkPipelineLayout layout,
+        uint32_t set,
+        const void* data) {
+        assert(pfnCmdPushDescriptorSetWithTemplate != nullptr && "Push descriptors are not enabled");
+        pfnCmdPushDescriptorSetWithTemplate(commandBuffer, updateTemplate, layout, set, data);
     }
 
     void LveDevice::createCommandPool() {
@@ -347,6 +451,21 @@ namespace lve {
         return requiredExtensions.empty();
     }
 
+    bool LveDevice::isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName) {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto& extension : availableExtensions) {
+            if (strcmp(extension.extensionName, extensionName) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
         QueueFamilyIndices indices;
 
@@ -458,6 +577,15 @@ namespace lve {
         allocInfo.allocationSize = memRequirements.size;
         allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
+        // buffers read through device addresses need memory allocated with the matching flag
+        VkMemoryAllocateFlagsInfo allocFlagsInfo{};
+        if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+            assert(featureSupport.bufferDeviceAddress && "Buffer device address is not enabled");
+            allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+            allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+            allocInfo.pNext = &allocFlagsInfo;
+        }
+
         if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
             throw std::runtime_error("failed to allocate vertex buffer memory!");
         }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "lve_window.h"
+#include "lve_deletion_queue.h"
 
 // std lib headers
 #include <string>
@@ -22,6 +23,19 @@ namespace lve {
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
+    // Optional features detected on the picked GPU, enabled on the logical device when present
+    struct DeviceFeatureSupport {
+        bool descriptorIndexing = false; // partially bound, update-after-bind sampled image arrays
+        uint32_t maxUpdateAfterBindSampledImages = 0;
+        bool descriptorUpdateTemplates = false; // core since 1.1
+        bool pushDescriptors = false; // VK_KHR_push_descriptor
+        uint32_t maxPushDescriptors = 0;
+        bool bufferDeviceAddress = false; // shaders read buffers through 64-bit pointers
+        bool multiDrawIndirect = false; // drawCount > 1 in one indirect call
+        bool drawIndirectFirstInstance = false; // indirect commands may use a non-zero firstInstance
+        bool drawIndirectCount = false; // draw count read from a buffer (vkCmdDrawIndexedIndirectCount)
+    };
+
     class LveDevice {
     public:
 #ifdef NDEBUG
@@ -44,6 +58,7 @@ namespace lve {
         VkSurfaceKHR surface() { return surface_; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        LveDeletionQueue& deletionQueue() { return deletionQueue_; }
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -73,6 +88,15 @@ namespace lve {
 
         VkSampleCountFlagBits getMsaaSampleCount() const { return msaaSamples; }
         VkSampleCountFlags getSupportedSampleCounts() const { return supportedSampleCounts; }
+        const DeviceFeatureSupport& getFeatureSupport() const { return featureSupport; }
+
+        // VK_KHR_push_descriptor entry point, only valid when getFeatureSupport().pushDescriptors
+        void cmdPushDescriptorSetWithTemplate(
+            VkCommandBuffer commandBuffer,
+            VkDescriptorUpdateTemplate updateTemplate,
+            VkPipelineLayout layout,
+            uint32_t set,
+            const void* data);
 
         bool setMsaaSampleCount(VkSampleCountFlagBits newSamples) {
             if (supportedSampleCounts & newSamples) {
@@ -89,6 +113,7 @@ namespace lve {
         void setupDebugMessenger();
         void createSurface();
         void pickPhysicalDevice();
+        void queryFeatureSupport();
         void createLogicalDevice();
         void createCommandPool();
 
@@ -100,6 +125,7 @@ namespace lve {
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
         void hasGflwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName);
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
@@ -113,8 +139,13 @@ namespace lve {
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
 
+        LveDeletionQueue deletionQueue_;
+
 		VkSampleCountFlags supportedSampleCounts = VK_SAMPLE_COUNT_1_BIT;
 		VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+        DeviceFeatureSupport featureSupport{};
+        std::vector<const char*> enabledDeviceExtensions; // required + supported optional ones
+        PFN_vkCmdPushDescriptorSetWithTemplateKHR pfnCmdPushDescriptorSetWithTemplate = nullptr;
 
         const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
         const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
@@ -3,6 +3,9 @@
 #include "lve_camera.h"
 #include "lve_game_object.h"
 #include "lve_descriptors.h"
+#include "lve_linear_allocator.h"
+#include "lve_resource_manager.h"
+#include "lve_transform_store.h"
 #include "lve_utils.h"
 
 //lib
@@ -10,13 +13,6 @@
 
 namespace lve {
 
-	#define MAX_LIGHTS 10
-
-	struct Light {
-		glm::vec4 position{};
-		glm::vec4 color{};
-	};
-
 	struct GlobalUbo {
 		glm::mat4 projection{ 1.f };
 		glm::mat4 view{ 1.f };
@@ -24,9 +20,43 @@ namespace lve {
 		//glm::vec3 lightDirection = glm::normalize(glm::vec3{1.f, -3.f, -1.f}); //this was for directional light
 		glm::vec4 ambientLightColor{ 0.01f, 0.01f, 0.01f, 1.0f }; // w is for intensity
 
-		Light lights[MAX_LIGHTS];
-		int numLights; // Number of lights currently in use
-		
+		// point lights live in LveLightClusters' storage buffers, these locate a fragment's cluster
+		glm::uvec4 clusterGrid{ 0 }; // clusters along x, y and depth, w is the light count
+		glm::vec4 clusterSlicing{ 0.f }; // x,y tile size in pixels, z,w scale and bias of the log depth slices
+	};
+
+	// Counters filled in by the render systems while recording, reset every frame
+	struct RenderStats {
+		uint32_t drawCalls = 0;
+		uint32_t instances = 0;
+		uint32_t prepassDrawCalls = 0; // depth prepass draws, the same geometry again, not in drawCalls
+		uint32_t culled = 0; // rejected by frustum culling, meshes (or objects when instancing)
+		uint32_t occluded = 0; // rejected by occlusion culling, GPU or CPU (LveOcclusionBuffer)
+		uint32_t occludedTriangles = 0; // the triangles that saved, GPU culling only
+
+		// state changes actually recorded, and the ones the render queue found redundant
+		uint32_t pipelineBinds = 0;
+		uint32_t descriptorBinds = 0;
+		uint32_t vertexBufferBinds = 0;
+		uint32_t redundantBindsSkipped = 0;
+
+		uint32_t lights = 0; // point lights in at least one cluster, and their entries in all cluster lists
+		uint32_t lightClusterEntries = 0;
+
+		void accumulate(const RenderStats& other) {
+			drawCalls += other.drawCalls;
+			instances += other.instances;
+			prepassDrawCalls += other.prepassDrawCalls;
+			culled += other.culled;
+			occluded += other.occluded;
+			occludedTriangles += other.occludedTriangles;
+			pipelineBinds += other.pipelineBinds;
+			descriptorBinds += other.descriptorBinds;
+			vertexBufferBinds += other.vertexBufferBinds;
+			redundantBindsSkipped += other.redundantBindsSkipped;
+			lights += other.lights;
+			lightClusterEntries += other.lightClusterEntries;
+		}
 	};
 
 	struct FrameInfo {
@@ -36,10 +66,24 @@ namespace lve {
 
 		VkCommandBuffer commandBuffer;
 		LveCamera &camera;
+		VkExtent2D extent; // of the swap chain, for screen space measures
 
 		VkDescriptorSet globalDescriptorSet;
-		std::unordered_map<id_t, VkDescriptorSet> textureDescriptorSets;
+		LveDescriptorAllocator& frameDescriptorAllocator; // reset every time this frame index comes around
+		LveLinearAllocator& frameMemory; // CPU scratch for per-frame lists, reset the same way
+		const std::vector<VkDescriptorSet>& textureDescriptorSets; // indexed by TextureHandle::index
+		VkDescriptorSet bindlessTextureSet; // VK_NULL_HANDLE unless bindless mode is on
+		const LveResourceManager& resourceManager;
 
 		LveGameObject::Map& gameObjects;
+		const LveTransformStore& transforms; // matrices of gameObjects, synced before the frame is recorded
+		RenderStats& renderStats;
+
+		// The same frame recorded into another command buffer with its own stats, for recording on
+		// several threads (only one of them may use frameDescriptorAllocator or frameMemory)
+		FrameInfo withCommandBuffer(VkCommandBuffer otherCommandBuffer, RenderStats& otherStats) const {
+			return { frameIndex, frameTime, otherCommandBuffer, camera, extent, globalDescriptorSet, frameDescriptorAllocator,
+				frameMemory, textureDescriptorSets, bindlessTextureSet, resourceManager, gameObjects, transforms, otherStats };
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "lve_frustum.h"
+
+// std
+#include <cmath>
+#include <immintrin.h>
+
+namespace lve {
+
+    void LveBoundsSoA::clear() {
+        centerX.clear(); centerY.clear(); centerZ.clear();
+        extentX.clear(); extentY.clear(); extentZ.clear();
+    }
+
+    void LveBoundsSoA::reserve(size_t count) {
+        centerX.reserve(count); centerY.reserve(count); centerZ.reserve(count);
+        extentX.reserve(count); extentY.reserve(count); extentZ.reserve(count);
+    }
+
+    void LveBoundsSoA::push(const glm::vec3& center, const glm::vec3& extent) {
+        centerX.push_back(center.x); centerY.push_back(center.y); centerZ.push_back(center.z);
+        extentX.push_back(extent.x); extentY.push_back(extent.y); extentZ.push_back(extent.z);
+    }
+
+    void transformBounds(const glm::mat4& modelMatrix, const glm::vec3& localMin, const glm::vec3& localMax,
+        glm::vec3& worldCenter, glm::vec3& worldExtent) {
+        // Arvo: the new extent is the local extent through the absolute rotation/scale part
+        glm::vec3 center = (localMin + localMax) * 0.5f;
+        glm::vec3 extent = (localMax - localMin) * 0.5f;
+        worldCenter = glm::vec3(modelMatrix * glm::vec4(center, 1.f));
+        glm::mat3 absolute{ glm::abs(glm::vec3(modelMatrix[0])), glm::abs(glm::vec3(modelMatrix[1])), glm::abs(glm::vec3(modelMatrix[2])) };
+        worldExtent = absolute * extent;
+    }
+
+    // The box is outside a plane when even its corner furthest along the normal is behind it:
+    // dot(n, c) + w < -dot(|n|, e)
+    static bool isBoxVisible(const std::array<glm::vec4, 6>& planes, float cx, float cy, float cz, float ex, float ey, float ez) {
+        for (const auto& plane : planes) {
+            float distance = plane.x * cx + plane.y * cy + plane.z * cz + plane.w;
+            float radius = std::fabs(plane.x) * ex + std::fabs(plane.y) * ey + std::fabs(plane.z) * ez;
+            if (distance < -radius) return false;
+        }
+        return true;
+    }
+
+    uint32_t cullBoxes(const std::array<glm::vec4, 6>& planes, const LveBoundsSoA& bounds, std::vector<uint8_t>& visible) {
+        const size_t count = bounds.size();
+        visible.resize(count);
+        uint32_t visibleCount = 0;
+        size_t i = 0;
+
+#if defined(__AVX__)
+        const __m256 signMask8 = _mm256_set1_ps(-0.f);
+        for (; i + 8 <= count; i += 8) {
+            __m256 cx = _mm256_loadu_ps(&bounds.centerX[i]);
+            __m256 cy = _mm256_loadu_ps(&bounds.centerY[i]);
+            __m256 cz = _mm256_loadu_ps(&bounds.centerZ[i]);
+            __m256 ex = _mm256_loadu_ps(&bounds.extentX[i]);
+            __m256 ey = _mm256_loadu_ps(&bounds.extentY[i]);
+            __m256 ez = _mm256_loadu_ps(&bounds.extentZ[i]);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (const auto& plane : planes) {
+                __m256 nx = _mm256_set1_ps(plane.x);
+                __m256 ny = _mm256_set1_ps(plane.y);
+                __m256 nz = _mm256_set1_ps(plane.z);
+                __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(cx, nx), _mm256_mul_ps(cy, ny)),
+                    _mm256_add_ps(_mm256_mul_ps(cz, nz), _mm256_set1_ps(plane.w)));
+                __m256 radius = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(ex, _mm256_andnot_ps(signMask8, nx)), _mm256_mul_ps(ey, _mm256_andnot_ps(signMask8, ny))),
+                    _mm256_mul_ps(ez, _mm256_andnot_ps(signMask8, nz)));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+
+            int mask = _mm256_movemask_ps(inside);
+            for (int lane = 0; lane < 8; lane++) {
+                uint8_t bit = static_cast<uint8_t>((mask >> lane) & 1);
+                visible[i + lane] = bit;
+                visibleCount += bit;
+            }
+        }
+#endif
+
+        const __m128 signMask = _mm_set1_ps(-0.f);
+        for (; i + 4 <= count; i += 4) {
+            __m128 cx = _mm_loadu_ps(&bounds.centerX[i]);
+            __m128 cy = _mm_loadu_ps(&bounds.centerY[i]);
+            __m128 cz = _mm_loadu_ps(&bounds.centerZ[i]);
+            __m128 ex = _mm_loadu_ps(&bounds.extentX[i]);
+            __m128 ey = _mm_loadu_ps(&bounds.extentY[i]);
+            __m128 ez = _mm_loadu_ps(&bounds.extentZ[i]);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const auto& plane : planes) {
+                __m128 nx = _mm_set1_ps(plane.x);
+                __m128 ny = _mm_set1_ps(plane.y);
+                __m128 nz = _mm_set1_ps(plane.z);
+                __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(cx, nx), _mm_mul_ps(cy, ny)),
+                    _mm_add_ps(_mm_mul_ps(cz, nz), _mm_set1_ps(plane.w)));
+                __m128 radius = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(ex, _mm_andnot_ps(signMask, nx)), _mm_mul_ps(ey, _mm_andnot_ps(signMask, ny))),
+                    _mm_mul_ps(ez, _mm_andnot_ps(signMask, nz)));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            }
+
+            int mask = _mm_movemask_ps(inside);
+            for (int lane = 0; lane < 4; lane++) {
+                uint8_t bit = static_cast<uint8_t>((mask >> lane) & 1);
+                visible[i + lane] = bit;
+                visibleCount += bit;
+            }
+        }
+
+        for (; i < count; i++) {
+            bool isVisible = isBoxVisible(planes,
+                bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i],
+                bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+            visible[i] = isVisible ? 1 : 0;
+            visibleCount += isVisible ? 1 : 0;
+        }
+        return visibleCount;
+    }
+
+}  // namespace lve
@@ -0,0 +1,37 @@
+#pragma once
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+    // World space boxes as center/extent, one array per component so the SIMD tests load
+    // 4 (SSE) or 8 (AVX) boxes with one instruction each
+    struct LveBoundsSoA {
+        std::vector<float> centerX, centerY, centerZ;
+        std::vector<float> extentX, extentY, extentZ;
+
+        void clear();
+        void reserve(size_t count);
+        void push(const glm::vec3& center, const glm::vec3& extent);
+        size_t size() const { return centerX.size(); }
+    };
+
+    // Box around a local AABB after transformation, exact for the rotated box's bounds
+    void transformBounds(const glm::mat4& modelMatrix, const glm::vec3& localMin, const glm::vec3& localMax,
+        glm::vec3& worldCenter, glm::vec3& worldExtent);
+
+    // Tests every box against the planes (LveCamera::getFrustumPlanes), writes 1 to visible[i]
+    // when box i is at least partly inside and 0 when it is fully outside one plane.
+    // Runs 8 boxes per step with AVX builds, 4 with SSE, the tail is scalar.
+    // Returns the number of visible boxes.
+    uint32_t cullBoxes(const std::array<glm::vec4, 6>& planes, const LveBoundsSoA& bounds, std::vector<uint8_t>& visible);
+
+}  // namespace lve
@@ -58,12 +58,13 @@ namespace lve {
 		};
 	}
 
-	LveGameObject LveGameObject::makeLight(float intensity, float radius, glm::vec3 color) {
+	LveGameObject LveGameObject::makeLight(float intensity, float radius, glm::vec3 color, float range) {
 		LveGameObject gameObject = LveGameObject::createGameObject();
 		gameObject.color = color;
 		gameObject.transform.scale.x = radius;
 		gameObject.lightComponent = std::make_unique<LightComponent>();
 		gameObject.lightComponent->lightIntensity = intensity;
+		gameObject.lightComponent->range = range;
 
 		return gameObject;
 	}
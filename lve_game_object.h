@@ -10,6 +10,8 @@
 
 namespace lve {
 
+	struct LveOccluder; // lve_occlusion.h
+
 	struct TransformComponent {
 		glm::vec3 translation{}; //position offset
 		glm::vec3 scale{1.f, 1.f, 1.f};
@@ -24,6 +26,7 @@ namespace lve {
 
 	struct LightComponent {
 		float lightIntensity = 1.0f;
+		float range = 100.f; // distance at which the light has faded out, bounds the clusters it is binned into
 	};
 
 	class LveGameObject {
@@ -36,7 +39,7 @@ namespace lve {
 			return LveGameObject(currentId++);
 		}
 
-		static LveGameObject makeLight(float intensity = 2.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
+		static LveGameObject makeLight(float intensity = 2.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f), float range = 100.f); // radius 0 draws no billboard
 
 		LveGameObject(const LveGameObject &) = delete;
 		LveGameObject &operator=(const LveGameObject &) = delete;
@@ -58,6 +61,10 @@ namespace lve {
 		// Optional pointer components
 		std::shared_ptr<LveModel> model{};
 		std::unique_ptr<LightComponent> lightComponent = nullptr;
+		std::shared_ptr<LveOccluder> occluder{}; // drawn into the CPU occlusion buffer, usually big static meshes
+
+		uint32_t transformSlot = UINT32_MAX; // in LveTransformStore, assigned by its sync()
+		bool isStatic = false; // never moves once loaded, merged by LveStaticBatcher
 
 	private:
 		LveGameObject(id_t objId) : id{ objId } {}
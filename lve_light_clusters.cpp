@@ -0,0 +1,172 @@
+#include "lve_light_clusters.h"
+#include "lve_swap_chain.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace lve {
+
+    LveLightClusters::LveLightClusters(LveDevice& device) : lveDevice{ device } {
+        auto createBuffers = [&](std::vector<std::unique_ptr<LveBuffer>>& buffers, VkDeviceSize instanceSize, uint32_t count) {
+            buffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+            for (auto& buffer : buffers) {
+                buffer = std::make_unique<LveBuffer>(
+                    lveDevice,
+                    instanceSize,
+                    count,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+                buffer->map();
+            }
+        };
+        createBuffers(lightBuffers, sizeof(GpuPointLight), MAX_LIGHTS);
+        createBuffers(clusterBuffers, sizeof(glm::uvec2), CLUSTER_COUNT);
+        createBuffers(indexBuffers, sizeof(uint32_t), MAX_LIGHT_INDICES);
+    }
+
+    void LveLightClusters::update(FrameInfo& frameInfo, GlobalUbo& ubo) {
+        lights.clear();
+        for (auto& kv : frameInfo.gameObjects) {
+            auto& obj = kv.second;
+            if (obj.lightComponent == nullptr) continue;
+            if (lights.size() == MAX_LIGHTS) break;
+            lights.push_back({
+                glm::vec4{ obj.transform.translation, obj.lightComponent->range },
+                glm::vec4{ obj.color, obj.lightComponent->lightIntensity } });
+        }
+        bin(lights, frameInfo.camera, frameInfo.extent);
+
+        const int frameIndex = frameInfo.frameIndex;
+        if (!lights.empty()) {
+            std::memcpy(lightBuffers[frameIndex]->getMappedMemory(), lights.data(), sizeof(GpuPointLight) * lights.size());
+        }
+        std::memcpy(clusterBuffers[frameIndex]->getMappedMemory(), clusterRanges.data(), sizeof(glm::uvec2) * CLUSTER_COUNT);
+        if (!lightIndices.empty()) {
+            std::memcpy(indexBuffers[frameIndex]->getMappedMemory(), lightIndices.data(), sizeof(uint32_t) * lightIndices.size());
+        }
+
+        ubo.clusterGrid = glm::uvec4{ GRID_X, GRID_Y, GRID_Z, static_cast<uint32_t>(lights.size()) };
+        ubo.clusterSlicing = glm::vec4{ tileSize, sliceScale, sliceBias };
+        frameInfo.renderStats.lights += stats.visibleLights;
+        frameInfo.renderStats.lightClusterEntries += stats.entries;
+    }
+
+    std::array<VkDescriptorBufferInfo, 3> LveLightClusters::descriptorInfos(int frameIndex) const {
+        return {
+            lightBuffers[frameIndex]->descriptorInfo(),
+            clusterBuffers[frameIndex]->descriptorInfo(),
+            indexBuffers[frameIndex]->descriptorInfo() };
+    }
+
+    LveLightClusters::ClusterBounds LveLightClusters::computeBounds(
+        const GpuPointLight& light, const glm::mat4& view, const glm::mat4& projection) const {
+        constexpr ClusterBounds EMPTY{ 1, 0, 0, 0, 0, 0 };
+        const glm::vec3 center{ view * glm::vec4{ glm::vec3{ light.position }, 1.f } };
+        const float radius = light.position.w;
+        const float zMin = center.z - radius;
+        const float zMax = center.z + radius;
+        if (radius <= 0.f || zMax < nearPlane || zMin > farPlane) return EMPTY;
+
+        auto slice = [this](float z) {
+            return static_cast<uint8_t>(std::min(std::max(std::log(z) * sliceScale + sliceBias, 0.f), static_cast<float>(GRID_Z - 1)));
+        };
+        ClusterBounds bounds{};
+        bounds.z0 = slice(std::max(zMin, nearPlane));
+        bounds.z1 = slice(std::min(zMax, farPlane));
+
+        // screen rectangle of the box around the sphere, the whole screen when it reaches behind the near plane
+        glm::vec2 ndcMin{ -1.f };
+        glm::vec2 ndcMax{ 1.f };
+        if (zMin > nearPlane) {
+            ndcMin = glm::vec2{ 1.f };
+            ndcMax = glm::vec2{ -1.f };
+            for (int corner = 0; corner < 8; corner++) {
+                glm::vec3 offset{ corner & 1 ? radius : -radius, corner & 2 ? radius : -radius, corner & 4 ? radius : -radius };
+                glm::vec4 clip = projection * glm::vec4{ center + offset, 1.f };
+                glm::vec2 ndc = glm::vec2{ clip } / clip.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+            if (ndcMax.x < -1.f || ndcMax.y < -1.f || ndcMin.x > 1.f || ndcMin.y > 1.f) return EMPTY;
+        }
+
+        // gl_FragCoord has y down like NDC in Vulkan, so both map the same way
+        auto tile = [&](float ndc, float size, float tilePixels, uint32_t count) {
+            float pixel = (std::min(std::max(ndc, -1.f), 1.f) * 0.5f + 0.5f) * size;
+            return static_cast<uint8_t>(std::min(static_cast<uint32_t>(pixel / tilePixels), count - 1));
+        };
+        bounds.x0 = tile(ndcMin.x, extent.x, tileSize.x, GRID_X);
+        bounds.x1 = tile(ndcMax.x, extent.x, tileSize.x, GRID_X);
+        bounds.y0 = tile(ndcMin.y, extent.y, tileSize.y, GRID_Y);
+        bounds.y1 = tile(ndcMax.y, extent.y, tileSize.y, GRID_Y);
+        return bounds;
+    }
+
+    // Two passes over the lights: count the entries of every cluster, turn the counts into
+    // offsets, then write each light's index into the lists it overlaps
+    void LveLightClusters::bin(const std::vector<GpuPointLight>& sceneLights, const LveCamera& camera, VkExtent2D viewExtent) {
+        assert(camera.getNear() > 0.f && camera.getFar() > camera.getNear() && "Clusters need a depth range in front of the camera");
+        extent = glm::vec2{ static_cast<float>(std::max(viewExtent.width, 1u)), static_cast<float>(std::max(viewExtent.height, 1u)) };
+        tileSize = glm::ceil(extent / glm::vec2{ GRID_X, GRID_Y });
+        nearPlane = camera.getNear();
+        farPlane = camera.getFar();
+        const float logRatio = std::log(farPlane / nearPlane);
+        sliceScale = GRID_Z / logRatio;
+        sliceBias = -static_cast<float>(GRID_Z) * std::log(nearPlane) / logRatio;
+
+        const uint32_t lightCount = static_cast<uint32_t>(std::min<size_t>(sceneLights.size(), MAX_LIGHTS));
+        stats = {};
+        stats.lights = lightCount;
+        lightBounds.resize(lightCount);
+        clusterRanges.assign(CLUSTER_COUNT, glm::uvec2{ 0 });
+
+        const glm::mat4& view = camera.getView();
+        const glm::mat4& projection = camera.getProjection();
+        for (uint32_t i = 0; i < lightCount; i++) {
+            const ClusterBounds bounds = computeBounds(sceneLights[i], view, projection);
+            lightBounds[i] = bounds;
+            if (bounds.x0 > bounds.x1) continue;
+            stats.visibleLights++;
+            for (uint32_t z = bounds.z0; z <= bounds.z1; z++) {
+                for (uint32_t y = bounds.y0; y <= bounds.y1; y++) {
+                    for (uint32_t x = bounds.x0; x <= bounds.x1; x++) {
+                        clusterRanges[(z * GRID_Y + y) * GRID_X + x].y++;
+                    }
+                }
+            }
+        }
+
+        uint32_t offset = 0;
+        for (auto& range : clusterRanges) {
+            stats.maxPerCluster = std::max(stats.maxPerCluster, range.y);
+            range.x = offset;
+            offset += range.y;
+            range.y = 0; // counted again while filling, up to the capacity
+        }
+        const uint32_t capacity = std::min(offset, MAX_LIGHT_INDICES);
+        lightIndices.resize(capacity);
+
+        for (uint32_t i = 0; i < lightCount; i++) {
+            const ClusterBounds& bounds = lightBounds[i];
+            if (bounds.x0 > bounds.x1) continue;
+            for (uint32_t z = bounds.z0; z <= bounds.z1; z++) {
+                for (uint32_t y = bounds.y0; y <= bounds.y1; y++) {
+                    for (uint32_t x = bounds.x0; x <= bounds.x1; x++) {
+                        glm::uvec2& range = clusterRanges[(z * GRID_Y + y) * GRID_X + x];
+                        if (range.x + range.y < capacity) {
+                            lightIndices[range.x + range.y++] = i;
+                        }
+                        else {
+                            stats.droppedEntries++;
+                        }
+                    }
+                }
+            }
+        }
+        stats.entries = capacity;
+    }
+
+}  // namespace lve
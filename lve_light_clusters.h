@@ -0,0 +1,101 @@
+#pragma once
+
+#include "lve_buffer.h"
+#include "lve_camera.h"
+#include "lve_device.h"
+#include "lve_frame_info.h"
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+    // A point light as the shaders read it
+    struct GpuPointLight {
+        glm::vec4 position{}; // xyz world space, w range: the light fades to nothing there
+        glm::vec4 color{};    // w is the intensity
+    };
+
+    // Clustered forward lighting. The view frustum is split into a grid of froxels, screen tiles
+    // by slices of exponentially growing depth, and every frame each light is binned on the CPU
+    // into the clusters its sphere's view space box overlaps. The fragment shaders then only loop
+    // over the lights of their own cluster instead of every light in the scene.
+    //
+    // The buffers have a fixed size per frame in flight, so the global sets referencing them are
+    // written once (see descriptorInfos) and command buffers recorded against them stay valid.
+    // Lights past MAX_LIGHTS and list entries past MAX_LIGHT_INDICES are dropped.
+    class LveLightClusters {
+    public:
+        static constexpr uint32_t GRID_X = 16;
+        static constexpr uint32_t GRID_Y = 9;
+        static constexpr uint32_t GRID_Z = 24;
+        static constexpr uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+        static constexpr uint32_t MAX_LIGHTS = 16384;
+        static constexpr uint32_t MAX_LIGHT_INDICES = 1 << 20;
+
+        // Of the last bin()
+        struct Stats {
+            uint32_t lights = 0;        // binned
+            uint32_t visibleLights = 0; // in at least one cluster
+            uint32_t entries = 0;       // light indices in all cluster lists
+            uint32_t maxPerCluster = 0;
+            uint32_t droppedEntries = 0; // past MAX_LIGHT_INDICES
+        };
+
+        LveLightClusters(LveDevice& device);
+
+        LveLightClusters(const LveLightClusters&) = delete;
+        LveLightClusters& operator=(const LveLightClusters&) = delete;
+
+        // Gathers the game objects' lights, bins them and writes this frame index's buffers and
+        // the grid parameters of the ubo
+        void update(FrameInfo& frameInfo, GlobalUbo& ubo);
+        // Lights, cluster ranges and light indices of a frame index, for bindings 2, 3 and 4 of the global set
+        std::array<VkDescriptorBufferInfo, 3> descriptorInfos(int frameIndex) const;
+
+        // The binning alone: per cluster (x fastest, then y, then the depth slice) an offset and a
+        // count into the light indices, which index lights
+        void bin(const std::vector<GpuPointLight>& lights, const LveCamera& camera, VkExtent2D extent);
+        const std::vector<glm::uvec2>& getClusterRanges() const { return clusterRanges; }
+        const std::vector<uint32_t>& getLightIndices() const { return lightIndices; }
+        const Stats& getStats() const { return stats; }
+
+    private:
+        // Clusters a light overlaps, inclusive, empty when x0 > x1
+        struct ClusterBounds {
+            uint8_t x0, x1, y0, y1, z0, z1;
+        };
+
+        ClusterBounds computeBounds(const GpuPointLight& light, const glm::mat4& view, const glm::mat4& projection) const;
+
+        LveDevice& lveDevice;
+
+        std::vector<std::unique_ptr<LveBuffer>> lightBuffers; // per frame in flight
+        std::vector<std::unique_ptr<LveBuffer>> clusterBuffers;
+        std::vector<std::unique_ptr<LveBuffer>> indexBuffers;
+
+        // scratch of bin(), kept between frames
+        std::vector<GpuPointLight> lights;
+        std::vector<ClusterBounds> lightBounds;
+        std::vector<glm::uvec2> clusterRanges;
+        std::vector<uint32_t> lightIndices;
+
+        // grid of the current bin()
+        glm::vec2 tileSize{ 1.f };
+        glm::vec2 extent{ 1.f };
+        float sliceScale = 0.f;
+        float sliceBias = 0.f;
+        float nearPlane = 0.1f;
+        float farPlane = 100.f;
+        Stats stats{};
+    };
+
+}  // namespace lve
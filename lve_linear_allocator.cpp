@@ -0,0 +1,108 @@
+#include "lve_linear_allocator.h"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace lve {
+
+    LveLinearAllocator::LveLinearAllocator(size_t capacity)
+        : buffer{ new unsigned char[capacity] }, capacity{ capacity } {}
+
+    void LveLinearAllocator::reset() {
+        if (!overflowBlocks.empty()) {
+            // room for the whole last frame, with some headroom for the next one
+            capacity = std::max(capacity * 2, (offset + overflowBytes) * 3 / 2);
+            buffer.reset(new unsigned char[capacity]);
+            overflowBlocks.clear();
+            overflowBytes = 0;
+        }
+        offset = 0;
+    }
+
+    void* LveLinearAllocator::allocate(size_t size, size_t alignment) {
+        assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+        size_t start = (offset + alignment - 1) & ~(alignment - 1);
+        if (start + size <= capacity) {
+            offset = start + size;
+            return buffer.get() + start;
+        }
+
+        // new[] is aligned for any fundamental type, larger alignments get padding
+        size_t padding = alignment > alignof(std::max_align_t) ? alignment - 1 : 0;
+        overflowBlocks.emplace_back(new unsigned char[size + padding]);
+        overflowBytes += size + padding;
+        auto address = reinterpret_cast<uintptr_t>(overflowBlocks.back().get());
+        return reinterpret_cast<void*>((address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1));
+    }
+
+#ifndef NDEBUG
+    namespace {
+        std::atomic<uint64_t> heapAllocationCount{ 0 };
+    }
+
+    uint64_t getHeapAllocationCount() {
+        return heapAllocationCount.load(std::memory_order_relaxed);
+    }
+#else
+    uint64_t getHeapAllocationCount() {
+        return 0;
+    }
+#endif
+
+}  // namespace lve
+
+#ifndef NDEBUG
+// Replaces the global allocation functions to count calls; the array and nothrow forms forward to
+// these by default, the aligned ones included
+void* operator new(std::size_t size) {
+    lve::heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+// Over-aligned types (alignas above alignof(std::max_align_t)) come here. MSVC has no
+// std::aligned_alloc, and its aligned blocks have to go back through _aligned_free.
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    lve::heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    const auto align = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+    void* memory = _aligned_malloc(size > 0 ? size : 1, align);
+#else
+    // aligned_alloc wants a multiple of the alignment
+    void* memory = std::aligned_alloc(align, ((size > 0 ? size : 1) + align - 1) & ~(align - 1));
+#endif
+    if (memory) {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+#ifdef _MSC_VER
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(memory, alignment);
+}
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+// std
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace lve {
+
+    // Bump allocator for scratch data that lives for one frame: allocations are a pointer bump
+    // and reset() frees all of them at once. A frame that needs more than the buffer holds gets
+    // extra blocks from the heap, and the next reset() grows the buffer to fit them, so a steady
+    // workload stops touching the heap after its first frames. Not thread safe.
+    class LveLinearAllocator {
+    public:
+        explicit LveLinearAllocator(size_t capacity = 64 * 1024);
+
+        LveLinearAllocator(const LveLinearAllocator&) = delete;
+        LveLinearAllocator& operator=(const LveLinearAllocator&) = delete;
+
+        void reset();
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        // Value-initialized array, never destroyed, so only for trivially destructible types
+        template <typename T>
+        T* allocateArray(size_t count) {
+            static_assert(std::is_trivially_destructible<T>::value, "Frame memory is released without destructors");
+            T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+            for (size_t i = 0; i < count; i++) {
+                new (data + i) T();
+            }
+            return data;
+        }
+
+        size_t getCapacity() const { return capacity; }
+        // since the last reset, including what went to extra blocks
+        size_t getUsed() const { return offset + overflowBytes; }
+
+    private:
+        std::unique_ptr<unsigned char[]> buffer;
+        size_t capacity;
+        size_t offset = 0;
+        std::vector<std::unique_ptr<unsigned char[]>> overflowBlocks;
+        size_t overflowBytes = 0;
+    };
+
+    // Calls to the global operator new so far, every form of it. Counted in debug builds only, it
+    // stays 0 with NDEBUG. The difference over a frame tells whether the frame allocated.
+    uint64_t getHeapAllocationCount();
+
+}  // namespace lve
@@ -0,0 +1,307 @@
+#include "lve_mesh_simplifier.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace lve {
+
+    namespace {
+
+        // Weight of the planes holding borders and seams in place, relative to the surface planes
+        constexpr double BORDER_WEIGHT = 10.0;
+
+        // Weighted sum of squared distances to planes, the symmetric 4x4 matrix of Garland & Heckbert
+        struct Quadric {
+            double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+            double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+            double c = 0.0;
+            double weight = 0.0; // surface area the planes stand for
+
+            void addPlane(const glm::vec3& normal, float distance, double planeWeight, double area) {
+                double x = normal.x, y = normal.y, z = normal.z, d = distance;
+                a00 += planeWeight * x * x;
+                a01 += planeWeight * x * y;
+                a02 += planeWeight * x * z;
+                a11 += planeWeight * y * y;
+                a12 += planeWeight * y * z;
+                a22 += planeWeight * z * z;
+                b0 += planeWeight * x * d;
+                b1 += planeWeight * y * d;
+                b2 += planeWeight * z * d;
+                c += planeWeight * d * d;
+                weight += area;
+            }
+
+            void add(const Quadric& other) {
+                a00 += other.a00;
+                a01 += other.a01;
+                a02 += other.a02;
+                a11 += other.a11;
+                a12 += other.a12;
+                a22 += other.a22;
+                b0 += other.b0;
+                b1 += other.b1;
+                b2 += other.b2;
+                c += other.c;
+                weight += other.weight;
+            }
+
+            // Squared distance of the point to the planes, averaged over the area they came from
+            double error(const glm::vec3& point) const {
+                double x = point.x, y = point.y, z = point.z;
+                double e = a00 * x * x + a11 * y * y + a22 * z * z
+                    + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                    + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+                e = std::max(e, 0.0); // rounding
+                return weight > 0.0 ? e / weight : e;
+            }
+        };
+
+        struct PositionHash {
+            size_t operator()(const glm::vec3& position) const {
+                uint32_t bits[3];
+                for (int i = 0; i < 3; i++) {
+                    float value = position[i] + 0.f; // -0 and 0 compare equal, so they have to hash the same
+                    std::memcpy(&bits[i], &value, sizeof(float));
+                }
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            }
+        };
+
+        uint64_t edgeKey(uint32_t a, uint32_t b) {
+            return (static_cast<uint64_t>(a) << 32) | b;
+        }
+
+        struct Collapse {
+            uint32_t from;
+            uint32_t to;
+            double cost;
+        };
+
+    }  // namespace
+
+    std::vector<uint32_t> simplifyMesh(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+        size_t targetIndexCount, float& error) {
+        const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+        double maxError = 0.0;
+
+        // --- Weld vertices sharing a position, the topology only knows the first of them ---
+        std::vector<uint32_t> welded(vertexCount);
+        {
+            std::unordered_map<glm::vec3, uint32_t, PositionHash> firstAt;
+            firstAt.reserve(vertexCount);
+            for (uint32_t v = 0; v < vertexCount; v++) {
+                welded[v] = firstAt.emplace(positions[v], v).first->second;
+            }
+        }
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            uint32_t a = welded[indices[t]], b = welded[indices[t + 1]], c = welded[indices[t + 2]];
+            if (a != b && b != c && a != c) {
+                result.insert(result.end(), { indices[t], indices[t + 1], indices[t + 2] });
+            }
+        }
+
+        // --- Quadrics of the surface planes, then of planes through borders and seams ---
+        std::vector<Quadric> quadrics(vertexCount); // per welded vertex
+        std::vector<uint8_t> locked(vertexCount, 0); // on non-manifold edges, never moved
+        std::unordered_map<uint64_t, uint64_t> edgeWedges; // directed welded edge -> the vertices it joins
+        edgeWedges.reserve(result.size());
+        for (size_t t = 0; t < result.size(); t += 3) {
+            for (size_t e = 0; e < 3; e++) {
+                uint32_t a = result[t + e], b = result[t + (e + 1) % 3];
+                if (!edgeWedges.emplace(edgeKey(welded[a], welded[b]), edgeKey(a, b)).second) {
+                    locked[welded[a]] = locked[welded[b]] = 1;
+                }
+            }
+
+            const glm::vec3& p0 = positions[result[t]];
+            glm::vec3 normal = glm::cross(positions[result[t + 1]] - p0, positions[result[t + 2]] - p0);
+            float length = glm::length(normal);
+            if (length == 0.f) continue;
+            normal /= length;
+            double area = length * 0.5;
+            for (size_t corner = 0; corner < 3; corner++) {
+                quadrics[welded[result[t + corner]]].addPlane(normal, -glm::dot(normal, p0), area, area);
+            }
+        }
+        for (size_t t = 0; t < result.size(); t += 3) {
+            const glm::vec3& p0 = positions[result[t]];
+            glm::vec3 faceNormal = glm::cross(positions[result[t + 1]] - p0, positions[result[t + 2]] - p0);
+            for (size_t e = 0; e < 3; e++) {
+                uint32_t a = result[t + e], b = result[t + (e + 1) % 3];
+                auto opposite = edgeWedges.find(edgeKey(welded[b], welded[a]));
+                bool border = opposite == edgeWedges.end();
+                bool seam = !border && opposite->second != edgeKey(b, a); // the other side uses other vertices
+                if (!border && !seam) continue;
+
+                // plane along the edge, across the triangle: leaving it changes the outline
+                glm::vec3 edge = positions[b] - positions[a];
+                glm::vec3 normal = glm::cross(edge, faceNormal);
+                float length = glm::length(normal);
+                if (length == 0.f) continue;
+                normal /= length;
+                double weight = BORDER_WEIGHT * glm::dot(edge, edge);
+                quadrics[welded[a]].addPlane(normal, -glm::dot(normal, positions[a]), weight, 0.0);
+                quadrics[welded[b]].addPlane(normal, -glm::dot(normal, positions[a]), weight, 0.0);
+            }
+        }
+
+        // --- Passes of independent collapses, cheapest first, until the target is reached ---
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+        std::vector<uint32_t> adjacency; // triangles around each welded vertex
+        std::vector<uint32_t> cursor;
+        std::unordered_set<uint64_t> edges; // directed welded edges of the current triangles
+        std::vector<uint8_t> border(vertexCount);
+        std::vector<uint8_t> touched(vertexCount);
+        std::vector<uint32_t> wedgeRemap(vertexCount);
+        std::vector<Collapse> collapses;
+        std::vector<std::pair<uint32_t, uint32_t>> wedgeMoves; // vertex of the collapsed position -> its replacement
+
+        while (result.size() > targetIndexCount) {
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+            for (uint32_t index : result) {
+                adjacencyOffsets[welded[index] + 1]++;
+            }
+            for (uint32_t v = 0; v < vertexCount; v++) {
+                adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+            }
+            adjacency.resize(result.size());
+            cursor.assign(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            edges.clear();
+            for (size_t i = 0; i < result.size(); i++) {
+                size_t next = i - i % 3 + (i + 1) % 3;
+                adjacency[cursor[welded[result[i]]]++] = static_cast<uint32_t>(i / 3);
+                edges.insert(edgeKey(welded[result[i]], welded[result[next]]));
+            }
+            auto isBorderEdge = [&](uint32_t a, uint32_t b) {
+                return edges.count(edgeKey(a, b)) != edges.count(edgeKey(b, a));
+            };
+            std::fill(border.begin(), border.end(), uint8_t{ 0 });
+            for (uint64_t edge : edges) {
+                uint32_t a = static_cast<uint32_t>(edge >> 32), b = static_cast<uint32_t>(edge);
+                if (isBorderEdge(a, b)) {
+                    border[a] = border[b] = 1;
+                }
+            }
+
+            // the cheaper allowed direction of every edge
+            collapses.clear();
+            for (uint64_t edge : edges) {
+                uint32_t a = static_cast<uint32_t>(edge >> 32), b = static_cast<uint32_t>(edge);
+                if (a > b && edges.count(edgeKey(b, a))) continue; // its twin covers it
+
+                Collapse best{ a, b, std::numeric_limits<double>::max() };
+                for (int direction = 0; direction < 2; direction++) {
+                    uint32_t from = direction == 0 ? a : b;
+                    uint32_t to = direction == 0 ? b : a;
+                    if (locked[from]) continue;
+                    if (border[from] && !isBorderEdge(from, to)) continue; // borders only slide along themselves
+
+                    Quadric quadric = quadrics[from];
+                    quadric.add(quadrics[to]);
+                    double cost = quadric.error(positions[to]);
+                    if (cost < best.cost) {
+                        best = { from, to, cost };
+                    }
+                }
+                if (best.cost < std::numeric_limits<double>::max()) {
+                    collapses.push_back(best);
+                }
+            }
+            if (collapses.empty()) break;
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+            const size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+            size_t removed = 0;
+            std::fill(touched.begin(), touched.end(), uint8_t{ 0 });
+            std::iota(wedgeRemap.begin(), wedgeRemap.end(), 0u);
+            for (const Collapse& collapse : collapses) {
+                if (removed >= trianglesToRemove) break;
+                if (touched[collapse.from] || touched[collapse.to]) continue;
+
+                // triangles on the edge disappear and tell which vertex of 'to' each vertex of 'from'
+                // becomes, the others must not flip
+                bool valid = true;
+                size_t collapsedTriangles = 0;
+                wedgeMoves.clear();
+                for (uint32_t i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1] && valid; i++) {
+                    const uint32_t* triangle = &result[adjacency[i] * 3];
+                    int fromCorner = 0, toCorner = -1;
+                    for (int corner = 0; corner < 3; corner++) {
+                        if (welded[triangle[corner]] == collapse.from) fromCorner = corner;
+                        if (welded[triangle[corner]] == collapse.to) toCorner = corner;
+                    }
+
+                    if (toCorner >= 0) {
+                        uint32_t wedge = triangle[fromCorner], replacement = triangle[toCorner];
+                        auto it = std::find_if(wedgeMoves.begin(), wedgeMoves.end(),
+                            [wedge](const std::pair<uint32_t, uint32_t>& move) { return move.first == wedge; });
+                        if (it == wedgeMoves.end()) {
+                            wedgeMoves.emplace_back(wedge, replacement);
+                        }
+                        else if (it->second != replacement) {
+                            valid = false; // the edge is a seam on the 'to' side only
+                        }
+                        collapsedTriangles++;
+                        continue;
+                    }
+
+                    glm::vec3 corners[3] = { positions[triangle[0]], positions[triangle[1]], positions[triangle[2]] };
+                    glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                    corners[fromCorner] = positions[collapse.to];
+                    glm::vec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                    // a big turn is close to a fold, even when it doesn't quite flip
+                    valid = glm::dot(before, after) > 0.25f * glm::length(before) * glm::length(after);
+                }
+                // a seam vertex has one vertex per side, both sides must reach 'to' (collapse along the seam)
+                for (uint32_t i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1] && valid; i++) {
+                    const uint32_t* triangle = &result[adjacency[i] * 3];
+                    for (int corner = 0; corner < 3; corner++) {
+                        uint32_t wedge = triangle[corner];
+                        if (welded[wedge] != collapse.from) continue;
+                        valid = std::any_of(wedgeMoves.begin(), wedgeMoves.end(),
+                            [wedge](const std::pair<uint32_t, uint32_t>& move) { return move.first == wedge; });
+                    }
+                }
+                if (!valid || collapsedTriangles == 0) continue;
+
+                for (const auto& move : wedgeMoves) {
+                    wedgeRemap[move.first] = move.second;
+                }
+                quadrics[collapse.to].add(quadrics[collapse.from]);
+                // the ring around it is settled for this pass, so later flip checks see its real shape
+                for (uint32_t i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1]; i++) {
+                    const uint32_t* triangle = &result[adjacency[i] * 3];
+                    touched[welded[triangle[0]]] = touched[welded[triangle[1]]] = touched[welded[triangle[2]]] = 1;
+                }
+                maxError = std::max(maxError, collapse.cost);
+                removed += collapsedTriangles;
+            }
+            if (removed == 0) break;
+
+            // --- Move the collapsed vertices, dropping the triangles that degenerated ---
+            size_t write = 0;
+            for (size_t t = 0; t < result.size(); t += 3) {
+                uint32_t a = wedgeRemap[result[t]], b = wedgeRemap[result[t + 1]], c = wedgeRemap[result[t + 2]];
+                if (welded[a] == welded[b] || welded[b] == welded[c] || welded[a] == welded[c]) continue;
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        error = static_cast<float>(std::sqrt(maxError));
+        return result;
+    }
+
+}  // namespace lve
@@ -0,0 +1,26 @@
+#pragma once
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+    // Quadric error metric simplification (Garland & Heckbert) by edge collapse onto existing
+    // vertices, so the result indexes the same vertices and every LOD can share one vertex buffer.
+    //
+    // Vertices sharing a position (UV or normal seams) are one vertex for the topology, open borders
+    // and seams only collapse along themselves so they keep their shape, and collapses that would
+    // flip a triangle are skipped. The result stays above the target when nothing else is allowed.
+    //
+    // Returns the new indices, error receives the largest distance (in the positions' space) the
+    // surface moved by, as estimated by the quadrics.
+    std::vector<uint32_t> simplifyMesh(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+        size_t targetIndexCount, float& error);
+
+}  // namespace lve
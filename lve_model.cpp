@@ -1,5 +1,6 @@
 #include "lve_model.h"
 #include "lve_utils.h"
+#include "lve_mesh_simplifier.h"
 
 // libs
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -8,6 +9,7 @@
 #include <glm/gtx/hash.hpp>
 
 // std
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <cstring>
@@ -26,10 +28,15 @@ namespace std {
 }
 
 namespace lve {
-    uint32_t LveModel::nextMeshId = 1;
+
+    // Share of in-between alpha texels above which a masked material is blended instead of cut out
+    constexpr float BLENDED_PARTIAL_ALPHA = 0.1f;
 
     // Mesh methods
-    LveModel::Mesh::Mesh() {}
+    LveModel::Mesh::Mesh() {
+        static uint32_t nextId = 0;
+        id = nextId++;
+    }
     LveModel::Mesh::~Mesh() {}
 
     void LveModel::Mesh::createVertexBuffers(LveDevice& device) {
@@ -49,17 +56,75 @@ namespace lve {
         stagingBuffer.map();
         stagingBuffer.writeToBuffer((void*)vertices.data());
 
+        // also addressable from shaders when supported, for the vertex pulling path
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        if (device.getFeatureSupport().bufferDeviceAddress) {
+            usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+        }
+
         vertexBuffer = std::make_unique<LveBuffer>(
             device,
             vertexSize,
             vertexCount,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            usage,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         );
 
         device.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
     }
 
+    void LveModel::Mesh::computeBounds() {
+        if (vertices.empty()) return;
+
+        boundsMin = boundsMax = vertices[0].position;
+        for (const auto& vertex : vertices) {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+
+        // centered on the box, slightly looser than a minimal sphere but cheap and stable
+        glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+        float radiusSquared = 0.f;
+        for (const auto& vertex : vertices) {
+            glm::vec3 offset = vertex.position - center;
+            radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+        }
+        boundingSphere = glm::vec4{ center, glm::sqrt(radiusSquared) };
+    }
+
+    void LveModel::Mesh::generateLods() {
+        lods.clear();
+        lodIndices.clear();
+        if (indices.empty()) return;
+        lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.f });
+
+        std::vector<glm::vec3> positions(vertices.size());
+        for (size_t v = 0; v < vertices.size(); v++) {
+            positions[v] = vertices[v].position;
+        }
+
+        // every level starts from the full mesh, so its error is measured against the original surface
+        for (uint32_t level = 1; level < MAX_LODS; level++) {
+            float error = 0.f;
+            std::vector<uint32_t> simplified = simplifyMesh(positions, indices, (indices.size() >> level) / 3 * 3, error);
+            // a level has to save a good part of the previous one to be worth switching to
+            if (simplified.empty() || simplified.size() > lods.back().indexCount * 3 / 4) break;
+
+            lods.push_back({
+                static_cast<uint32_t>(indices.size() + lodIndices.size()),
+                static_cast<uint32_t>(simplified.size()),
+                std::max(error, lods.back().error) });
+            lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.end());
+        }
+    }
+
+    uint32_t LveModel::Mesh::selectLod(float pixelsPerUnit) const {
+        for (uint32_t level = getLodCount() - 1; level > 0; level--) {
+            if (lods[level].error * pixelsPerUnit <= 1.f) return level;
+        }
+        return 0;
+    }
+
     void LveModel::Mesh::createIndexBuffers(LveDevice& device) {
         indexCount = static_cast<uint32_t>(indices.size());
         hasIndexBuffer = indexCount > 0;
@@ -67,25 +132,33 @@ namespace lve {
         if (!hasIndexBuffer) {
             return;
         }
+        if (lods.empty()) {
+            lods.push_back({ 0, indexCount, 0.f }); // no simplified levels
+        }
 
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
+        // full mesh first, the simplified levels after it
+        uint32_t totalIndexCount = indexCount + static_cast<uint32_t>(lodIndices.size());
+        VkDeviceSize bufferSize = sizeof(indices[0]) * totalIndexCount;
         uint32_t indexSize = sizeof(indices[0]);
 
         LveBuffer stagingBuffer{
             device,
             indexSize,
-            indexCount,
+            totalIndexCount,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
         };
 
         stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void*)indices.data());
+        stagingBuffer.writeToBuffer((void*)indices.data(), sizeof(indices[0]) * indexCount);
+        if (!lodIndices.empty()) {
+            stagingBuffer.writeToBuffer((void*)lodIndices.data(), sizeof(indices[0]) * lodIndices.size(), sizeof(indices[0]) * indexCount);
+        }
 
         indexBuffer = std::make_unique<LveBuffer>(
             device,
             indexSize,
-            indexCount,
+            totalIndexCount,
             VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         );
@@ -98,26 +171,54 @@ namespace lve {
         VkDeviceSize offsets[] = { 0 };
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
 
+        bindIndexBuffer(commandBuffer);
+    }
+
+    void LveModel::Mesh::bindIndexBuffer(VkCommandBuffer commandBuffer) {
         if (hasIndexBuffer) {
             vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
         }
     }
 
-    void LveModel::Mesh::draw(VkCommandBuffer commandBuffer) {
+    void LveModel::Mesh::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance, uint32_t lod) {
         if (hasIndexBuffer) {
-            vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+            const Lod& level = lods[std::min(lod, getLodCount() - 1)]; // meshes can have fewer levels than asked for
+            vkCmdDrawIndexed(commandBuffer, level.indexCount, instanceCount, level.firstIndex, 0, firstInstance);
         }
         else {
-            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+            vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
         }
     }
 
     // LveModel methods
-    LveModel::LveModel(LveDevice& device) : lveDevice{ device } {}
-    LveModel::~LveModel() {}
+    LveModel::LveModel(LveDevice& device, LveResourceManager& resourceManager)
+        : lveDevice{ device }, resourceManager{ resourceManager } {
+        static uint32_t nextId = 0;
+        id = nextId++;
+    }
 
-    std::unique_ptr<LveModel> LveModel::createModelFromFile(LveDevice& device, const std::string& filepath) {
-        auto model = std::make_unique<LveModel>(device);
+    uint32_t LveModel::selectLod(float pixelsPerUnit) const {
+        uint32_t level = Mesh::MAX_LODS - 1;
+        for (const auto& mesh : meshes) {
+            uint32_t meshLevel = mesh.selectLod(pixelsPerUnit);
+            if (meshLevel + 1 < mesh.getLodCount()) { // a mesh fine at its coarsest level doesn't limit the others
+                level = std::min(level, meshLevel);
+            }
+        }
+        return level;
+    }
+
+    LveModel::~LveModel() {
+        for (auto& mesh : meshes) {
+            if (resourceManager.isValid(mesh.fragmentBuffer.diffuseTexture)) {
+                resourceManager.release(mesh.fragmentBuffer.diffuseTexture);
+            }
+        }
+    }
+
+    std::unique_ptr<LveModel> LveModel::createModelFromFile(
+        LveDevice& device, LveResourceManager& resourceManager, const std::string& filepath) {
+        auto model = std::make_unique<LveModel>(device, resourceManager);
 
         std::string directory = filepath.substr(0, filepath.find_last_of('/'));
         tinyobj::attrib_t attrib;
@@ -192,18 +293,57 @@ namespace lve {
                 const auto& mat = materials[matId];
                 if (!mat.diffuse_texname.empty()) {
                     std::string fullPath = directory + "/" + mat.diffuse_texname;
-                    mesh.fragmentBuffer.diffuseTexture = LveTexture::createFromFile(device, fullPath);
+                    std::string maskPath = mat.alpha_texname.empty() ? "" : directory + "/" + mat.alpha_texname;
+                    mesh.fragmentBuffer.diffuseTexture = resourceManager.loadTexture(fullPath, maskPath);
+
+                    // a mask that is mostly 0 or 1 cuts out (fences, foliage), soft ones blend (decals, glass)
+                    if (mat.dissolve < 1.f) {
+                        mesh.fragmentBuffer.alphaMode = AlphaMode::Blended;
+                    }
+                    else if (!maskPath.empty()) {
+                        const LveTexture* texture = resourceManager.getTexture(mesh.fragmentBuffer.diffuseTexture);
+                        mesh.fragmentBuffer.alphaMode = texture->getPartialAlphaFraction() > BLENDED_PARTIAL_ALPHA
+                            ? AlphaMode::Blended : AlphaMode::Masked;
+                    }
                 }
             }
 
+            mesh.generateLods();
             mesh.createVertexBuffers(model->lveDevice);
             mesh.createIndexBuffers(model->lveDevice);
+            mesh.computeBounds();
 
-            model->meshes[LveModel::nextMeshId++] = std::move(mesh);
+            model->meshes.push_back(std::move(mesh));
+        }
+
+        for (size_t m = 0; m < model->meshes.size(); m++) {
+            const Mesh& mesh = model->meshes[m];
+            model->boundsMin = m == 0 ? mesh.boundsMin : glm::min(model->boundsMin, mesh.boundsMin);
+            model->boundsMax = m == 0 ? mesh.boundsMax : glm::max(model->boundsMax, mesh.boundsMax);
         }
 
         std::cout << "Loaded: " << filepath << "\n";
-        std::cout << "Mesh count: " << model->meshes.size() << "\n";
+        std::cout << "Mesh count: " << model->meshes.size();
+        size_t masked = std::count_if(model->meshes.begin(), model->meshes.end(),
+            [](const Mesh& mesh) { return mesh.fragmentBuffer.alphaMode == AlphaMode::Masked; });
+        size_t blended = std::count_if(model->meshes.begin(), model->meshes.end(),
+            [](const Mesh& mesh) { return mesh.fragmentBuffer.alphaMode == AlphaMode::Blended; });
+        if (masked + blended > 0) {
+            std::cout << " (" << masked << " masked, " << blended << " blended)";
+        }
+        std::cout << "\n";
+
+        uint32_t lodTriangles[Mesh::MAX_LODS] = {};
+        for (const auto& mesh : model->meshes) {
+            for (uint32_t level = 0; level < Mesh::MAX_LODS; level++) {
+                lodTriangles[level] += mesh.lods.empty() ? 0 : mesh.lods[std::min(level, mesh.getLodCount() - 1)].indexCount / 3;
+            }
+        }
+        std::cout << "Triangles per LOD:";
+        for (uint32_t triangles : lodTriangles) {
+            std::cout << " " << triangles;
+        }
+        std::cout << "\n";
 
         return model;
     }
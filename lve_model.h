@@ -2,7 +2,7 @@
 
 #include "lve_device.h"
 #include "lve_buffer.h"
-#include "lve_texture.h"
+#include "lve_resource_manager.h"
 
 //libs
 #define GLM_FORCE_RADIANS
@@ -12,12 +12,19 @@
 //std
 #include <memory>
 #include <vector>
-#include <unordered_map>
 
 namespace lve {
 
+    // How a material uses its diffuse alpha, which picks the render bucket its meshes draw in
+    enum class AlphaMode : uint8_t {
+        Opaque,  // alpha ignored, no discard, so early depth testing stays on
+        Masked,  // cut out at half alpha, with alpha-to-coverage under MSAA
+        Blended, // blended over what is behind it, drawn back to front after the rest, no depth writes
+    };
+
     struct FragmentBuffer {
-        std::shared_ptr<LveTexture> diffuseTexture;
+        TextureHandle diffuseTexture{};
+        AlphaMode alphaMode = AlphaMode::Opaque;
     };
 
     class LveModel {
@@ -37,8 +44,20 @@ namespace lve {
         };
 
         struct Mesh {
+            static constexpr uint32_t MAX_LODS = 4;
+
+            // lods[0] is the full mesh, each next level has about half the triangles. The simplified
+            // levels index the same vertices and live after the full mesh in the index buffer.
+            struct Lod {
+                uint32_t firstIndex = 0;
+                uint32_t indexCount = 0;
+                float error = 0.f; // how far (local space) the surface may be from the full mesh
+            };
+
             std::vector<Vertex> vertices;
             std::vector<uint32_t> indices;
+            std::vector<uint32_t> lodIndices; // levels 1+, uploaded after indices
+            std::vector<Lod> lods;
             FragmentBuffer fragmentBuffer;
 
             std::unique_ptr<LveBuffer> vertexBuffer;
@@ -47,28 +66,56 @@ namespace lve {
             uint32_t indexCount;
             bool hasIndexBuffer = false;
 
+            // local space bounds, filled by computeBounds() when the mesh is loaded
+            glm::vec3 boundsMin{ 0.f };
+            glm::vec3 boundsMax{ 0.f };
+            glm::vec4 boundingSphere{ 0.f }; // xyz center, w radius
+
             Mesh();
             ~Mesh();
             Mesh(Mesh&&) = default;
             Mesh& operator=(Mesh&&) = default;
             void createVertexBuffers(LveDevice& device);
             void createIndexBuffers(LveDevice& device);
+            void computeBounds();
+            // Quadric simplification of indices into lods, before createIndexBuffers
+            void generateLods();
+            // Coarsest level whose error stays under one unit of pixelsPerUnit, i.e. the pixels a local
+            // space unit covers at the mesh's distance divided by the allowed screen space error
+            uint32_t selectLod(float pixelsPerUnit) const;
+            uint32_t getLodCount() const { return lods.empty() ? 1 : static_cast<uint32_t>(lods.size()); }
             void bind(VkCommandBuffer commandBuffer);
-            void draw(VkCommandBuffer commandBuffer);
+            void bindIndexBuffer(VkCommandBuffer commandBuffer); // vertex pulling reads vertices itself
+            void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0, uint32_t lod = 0);
+            VkDeviceAddress getVertexAddress() const { return vertexBuffer->getDeviceAddress(); }
+            uint32_t getId() const { return id; } // dense over all meshes created, the mesh field of draw sort keys
+
+        private:
+            uint32_t id;
         };
 
-        LveModel(LveDevice& device);
+        LveModel(LveDevice& device, LveResourceManager& resourceManager);
         ~LveModel();
 
         LveModel(const LveModel&) = delete;
         LveModel& operator=(const LveModel&) = delete;
 
-        static std::unique_ptr<LveModel> createModelFromFile(LveDevice& device, const std::string& filepath);
+        static std::unique_ptr<LveModel> createModelFromFile(
+            LveDevice& device, LveResourceManager& resourceManager, const std::string& filepath);
+
+        uint32_t getId() const { return id; } // unique per model, keys the instance groups
+        // Level for all meshes at once (instancing): the coarsest one every mesh allows, see Mesh::selectLod
+        uint32_t selectLod(float pixelsPerUnit) const;
 
         LveDevice& lveDevice;
+        LveResourceManager& resourceManager;
+
+        std::vector<Mesh> meshes;
+        glm::vec3 boundsMin{ 0.f }; // union of the mesh bounds
+        glm::vec3 boundsMax{ 0.f };
 
-        std::unordered_map<uint32_t, Mesh> meshes;
-        static uint32_t nextMeshId;
+    private:
+        uint32_t id;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,306 @@
+#include "lve_occlusion.h"
+
+#include "lve_model.h"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <immintrin.h>
+#include <unordered_map>
+
+namespace lve {
+
+    constexpr uint32_t TRIANGLES_PER_CHUNK = 512;
+    constexpr uint32_t BOXES_PER_CHUNK = 256;
+
+    std::unique_ptr<LveOccluder> LveOccluder::createFromModel(const LveModel& model, uint32_t maxTriangles) {
+        struct Candidate {
+            float area;
+            uint32_t mesh;
+            uint32_t firstIndex;
+        };
+        std::vector<Candidate> candidates;
+        for (uint32_t m = 0; m < model.meshes.size(); m++) {
+            const auto& mesh = model.meshes[m];
+            if (mesh.fragmentBuffer.alphaMode != AlphaMode::Opaque) continue; // fences and glass hide nothing
+            for (uint32_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+                const glm::vec3& p0 = mesh.vertices[mesh.indices[i]].position;
+                const glm::vec3& p1 = mesh.vertices[mesh.indices[i + 1]].position;
+                const glm::vec3& p2 = mesh.vertices[mesh.indices[i + 2]].position;
+                float area = glm::length(glm::cross(p1 - p0, p2 - p0)) * 0.5f;
+                if (area > 0.f) {
+                    candidates.push_back({ area, m, i });
+                }
+            }
+        }
+
+        // walls and roofs are what hides things, small detail triangles barely ever do
+        if (candidates.size() > maxTriangles) {
+            std::nth_element(candidates.begin(), candidates.begin() + maxTriangles, candidates.end(),
+                [](const Candidate& a, const Candidate& b) { return a.area > b.area; });
+            candidates.resize(maxTriangles);
+        }
+
+        auto occluder = std::make_unique<LveOccluder>();
+        std::unordered_map<uint64_t, uint32_t> remap; // (mesh, vertex) -> occluder vertex
+        for (const auto& candidate : candidates) {
+            const auto& mesh = model.meshes[candidate.mesh];
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                uint32_t vertex = mesh.indices[candidate.firstIndex + corner];
+                uint64_t key = (static_cast<uint64_t>(candidate.mesh) << 32) | vertex;
+                auto it = remap.find(key);
+                if (it == remap.end()) {
+                    it = remap.emplace(key, static_cast<uint32_t>(occluder->positions.size())).first;
+                    occluder->positions.push_back(mesh.vertices[vertex].position);
+                }
+                occluder->indices.push_back(it->second);
+            }
+        }
+        return occluder;
+    }
+
+    LveOcclusionBuffer::LveOcclusionBuffer(uint32_t width, uint32_t height, uint32_t threadCount)
+        : width{ width }, height{ height }, threadPool{ threadCount } {
+        assert(width % TILE_WIDTH == 0 && height % TILE_HEIGHT == 0 && "Occlusion buffer size must be a multiple of the tile size");
+        tilesX = width / TILE_WIDTH;
+        tilesY = height / TILE_HEIGHT;
+        depth.assign(width * height, 1.f);
+        tileMaxDepth.assign(tilesX * tilesY, 1.f);
+        bins.resize(threadPool.getThreadCount());
+        for (auto& threadBins : bins) {
+            threadBins.tiles.resize(tilesX * tilesY);
+        }
+    }
+
+    void LveOcclusionBuffer::begin(const glm::mat4& newViewProjection) {
+        viewProjection = newViewProjection;
+        occluders.clear();
+        std::fill(depth.begin(), depth.end(), 1.f);
+        std::fill(tileMaxDepth.begin(), tileMaxDepth.end(), 1.f);
+    }
+
+    void LveOcclusionBuffer::addOccluder(const LveOccluder& occluder, const glm::mat4& modelMatrix) {
+        occluders.push_back({ &occluder, viewProjection * modelMatrix });
+    }
+
+    void LveOcclusionBuffer::rasterize() {
+        // --- Split the occluders into chunks of triangles, each set up and binned by one thread ---
+        chunks.clear();
+        for (uint32_t o = 0; o < occluders.size(); o++) {
+            uint32_t triangleCount = occluders[o].occluder->getTriangleCount();
+            for (uint32_t first = 0; first < triangleCount; first += TRIANGLES_PER_CHUNK) {
+                chunks.push_back({ o, first, std::min(TRIANGLES_PER_CHUNK, triangleCount - first) });
+            }
+        }
+        for (auto& threadBins : bins) {
+            threadBins.triangles.clear();
+            for (auto& tile : threadBins.tiles) {
+                tile.clear(); // keeps capacity across frames
+            }
+        }
+
+        threadPool.parallelFor(static_cast<uint32_t>(chunks.size()), [this](uint32_t index, uint32_t thread) {
+            setupChunk(chunks[index], bins[thread]);
+        });
+
+        rasterizedTriangles = 0;
+        for (const auto& threadBins : bins) {
+            rasterizedTriangles += static_cast<uint32_t>(threadBins.triangles.size());
+        }
+
+        // --- Every tile is owned by one thread, no two threads write the same pixels ---
+        threadPool.parallelFor(tilesX * tilesY, [this](uint32_t tile, uint32_t) {
+            rasterizeTile(tile);
+        });
+    }
+
+    void LveOcclusionBuffer::setupChunk(const Chunk& chunk, ThreadBins& threadBins) const {
+        const OccluderInstance& instance = occluders[chunk.occluder];
+        const LveOccluder& occluder = *instance.occluder;
+        const float halfWidth = width * 0.5f;
+        const float halfHeight = height * 0.5f;
+
+        for (uint32_t t = chunk.firstTriangle; t < chunk.firstTriangle + chunk.triangleCount; t++) {
+            float x[3], y[3], z[3];
+            bool clipped = false;
+            for (int corner = 0; corner < 3; corner++) {
+                glm::vec4 clip = instance.modelViewProjection * glm::vec4(occluder.positions[occluder.indices[t * 3 + corner]], 1.f);
+                // triangles crossing the near plane are dropped, losing an occluder is always safe
+                if (clip.w <= 1e-5f || clip.z < 0.f) {
+                    clipped = true;
+                    break;
+                }
+                float invW = 1.f / clip.w;
+                x[corner] = (clip.x * invW + 1.f) * halfWidth;
+                y[corner] = (clip.y * invW + 1.f) * halfHeight;
+                z[corner] = clip.z * invW;
+            }
+            if (clipped) continue;
+
+            // front faces are clockwise in framebuffer space (y down), positive here; back faces
+            // are hidden by the front ones of a closed occluder anyway
+            float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+            if (area <= 0.f) continue;
+
+            Triangle triangle;
+            triangle.minX = std::max(0, static_cast<int32_t>(std::floor(std::min({ x[0], x[1], x[2] }))));
+            triangle.minY = std::max(0, static_cast<int32_t>(std::floor(std::min({ y[0], y[1], y[2] }))));
+            triangle.maxX = std::min(static_cast<int32_t>(width) - 1, static_cast<int32_t>(std::floor(std::max({ x[0], x[1], x[2] }))));
+            triangle.maxY = std::min(static_cast<int32_t>(height) - 1, static_cast<int32_t>(std::floor(std::max({ y[0], y[1], y[2] }))));
+            if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) continue; // off screen
+
+            for (int edge = 0; edge < 3; edge++) {
+                int next = (edge + 1) % 3;
+                triangle.edgeA[edge] = y[edge] - y[next];
+                triangle.edgeB[edge] = x[next] - x[edge];
+                triangle.edgeC[edge] = (y[next] - y[edge]) * x[edge] - (x[next] - x[edge]) * y[edge];
+            }
+            float invArea = 1.f / area;
+            triangle.depthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) * invArea;
+            triangle.depthB = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) * invArea;
+            triangle.depthC = z[0] - triangle.depthA * x[0] - triangle.depthB * y[0];
+
+            uint32_t index = static_cast<uint32_t>(threadBins.triangles.size());
+            threadBins.triangles.push_back(triangle);
+            for (int32_t ty = triangle.minY / TILE_HEIGHT; ty <= triangle.maxY / static_cast<int32_t>(TILE_HEIGHT); ty++) {
+                for (int32_t tx = triangle.minX / TILE_WIDTH; tx <= triangle.maxX / static_cast<int32_t>(TILE_WIDTH); tx++) {
+                    threadBins.tiles[ty * tilesX + tx].push_back(index);
+                }
+            }
+        }
+    }
+
+    void LveOcclusionBuffer::rasterizeTile(uint32_t tile) {
+        const int32_t tileX0 = static_cast<int32_t>((tile % tilesX) * TILE_WIDTH);
+        const int32_t tileY0 = static_cast<int32_t>((tile / tilesX) * TILE_HEIGHT);
+        const int32_t tileX1 = tileX0 + TILE_WIDTH - 1;
+        const int32_t tileY1 = tileY0 + TILE_HEIGHT - 1;
+        const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f); // pixel centers
+        const __m128 zero = _mm_setzero_ps();
+
+        for (const auto& threadBins : bins) {
+            for (uint32_t index : threadBins.tiles[tile]) {
+                const Triangle& triangle = threadBins.triangles[index];
+                int32_t x0 = std::max(triangle.minX, tileX0) & ~3; // tiles start on multiples of 4
+                int32_t x1 = std::min(triangle.maxX, tileX1);
+                int32_t y0 = std::max(triangle.minY, tileY0);
+                int32_t y1 = std::min(triangle.maxY, tileY1);
+
+                const __m128 a0 = _mm_set1_ps(triangle.edgeA[0]), a1 = _mm_set1_ps(triangle.edgeA[1]), a2 = _mm_set1_ps(triangle.edgeA[2]);
+                const __m128 depthA = _mm_set1_ps(triangle.depthA);
+                for (int32_t y = y0; y <= y1; y++) {
+                    float py = y + 0.5f;
+                    __m128 rowEdge0 = _mm_set1_ps(triangle.edgeB[0] * py + triangle.edgeC[0]);
+                    __m128 rowEdge1 = _mm_set1_ps(triangle.edgeB[1] * py + triangle.edgeC[1]);
+                    __m128 rowEdge2 = _mm_set1_ps(triangle.edgeB[2] * py + triangle.edgeC[2]);
+                    __m128 rowDepth = _mm_set1_ps(triangle.depthB * py + triangle.depthC);
+                    float* row = &depth[y * width];
+
+                    for (int32_t x = x0; x <= x1; x += 4) {
+                        __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+                        __m128 inside = _mm_and_ps(
+                            _mm_and_ps(
+                                _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), rowEdge0), zero),
+                                _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), rowEdge1), zero)),
+                            _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), rowEdge2), zero));
+                        if (_mm_movemask_ps(inside) == 0) continue;
+
+                        __m128 z = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+                        __m128 current = _mm_loadu_ps(row + x);
+                        __m128 nearest = _mm_min_ps(current, z);
+                        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+                    }
+                }
+            }
+        }
+
+        // farthest depth left in the tile, anything behind it is hidden without looking at pixels
+        __m128 farthest = zero;
+        for (int32_t y = tileY0; y <= tileY1; y++) {
+            const float* row = &depth[y * width];
+            for (int32_t x = tileX0; x <= tileX1; x += 4) {
+                farthest = _mm_max_ps(farthest, _mm_loadu_ps(row + x));
+            }
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, farthest);
+        tileMaxDepth[tile] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    }
+
+    bool LveOcclusionBuffer::isVisible(const glm::vec3& center, const glm::vec3& extent) const {
+        // --- Screen rectangle and nearest depth of the box ---
+        float minX = static_cast<float>(width), minY = static_cast<float>(height);
+        float maxX = 0.f, maxY = 0.f;
+        float nearestDepth = 1.f;
+        for (int i = 0; i < 8; i++) {
+            glm::vec3 corner = center + extent * glm::vec3{ (i & 1) ? 1.f : -1.f, (i & 2) ? 1.f : -1.f, (i & 4) ? 1.f : -1.f };
+            glm::vec4 clip = viewProjection * glm::vec4(corner, 1.f);
+            if (clip.w <= 1e-5f || clip.z < 0.f) return true; // reaches past the near plane
+            float invW = 1.f / clip.w;
+            float x = (clip.x * invW + 1.f) * width * 0.5f;
+            float y = (clip.y * invW + 1.f) * height * 0.5f;
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            maxX = std::max(maxX, x);
+            maxY = std::max(maxY, y);
+            nearestDepth = std::min(nearestDepth, clip.z * invW);
+        }
+
+        int32_t x0 = std::max(0, static_cast<int32_t>(std::floor(minX)));
+        int32_t y0 = std::max(0, static_cast<int32_t>(std::floor(minY)));
+        int32_t x1 = std::min(static_cast<int32_t>(width) - 1, static_cast<int32_t>(std::floor(maxX)));
+        int32_t y1 = std::min(static_cast<int32_t>(height) - 1, static_cast<int32_t>(std::floor(maxY)));
+        if (x0 > x1 || y0 > y1) return true; // off screen, that's for frustum culling to decide
+
+        // --- Visible as soon as one pixel it touches is not nearer than the box ---
+        const __m128 nearest = _mm_set1_ps(nearestDepth);
+        const __m128i laneIndices = _mm_setr_epi32(0, 1, 2, 3);
+        for (int32_t ty = y0 / TILE_HEIGHT; ty <= y1 / static_cast<int32_t>(TILE_HEIGHT); ty++) {
+            for (int32_t tx = x0 / TILE_WIDTH; tx <= x1 / static_cast<int32_t>(TILE_WIDTH); tx++) {
+                if (nearestDepth > tileMaxDepth[ty * tilesX + tx]) continue; // hidden in the whole tile
+
+                int32_t rowStart = std::max(x0, tx * static_cast<int32_t>(TILE_WIDTH));
+                int32_t rowEnd = std::min(x1, (tx + 1) * static_cast<int32_t>(TILE_WIDTH) - 1);
+                int32_t yStart = std::max(y0, ty * static_cast<int32_t>(TILE_HEIGHT));
+                int32_t yEnd = std::min(y1, (ty + 1) * static_cast<int32_t>(TILE_HEIGHT) - 1);
+                for (int32_t y = yStart; y <= yEnd; y++) {
+                    const float* row = &depth[y * width];
+                    for (int32_t x = rowStart & ~3; x <= rowEnd; x += 4) {
+                        // only the lanes inside [rowStart, rowEnd] count
+                        __m128i lane = _mm_add_epi32(_mm_set1_epi32(x), laneIndices);
+                        __m128i inRange = _mm_and_si128(
+                            _mm_cmpgt_epi32(lane, _mm_set1_epi32(rowStart - 1)),
+                            _mm_cmplt_epi32(lane, _mm_set1_epi32(rowEnd + 1)));
+                        __m128 notHidden = _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), nearest), _mm_castsi128_ps(inRange));
+                        if (_mm_movemask_ps(notHidden) != 0) return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    uint32_t LveOcclusionBuffer::testBoxes(const LveBoundsSoA& bounds, std::vector<uint8_t>& visible) {
+        assert(visible.size() >= bounds.size() && "Visibility must have one entry per box");
+        const uint32_t count = static_cast<uint32_t>(bounds.size());
+        std::atomic<uint32_t> hiddenCount{ 0 };
+        threadPool.parallelFor((count + BOXES_PER_CHUNK - 1) / BOXES_PER_CHUNK, [&](uint32_t chunk, uint32_t) {
+            uint32_t hidden = 0;
+            uint32_t end = std::min(count, (chunk + 1) * BOXES_PER_CHUNK);
+            for (uint32_t i = chunk * BOXES_PER_CHUNK; i < end; i++) {
+                if (!visible[i]) continue;
+                glm::vec3 center{ bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i] };
+                glm::vec3 extent{ bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i] };
+                if (!isVisible(center, extent)) {
+                    visible[i] = 0;
+                    hidden++;
+                }
+            }
+            hiddenCount += hidden;
+        });
+        return hiddenCount;
+    }
+
+}  // namespace lve
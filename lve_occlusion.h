@@ -0,0 +1,112 @@
+#pragma once
+
+#include "lve_frustum.h"
+#include "lve_thread_pool.h"
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+    class LveModel;
+
+    // Stand-in geometry an object is rasterized with into the occlusion buffer: the largest of the
+    // model's own opaque triangles, so it is cheap to draw and never hides more than the model itself
+    struct LveOccluder {
+        std::vector<glm::vec3> positions; // local space
+        std::vector<uint32_t> indices;
+
+        static std::unique_ptr<LveOccluder> createFromModel(const LveModel& model, uint32_t maxTriangles = 4096);
+        uint32_t getTriangleCount() const { return static_cast<uint32_t>(indices.size() / 3); }
+    };
+
+    // Low resolution depth buffer rasterized on the CPU from occluders, to reject objects hidden
+    // behind them before they are drawn when GPU culling isn't available. The screen is split into
+    // tiles: triangles are set up and binned per tile in parallel, then each tile is rasterized by
+    // one thread, 4 pixels at a time with SSE. Pixels keep the nearest occluder depth ([0,1] like
+    // the swap chain), tiles the farthest of their pixels for a quick reject in the tests.
+    //
+    // Coverage is sampled at pixel centers, so occluder edges can hide a little more than they
+    // really do at this resolution; objects are tested with the whole pixels their box touches.
+    class LveOcclusionBuffer {
+    public:
+        static constexpr uint32_t TILE_WIDTH = 32; // multiple of 4 for the SIMD rows
+        static constexpr uint32_t TILE_HEIGHT = 16;
+
+        // width and height must be multiples of the tile size, threadCount 0 uses every hardware thread
+        LveOcclusionBuffer(uint32_t width = 320, uint32_t height = 192, uint32_t threadCount = 0);
+
+        LveOcclusionBuffer(const LveOcclusionBuffer&) = delete;
+        LveOcclusionBuffer& operator=(const LveOcclusionBuffer&) = delete;
+
+        // Clears the buffer for a new camera and forgets the occluders of the last frame
+        void begin(const glm::mat4& viewProjection);
+        // The occluder is referenced until rasterize() returns
+        void addOccluder(const LveOccluder& occluder, const glm::mat4& modelMatrix);
+        void rasterize();
+
+        // World space box as center/extent, false only if it is behind the occluders everywhere
+        bool isVisible(const glm::vec3& center, const glm::vec3& extent) const;
+        // Tests every box with visible[i] set (e.g. after cullBoxes) and clears it for the hidden
+        // ones, in parallel. Returns the number of boxes that were hidden.
+        uint32_t testBoxes(const LveBoundsSoA& bounds, std::vector<uint8_t>& visible);
+
+        uint32_t getWidth() const { return width; }
+        uint32_t getHeight() const { return height; }
+        uint32_t getThreadCount() const { return threadPool.getThreadCount(); }
+        // Triangles that were binned last rasterize(), after clipping and back faces
+        uint32_t getRasterizedTriangleCount() const { return rasterizedTriangles; }
+        const std::vector<float>& getDepth() const { return depth; }
+
+    private:
+        // Edge functions are A * x + B * y + C, positive inside, and so is the depth plane
+        struct Triangle {
+            float edgeA[3], edgeB[3], edgeC[3];
+            float depthA, depthB, depthC;
+            int32_t minX, minY, maxX, maxY; // pixels, inclusive and on screen
+        };
+
+        struct OccluderInstance {
+            const LveOccluder* occluder;
+            glm::mat4 modelViewProjection;
+        };
+
+        struct Chunk {
+            uint32_t occluder;
+            uint32_t firstTriangle;
+            uint32_t triangleCount;
+        };
+
+        // Set up triangles and per-tile lists of indices into them, written by one thread each
+        struct ThreadBins {
+            std::vector<Triangle> triangles;
+            std::vector<std::vector<uint32_t>> tiles;
+        };
+
+        void setupChunk(const Chunk& chunk, ThreadBins& bins) const;
+        void rasterizeTile(uint32_t tile);
+
+        uint32_t width;
+        uint32_t height;
+        uint32_t tilesX;
+        uint32_t tilesY;
+        LveThreadPool threadPool;
+
+        glm::mat4 viewProjection{ 1.f };
+        std::vector<OccluderInstance> occluders;
+        std::vector<Chunk> chunks;
+        std::vector<ThreadBins> bins; // one per thread
+        uint32_t rasterizedTriangles = 0;
+
+        std::vector<float> depth;        // width * height, row major
+        std::vector<float> tileMaxDepth; // tilesX * tilesY
+    };
+
+}  // namespace lve
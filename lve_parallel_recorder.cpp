@@ -0,0 +1,117 @@
+#include "lve_parallel_recorder.h"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+    void beginSecondaryCommandBuffer(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer,
+        VkExtent2D extent, VkCommandBufferUsageFlags flags) {
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = framebuffer;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = flags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin secondary command buffer!");
+        }
+
+        VkViewport viewport{};
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{ {0, 0}, extent };
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+
+    LveParallelRecorder::LveParallelRecorder(LveDevice& device, uint32_t threadCount)
+        : lveDevice{ device }, threadPool{ threadCount } {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT; // reset as a whole every frame
+
+        for (auto& pools : framePools) {
+            pools.resize(threadPool.getThreadCount());
+            for (auto& pool : pools) {
+                if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &pool.commandPool) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create secondary command pool!");
+                }
+            }
+        }
+    }
+
+    LveParallelRecorder::~LveParallelRecorder() {
+        for (auto& pools : framePools) {
+            for (auto& pool : pools) {
+                vkDestroyCommandPool(lveDevice.device(), pool.commandPool, nullptr); // frees its buffers
+            }
+        }
+    }
+
+    void LveParallelRecorder::beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent) {
+        assert(frameIndex >= 0 && frameIndex < LveSwapChain::MAX_FRAMES_IN_FLIGHT && "Frame index out of range");
+        this->frameIndex = frameIndex;
+        this->renderPass = renderPass;
+        this->framebuffer = framebuffer;
+        this->extent = extent;
+        recorded.clear();
+
+        for (auto& pool : framePools[frameIndex]) {
+            if (pool.usedCount == 0) continue;
+            if (vkResetCommandPool(lveDevice.device(), pool.commandPool, 0) != VK_SUCCESS) {
+                throw std::runtime_error("failed to reset secondary command pool!");
+            }
+            pool.usedCount = 0;
+        }
+    }
+
+    VkCommandBuffer LveParallelRecorder::acquireCommandBuffer(ThreadCommands& pool) {
+        if (pool.usedCount == pool.commandBuffers.size()) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = pool.commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate secondary command buffer!");
+            }
+            pool.commandBuffers.push_back(commandBuffer);
+        }
+        return pool.commandBuffers[pool.usedCount++];
+    }
+
+    void LveParallelRecorder::record(uint32_t jobCount, const Job& job) {
+        assert(renderPass != VK_NULL_HANDLE && "Call beginFrame before recording");
+        size_t firstSlot = recorded.size();
+        recorded.resize(firstSlot + jobCount);
+
+        auto& pools = framePools[frameIndex];
+        threadPool.parallelFor(jobCount, [&](uint32_t index, uint32_t threadIndex) {
+            VkCommandBuffer commandBuffer = acquireCommandBuffer(pools[threadIndex]);
+            beginSecondaryCommandBuffer(commandBuffer, renderPass, framebuffer, extent, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            job(index, commandBuffer);
+
+            if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to record secondary command buffer!");
+            }
+            recorded[firstSlot + index] = commandBuffer;
+        });
+    }
+
+    void LveParallelRecorder::execute(VkCommandBuffer primaryCommandBuffer) {
+        if (recorded.empty()) return;
+        vkCmdExecuteCommands(primaryCommandBuffer, static_cast<uint32_t>(recorded.size()), recorded.data());
+    }
+
+}  // namespace lve
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "lve_device.h"
+#include "lve_swap_chain.h"
+#include "lve_thread_pool.h"
+
+// std
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace lve {
+
+    // Begins a secondary command buffer continuing subpass 0 of renderPass. The viewport and
+    // scissor are set to extent since dynamic state isn't inherited from the primary.
+    void beginSecondaryCommandBuffer(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer,
+        VkExtent2D extent, VkCommandBufferUsageFlags flags);
+
+    // Records the contents of a render pass on worker threads. Every job gets its own secondary
+    // command buffer that continues the pass, allocated from a pool of the thread running it, with
+    // one set of pools per frame in flight so they can be reset without waiting on the GPU.
+    //
+    // The pass has to be begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, then nothing but
+    // execute() may go into it.
+    class LveParallelRecorder {
+    public:
+        // job is the index passed to record(), the viewport and scissor are already set
+        using Job = std::function<void(uint32_t job, VkCommandBuffer commandBuffer)>;
+
+        // threadCount includes the calling thread, 0 uses every hardware thread
+        explicit LveParallelRecorder(LveDevice& device, uint32_t threadCount = 0);
+        ~LveParallelRecorder();
+
+        LveParallelRecorder(const LveParallelRecorder&) = delete;
+        LveParallelRecorder& operator=(const LveParallelRecorder&) = delete;
+
+        // Resets the pools of frameIndex, the command buffers recorded with them last time around
+        // must have finished executing. framebuffer may be VK_NULL_HANDLE when it isn't known.
+        void beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+        // Runs job for every index in [0, jobCount) on the worker threads (a single job runs on the
+        // calling thread), can be called several times per frame. The command buffers are executed
+        // in record() and job order.
+        void record(uint32_t jobCount, const Job& job);
+        // Executes a command buffer recorded elsewhere (e.g. a cached one) at this point of the order
+        void add(VkCommandBuffer commandBuffer) { recorded.push_back(commandBuffer); }
+        void execute(VkCommandBuffer primaryCommandBuffer);
+
+        uint32_t getThreadCount() const { return threadPool.getThreadCount(); }
+
+    private:
+        struct ThreadCommands {
+            VkCommandPool commandPool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> commandBuffers; // allocated so far, reused after a reset
+            uint32_t usedCount = 0;
+        };
+
+        VkCommandBuffer acquireCommandBuffer(ThreadCommands& pool);
+
+        LveDevice& lveDevice;
+        LveThreadPool threadPool;
+        std::array<std::vector<ThreadCommands>, LveSwapChain::MAX_FRAMES_IN_FLIGHT> framePools; // per thread
+
+        int frameIndex = 0;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkExtent2D extent{};
+        std::vector<VkCommandBuffer> recorded; // this frame's, in execution order
+    };
+
+}  // namespace lve
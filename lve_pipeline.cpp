@@ -21,14 +21,20 @@ namespace lve {
     LvePipeline::~LvePipeline() {
         vkDestroyShaderModule(lveDevice.device(), vertShaderModule, nullptr);
         vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
-        vkDestroyPipeline(lveDevice.device(), graphicsPipeline, nullptr);
+
+        // command buffers still in flight may have the pipeline bound
+        lveDevice.deletionQueue().retire([device = lveDevice.device(), pipeline = graphicsPipeline]() {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        });
     }
 
     std::vector<char> LvePipeline::readFile(const std::string& filepath) {
         std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
 
         if (!file.is_open()) {
-            throw std::runtime_error("failed to open file: " + filepath);
+            // the .spv files are build outputs of compile.bat
+            throw std::runtime_error("failed to open file: " + filepath + (filepath.size() >= 4 &&
+                filepath.compare(filepath.size() - 4, 4, ".spv") == 0 ? " (run compile.bat to build the shaders)" : ""));
         }
 
         size_t fileSize = static_cast<size_t>(file.tellg());
@@ -53,10 +59,11 @@ namespace lve {
             "Cannot create graphics pipeline: no renderPass provided in configInfo");
 
         auto vertCode = readFile(vertFilepath);
-        auto fragCode = readFile(fragFilepath);
-
         createShaderModule(vertCode, &vertShaderModule);
-        createShaderModule(fragCode, &fragShaderModule);
+        if (!fragFilepath.empty()) {
+            auto fragCode = readFile(fragFilepath);
+            createShaderModule(fragCode, &fragShaderModule);
+        }
 
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -85,7 +92,7 @@ namespace lve {
 
         VkGraphicsPipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = 2;
+        pipelineInfo.stageCount = fragShaderModule != VK_NULL_HANDLE ? 2 : 1;
         pipelineInfo.pStages = shaderStages;
         pipelineInfo.pVertexInputState = &vertexInputInfo;
         pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
@@ -218,4 +225,51 @@ namespace lve {
         configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
 	}
 
+
+    LveComputePipeline::LveComputePipeline(
+        LveDevice& device,
+        const std::string& compFilepath,
+        VkPipelineLayout pipelineLayout)
+        : lveDevice{ device } {
+        assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided");
+
+        auto compCode = LvePipeline::readFile(compFilepath);
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = compCode.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t*>(compCode.data());
+
+        VkShaderModule compShaderModule;
+        if (vkCreateShaderModule(lveDevice.device(), &moduleInfo, nullptr, &compShaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shader module");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = compShaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineIndex = -1;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        VkResult result = vkCreateComputePipelines(lveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline);
+        // the module is only needed while the pipeline is created
+        vkDestroyShaderModule(lveDevice.device(), compShaderModule, nullptr);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create compute pipeline");
+        }
+    }
+
+    LveComputePipeline::~LveComputePipeline() {
+        lveDevice.deletionQueue().retire([device = lveDevice.device(), pipeline = computePipeline]() {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        });
+    }
+
+    void LveComputePipeline::bind(VkCommandBuffer commandBuffer) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    }
+
 }  // namespace lve
\ No newline at end of file
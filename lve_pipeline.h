@@ -31,6 +31,7 @@ namespace lve {
 
     class LvePipeline {
     public:
+        // An empty fragFilepath makes a pipeline without fragment shader, for depth-only passes
         LvePipeline(
             LveDevice& device,
             const std::string& vertFilepath,
@@ -47,9 +48,10 @@ namespace lve {
         static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
         static void enableAlphaBlending(PipelineConfigInfo& configInfo);
 
-    private:
         static std::vector<char> readFile(const std::string& filepath);
 
+    private:
+
         void createGraphicsPipeline(
             const std::string& vertFilepath,
             const std::string& fragFilepath,
@@ -60,6 +62,25 @@ namespace lve {
         LveDevice& lveDevice;
         VkPipeline graphicsPipeline;
         VkShaderModule vertShaderModule;
-        VkShaderModule fragShaderModule;
+        VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+    };
+
+    // Single compute shader stage, dispatched outside of render passes
+    class LveComputePipeline {
+    public:
+        LveComputePipeline(
+            LveDevice& device,
+            const std::string& compFilepath,
+            VkPipelineLayout pipelineLayout);
+        ~LveComputePipeline();
+
+        LveComputePipeline(const LveComputePipeline&) = delete;
+        LveComputePipeline& operator=(const LveComputePipeline&) = delete;
+
+        void bind(VkCommandBuffer commandBuffer);
+
+    private:
+        LveDevice& lveDevice;
+        VkPipeline computePipeline;
     };
 }  // namespace lve
\ No newline at end of file
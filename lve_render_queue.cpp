@@ -0,0 +1,64 @@
+#include "lve_render_queue.h"
+
+// std
+#include <algorithm>
+
+namespace lve {
+
+    uint64_t SortKey::make(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth01, bool invertDepth) {
+        constexpr uint32_t DEPTH_MAX = (1u << DEPTH_BITS) - 1;
+        float clamped = std::min(std::max(depth01, 0.f), 1.f);
+        uint32_t depth = static_cast<uint32_t>(clamped * DEPTH_MAX);
+        if (invertDepth) {
+            depth = DEPTH_MAX - depth;
+        }
+
+        // fields wider than their slot are truncated, that only costs some batching, never correctness
+        uint64_t key = pass & ((1u << PASS_BITS) - 1);
+        if (invertDepth) {
+            key = (key << DEPTH_BITS) | depth;
+        }
+        key = (key << PIPELINE_BITS) | (pipeline & ((1u << PIPELINE_BITS) - 1));
+        key = (key << MATERIAL_BITS) | (material & ((1u << MATERIAL_BITS) - 1));
+        key = (key << MESH_BITS) | (mesh & ((1u << MESH_BITS) - 1));
+        if (!invertDepth) {
+            key = (key << DEPTH_BITS) | depth;
+        }
+        return key;
+    }
+
+    void radixSortRenderQueue(std::vector<RenderQueueEntry>& entries, std::vector<RenderQueueEntry>& scratch) {
+        const size_t count = entries.size();
+        if (count < 2) return;
+
+        // counting passes don't pay off for a handful of draws
+        if (count < 64) {
+            std::stable_sort(entries.begin(), entries.end(),
+                [](const RenderQueueEntry& a, const RenderQueueEntry& b) { return a.key < b.key; });
+            return;
+        }
+
+        scratch.resize(count);
+        for (uint32_t shift = 0; shift < 64; shift += 8) {
+            uint32_t counts[256] = {};
+            for (const auto& entry : entries) {
+                counts[(entry.key >> shift) & 0xFF]++;
+            }
+            if (counts[(entries[0].key >> shift) & 0xFF] == count) {
+                continue;
+            }
+
+            uint32_t offsets[256];
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < 256; i++) {
+                offsets[i] = sum;
+                sum += counts[i];
+            }
+            for (const auto& entry : entries) {
+                scratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+            }
+            entries.swap(scratch);
+        }
+    }
+
+}  // namespace lve
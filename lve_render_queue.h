@@ -0,0 +1,73 @@
+#pragma once
+
+// std
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+    // 64-bit draw sort key, most significant field first:
+    //   pass (4) | pipeline (8) | material (16) | mesh (20) | depth (16)
+    // Sorting by it groups draws by state so redundant binds can be skipped while recording,
+    // and orders draws within a group front to back. Blended passes sort back to front across
+    // their whole pass instead, their order matters more than their state:
+    //   pass (4) | inverted depth (16) | pipeline (8) | material (16) | mesh (20)
+    namespace SortKey {
+        constexpr uint32_t PASS_BITS = 4;
+        constexpr uint32_t PIPELINE_BITS = 8;
+        constexpr uint32_t MATERIAL_BITS = 16;
+        constexpr uint32_t MESH_BITS = 20;
+        constexpr uint32_t DEPTH_BITS = 16;
+
+        enum Pass : uint32_t {
+            OPAQUE_PASS = 0,
+            ALPHA_TEST_PASS = 4,
+            TRANSPARENT_PASS = 8,
+        };
+
+        // depth01 is the normalized view distance, invertDepth sorts far to near (blended layout)
+        uint64_t make(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth01, bool invertDepth = false);
+    }
+
+    struct RenderQueueEntry {
+        uint64_t key;
+        uint32_t packetIndex;
+    };
+
+    // Stable LSD radix sort on the keys, 8 bits per pass; passes where every key has the same
+    // digit are skipped, which is most of the high ones in practice
+    void radixSortRenderQueue(std::vector<RenderQueueEntry>& entries, std::vector<RenderQueueEntry>& scratch);
+
+    // Per-frame list of draw packets. Systems submit packets with their sort key, sort() orders
+    // them and the recording loop walks them in order. Storage is kept between frames.
+    template <typename Packet>
+    class LveRenderQueue {
+    public:
+        void clear() {
+            entries.clear();
+            packets.clear();
+        }
+
+        void submit(uint64_t key, const Packet& packet) {
+            entries.push_back({ key, static_cast<uint32_t>(packets.size()) });
+            packets.push_back(packet);
+        }
+
+        void sort() { radixSortRenderQueue(entries, scratch); }
+
+        size_t size() const { return entries.size(); }
+        uint64_t keyAt(size_t i) const { return entries[i].key; }
+        const Packet& operator[](size_t i) const {
+            assert(i < entries.size() && "Render queue index out of range");
+            return packets[entries[i].packetIndex];
+        }
+
+    private:
+        std::vector<RenderQueueEntry> entries;
+        std::vector<RenderQueueEntry> scratch;
+        std::vector<Packet> packets;
+    };
+
+}  // namespace lve
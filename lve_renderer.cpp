@@ -21,7 +21,10 @@ namespace lve {
             extent = lveWindow.getExtent();
             glfwWaitEvents();
         }
-        vkDeviceWaitIdle(lveDevice.device());
+        // No vkDeviceWaitIdle here: the old swap chain retires its resources through the device
+        // deletion queue and the new one keeps its in-flight fences, so frames still executing
+        // on the GPU are left alone
+        swapChainGeneration++;
 
         if (lveSwapChain == nullptr) {
             lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent);
@@ -75,6 +78,15 @@ namespace lve {
 
         isFrameStarted = true;
 
+        // acquireNextImage waited on this slot's fence, so the frame submitted
+        // MAX_FRAMES_IN_FLIGHT frames ago (and everything before it) has finished
+        auto& deletionQueue = lveDevice.deletionQueue();
+        uint64_t submittedFrames = deletionQueue.getSubmittedFrameCount();
+        uint64_t completedFrames = submittedFrames >= LveSwapChain::MAX_FRAMES_IN_FLIGHT
+            ? submittedFrames - LveSwapChain::MAX_FRAMES_IN_FLIGHT + 1
+            : 0;
+        deletionQueue.beginFrame(completedFrames);
+
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -93,6 +105,8 @@ namespace lve {
         }
 
         auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+        lveDevice.deletionQueue().endFrame();
+
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
             lveWindow.wasWindowResized()) {
             lveWindow.resetWindowResizeFlag();
@@ -106,15 +120,26 @@ namespace lve {
         currentFrameIndex = (currentFrameIndex + 1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
     }
 
-    void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+    void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
         assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
         assert(
             commandBuffer == getCurrentCommandBuffer() &&
             "Can't begin render pass on command buffer from a different frame");
+        beginRenderPass(commandBuffer, lveSwapChain->getRenderPass(), contents);
+    }
+
+    void LveRenderer::resumeSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+        assert(isFrameStarted && "Can't call resumeSwapChainRenderPass if frame is not in progress");
+        assert(
+            commandBuffer == getCurrentCommandBuffer() &&
+            "Can't resume render pass on command buffer from a different frame");
+        beginRenderPass(commandBuffer, lveSwapChain->getResumeRenderPass(), VK_SUBPASS_CONTENTS_INLINE); // its load ops ignore the clear values
+    }
 
+    void LveRenderer::beginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkSubpassContents contents) {
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = lveSwapChain->getRenderPass();
+        renderPassInfo.renderPass = renderPass;
         renderPassInfo.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex);
 
         renderPassInfo.renderArea.offset = { 0, 0 };
@@ -126,7 +151,8 @@ namespace lve {
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+        if (contents != VK_SUBPASS_CONTENTS_INLINE) return;
 
         VkViewport viewport{};
         viewport.x = 0.0f;
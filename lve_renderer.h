@@ -19,7 +19,19 @@ namespace lve {
         LveRenderer& operator=(const LveRenderer&) = delete;
 
         VkRenderPass getSwapChainRenderPass() const { return lveSwapChain->getRenderPass(); }
+        // Changes whenever the swap chain, and with it the render pass, is recreated; handles of
+        // destroyed render passes can come back, so caches of recorded commands compare this
+        uint32_t getSwapChainGeneration() const { return swapChainGeneration; }
+        LveDepthTarget getCurrentDepthTarget() const {
+            assert(isFrameStarted && "Cannot get depth target when frame not in progress");
+            return lveSwapChain->getDepthTarget(currentImageIndex);
+        }
         float getAspectRatio() const { return lveSwapChain->extentAspectRatio(); }
+        VkExtent2D getExtent() const { return lveSwapChain->getSwapChainExtent(); }
+        VkFramebuffer getCurrentFramebuffer() const {
+            assert(isFrameStarted && "Cannot get framebuffer when frame not in progress");
+            return lveSwapChain->getFrameBuffer(currentImageIndex);
+        }
         bool isFrameInProgress() const { return isFrameStarted; }
 
         VkCommandBuffer getCurrentCommandBuffer() const {
@@ -34,20 +46,26 @@ namespace lve {
 
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the pass only takes vkCmdExecuteCommands,
+        // the secondary command buffers set their own viewport and scissor
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // Continues drawing into the attachments of the pass that was just ended, without clearing
+        void resumeSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
         void recreateSwapChain();
 
     private:
         void createCommandBuffers();
         void freeCommandBuffers();
+        void beginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkSubpassContents contents);
 
         LveWindow& lveWindow;
         LveDevice& lveDevice;
         std::unique_ptr<LveSwapChain> lveSwapChain;
         std::vector<VkCommandBuffer> commandBuffers;
 
+        uint32_t swapChainGeneration = 0;
         uint32_t currentImageIndex;
         int currentFrameIndex;
         bool isFrameStarted;
@@ -0,0 +1,34 @@
+#include "lve_resource_manager.h"
+
+namespace lve {
+
+    LveResourceManager::LveResourceManager(LveDevice& device) : lveDevice{ device } {}
+
+    LveResourceManager::~LveResourceManager() {}
+
+    TextureHandle LveResourceManager::loadTexture(const std::string& filepath, const std::string& alphaMaskFilepath) {
+        const std::string key = alphaMaskFilepath.empty() ? filepath : filepath + "|" + alphaMaskFilepath;
+        auto it = textureCache.find(key);
+        if (it != textureCache.end() && textures.isValid(it->second)) {
+            textures.addRef(it->second);
+            return it->second;
+        }
+
+        TextureHandle handle = textures.insert(std::make_unique<LveTexture>(lveDevice, filepath, alphaMaskFilepath));
+        if (texturePaths.size() < textures.capacity()) {
+            texturePaths.resize(textures.capacity());
+        }
+        texturePaths[handle.index] = key;
+        textureCache[key] = handle;
+        return handle;
+    }
+
+    void LveResourceManager::release(TextureHandle handle) {
+        uint32_t index = handle.index;
+        if (textures.release(handle)) {
+            textureCache.erase(texturePaths[index]);
+            texturePaths[index].clear();
+        }
+    }
+
+}  // namespace lve
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "lve_device.h"
+#include "lve_texture.h"
+
+// std
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+    // Typed index into an LveResourcePool. The generation is bumped every time a slot is
+    // released, so a handle that outlived its resource no longer validates instead of silently
+    // aliasing whatever gets allocated into the slot next.
+    template <typename T>
+    struct LveHandle {
+        static constexpr uint32_t INVALID_INDEX = ~0u;
+
+        uint32_t index = INVALID_INDEX;
+        uint32_t generation = 0;
+
+        bool isNull() const { return index == INVALID_INDEX; }
+        bool operator==(const LveHandle& other) const {
+            return index == other.index && generation == other.generation;
+        }
+        bool operator!=(const LveHandle& other) const { return !(*this == other); }
+    };
+
+    // Dense, slot-recycling storage with plain (non-atomic) reference counts. Everything is
+    // touched from the main thread only, so there is no need for shared_ptr control blocks.
+    template <typename T>
+    class LveResourcePool {
+    public:
+        using Handle = LveHandle<T>;
+
+        LveResourcePool() = default;
+        LveResourcePool(const LveResourcePool&) = delete;
+        LveResourcePool& operator=(const LveResourcePool&) = delete;
+
+        Handle insert(std::unique_ptr<T> resource) {
+            assert(resource && "Cannot insert a null resource");
+            uint32_t index;
+            if (!freeSlots.empty()) {
+                index = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            else {
+                index = static_cast<uint32_t>(resources.size());
+                resources.emplace_back();
+                generations.push_back(1);
+                refCounts.push_back(0);
+            }
+            resources[index] = std::move(resource);
+            refCounts[index] = 1;
+            liveCount++;
+            return Handle{ index, generations[index] };
+        }
+
+        bool isValid(Handle handle) const {
+            return handle.index < resources.size() &&
+                generations[handle.index] == handle.generation &&
+                resources[handle.index] != nullptr;
+        }
+
+        T* get(Handle handle) const {
+            assert(isValid(handle) && "Stale or null resource handle");
+            return isValid(handle) ? resources[handle.index].get() : nullptr;
+        }
+
+        void addRef(Handle handle) {
+            assert(isValid(handle) && "Cannot add a reference through a stale handle");
+            refCounts[handle.index]++;
+        }
+
+        // Returns true when the last reference was dropped and the resource destroyed
+        bool release(Handle handle) {
+            assert(isValid(handle) && "Cannot release a stale handle");
+            if (!isValid(handle) || --refCounts[handle.index] > 0) {
+                return false;
+            }
+            resources[handle.index].reset();
+            generations[handle.index]++;
+            freeSlots.push_back(handle.index);
+            liveCount--;
+            return true;
+        }
+
+        template <typename Fn>
+        void forEach(Fn&& fn) {
+            for (uint32_t i = 0; i < resources.size(); i++) {
+                if (resources[i]) {
+                    fn(Handle{ i, generations[i] }, *resources[i]);
+                }
+            }
+        }
+
+        // Number of slots ever allocated; arrays indexed by handle.index must be at least this long
+        uint32_t capacity() const { return static_cast<uint32_t>(resources.size()); }
+        uint32_t size() const { return liveCount; }
+
+    private:
+        std::vector<std::unique_ptr<T>> resources;
+        std::vector<uint32_t> generations;
+        std::vector<uint32_t> refCounts;
+        std::vector<uint32_t> freeSlots;
+        uint32_t liveCount = 0;
+    };
+
+    using TextureHandle = LveHandle<LveTexture>;
+
+    class LveResourceManager {
+    public:
+        LveResourceManager(LveDevice& device);
+        ~LveResourceManager();
+
+        LveResourceManager(const LveResourceManager&) = delete;
+        LveResourceManager& operator=(const LveResourceManager&) = delete;
+
+        // Loads the texture once per path (and alpha mask, see LveTexture); later calls return the
+        // same handle with one more reference
+        TextureHandle loadTexture(const std::string& filepath, const std::string& alphaMaskFilepath = "");
+        void retain(TextureHandle handle) { textures.addRef(handle); }
+        void release(TextureHandle handle);
+
+        bool isValid(TextureHandle handle) const { return textures.isValid(handle); }
+        LveTexture* getTexture(TextureHandle handle) const { return textures.get(handle); }
+        uint32_t getTextureCount() const { return textures.size(); }
+        uint32_t getTextureCapacity() const { return textures.capacity(); }
+
+        template <typename Fn>
+        void forEachTexture(Fn&& fn) { textures.forEach(std::forward<Fn>(fn)); }
+
+    private:
+        LveDevice& lveDevice;
+
+        LveResourcePool<LveTexture> textures;
+        std::vector<std::string> texturePaths; // indexed by handle.index, for cache eviction
+        std::unordered_map<std::string, TextureHandle> textureCache;
+    };
+
+}  // namespace lve
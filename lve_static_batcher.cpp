@@ -0,0 +1,133 @@
+#include "lve_static_batcher.h"
+
+#include "lve_occlusion.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace lve {
+
+    namespace {
+
+        struct Chunk {
+            std::vector<LveModel::Mesh> meshes; // one per texture
+            bool hasOccluders = false;
+        };
+
+        // Appends mesh, moved into world space, to merged
+        void appendMesh(LveModel::Mesh& merged, const LveModel::Mesh& mesh, const glm::mat4& modelMatrix, const glm::mat3& normalMatrix) {
+            const uint32_t baseVertex = static_cast<uint32_t>(merged.vertices.size());
+            for (LveModel::Vertex vertex : mesh.vertices) {
+                vertex.position = glm::vec3{ modelMatrix * glm::vec4{ vertex.position, 1.f } };
+                glm::vec3 normal = normalMatrix * vertex.normal;
+                float length = glm::length(normal);
+                vertex.normal = length > 0.f ? normal / length : normal; // meshes without normals keep zeros
+                merged.vertices.push_back(vertex);
+            }
+
+            // a mirroring transform flips the winding, which the merged mesh has to undo itself
+            const bool mirrored = glm::determinant(glm::mat3{ modelMatrix }) < 0.f;
+            const uint32_t indexCount = mesh.indices.empty() ? static_cast<uint32_t>(mesh.vertices.size()) : static_cast<uint32_t>(mesh.indices.size());
+            for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+                uint32_t triangle[3];
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    triangle[corner] = baseVertex + (mesh.indices.empty() ? i + corner : mesh.indices[i + corner]);
+                }
+                if (mirrored) std::swap(triangle[1], triangle[2]);
+                merged.indices.insert(merged.indices.end(), triangle, triangle + 3);
+            }
+        }
+
+    }  // namespace
+
+    LveStaticBatcher::Stats LveStaticBatcher::batch(
+        LveDevice& device,
+        LveResourceManager& resourceManager,
+        LveGameObject::Map& gameObjects,
+        float chunkSize) {
+        assert(chunkSize > 0.f && "Chunk size must be positive");
+        Stats stats{};
+        std::map<std::tuple<int, int, int>, Chunk> chunks; // ordered, so the result doesn't depend on the map's
+        std::vector<LveGameObject::id_t> merged;
+
+        for (auto& kv : gameObjects) {
+            auto& obj = kv.second;
+            if (!obj.isStatic || obj.model == nullptr || obj.lightComponent) continue;
+
+            const glm::mat4 modelMatrix = obj.transform.mat4();
+            const glm::mat3 normalMatrix = obj.transform.normalMatrix();
+            for (const auto& mesh : obj.model->meshes) {
+                if (mesh.vertices.empty()) continue;
+                glm::vec3 center = glm::vec3{ modelMatrix * glm::vec4{ (mesh.boundsMin + mesh.boundsMax) * 0.5f, 1.f } };
+                glm::vec3 cell = glm::floor(center / chunkSize);
+                Chunk& chunk = chunks[{ static_cast<int>(cell.x), static_cast<int>(cell.y), static_cast<int>(cell.z) }];
+                chunk.hasOccluders |= obj.occluder != nullptr;
+
+                const FragmentBuffer& material = mesh.fragmentBuffer;
+                auto target = std::find_if(chunk.meshes.begin(), chunk.meshes.end(), [&material](const LveModel::Mesh& other) {
+                    return other.fragmentBuffer.diffuseTexture == material.diffuseTexture && other.fragmentBuffer.alphaMode == material.alphaMode;
+                });
+                if (target == chunk.meshes.end()) {
+                    chunk.meshes.emplace_back();
+                    target = std::prev(chunk.meshes.end());
+                    target->fragmentBuffer = material;
+                    TextureHandle texture = material.diffuseTexture;
+                    if (resourceManager.isValid(texture)) {
+                        resourceManager.retain(texture); // released by the merged model, the source releases its own
+                    }
+                }
+                appendMesh(*target, mesh, modelMatrix, normalMatrix);
+                stats.drawsBefore++;
+            }
+            merged.push_back(obj.getId());
+        }
+
+        for (auto id : merged) {
+            gameObjects.erase(id);
+        }
+        stats.objects = static_cast<uint32_t>(merged.size());
+
+        for (auto& kv : chunks) {
+            Chunk& chunk = kv.second;
+            auto model = std::make_shared<LveModel>(device, resourceManager);
+            for (auto& mesh : chunk.meshes) {
+                if (mesh.indices.size() < 3) {
+                    // only degenerate input, nothing to draw, but the texture reference is still held
+                    if (resourceManager.isValid(mesh.fragmentBuffer.diffuseTexture)) {
+                        resourceManager.release(mesh.fragmentBuffer.diffuseTexture);
+                    }
+                    continue;
+                }
+                mesh.generateLods();
+                mesh.createVertexBuffers(device);
+                mesh.createIndexBuffers(device);
+                mesh.computeBounds();
+
+                model->boundsMin = model->meshes.empty() ? mesh.boundsMin : glm::min(model->boundsMin, mesh.boundsMin);
+                model->boundsMax = model->meshes.empty() ? mesh.boundsMax : glm::max(model->boundsMax, mesh.boundsMax);
+                stats.vertices += static_cast<uint32_t>(mesh.vertices.size());
+                stats.triangles += static_cast<uint32_t>(mesh.indices.size() / 3);
+                model->meshes.push_back(std::move(mesh));
+            }
+            if (model->meshes.empty()) continue;
+
+            auto chunkObj = LveGameObject::createGameObject();
+            chunkObj.isStatic = true;
+            if (chunk.hasOccluders) {
+                chunkObj.occluder = LveOccluder::createFromModel(*model);
+            }
+            stats.drawsAfter += static_cast<uint32_t>(model->meshes.size());
+            stats.chunks++;
+            chunkObj.model = std::move(model);
+            gameObjects.emplace(chunkObj.getId(), std::move(chunkObj));
+        }
+
+        return stats;
+    }
+
+}  // namespace lve
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "lve_device.h"
+#include "lve_game_object.h"
+#include "lve_resource_manager.h"
+
+// std
+#include <cstdint>
+
+namespace lve {
+
+    // Load-time merging of static geometry. The meshes of every game object flagged isStatic are
+    // pre-transformed into world space and appended to one mesh per material (diffuse texture and
+    // alpha mode, which picks the pipeline) and per chunk, a cube of a world space grid
+    // cell their bounds' center falls in. Each chunk becomes a new static game object with an
+    // identity transform, so a few hundred small draws turn into one per material per chunk while
+    // frustum and occlusion culling still reject whole chunks. The merged meshes get their own
+    // LODs, chunks whose objects had occluders get one built from the merged model.
+    //
+    // The source objects are removed from the map. Their transforms must not change afterwards
+    // anyway, and anything holding their ids has to look them up again.
+    class LveStaticBatcher {
+    public:
+        struct Stats {
+            uint32_t objects = 0;     // static objects merged away
+            uint32_t drawsBefore = 0; // meshes of those objects, one draw each per frame
+            uint32_t drawsAfter = 0;  // merged meshes
+            uint32_t chunks = 0;      // game objects they were merged into
+            uint32_t vertices = 0;
+            uint32_t triangles = 0;
+        };
+
+        static Stats batch(
+            LveDevice& device,
+            LveResourceManager& resourceManager,
+            LveGameObject::Map& gameObjects,
+            float chunkSize = 32.f);
+    };
+
+}  // namespace lve
@@ -33,44 +33,58 @@ namespace lve {
     }
 
     LveSwapChain::~LveSwapChain() {
-        for (auto imageView : swapChainImageViews) {
-            vkDestroyImageView(device.device(), imageView, nullptr);
-        }
-        swapChainImageViews.clear();
-
-        // Cleanup MSAA color image and view
-        if (colorImageView != VK_NULL_HANDLE) {
-            vkDestroyImageView(device.device(), colorImageView, nullptr);
-            colorImageView = VK_NULL_HANDLE;
-        }
-        if (colorImage != VK_NULL_HANDLE) {
-            vkDestroyImage(device.device(), colorImage, nullptr);
-            colorImage = VK_NULL_HANDLE;
-        }
-        if (colorImageMemory != VK_NULL_HANDLE) {
-            vkFreeMemory(device.device(), colorImageMemory, nullptr);
-            colorImageMemory = VK_NULL_HANDLE;
-        }
-
-        if (swapChain != nullptr) {
-            vkDestroySwapchainKHR(device.device(), swapChain, nullptr);
-            swapChain = nullptr;
-        }
-
-        for (int i = 0; i < depthImages.size(); i++) {
-            vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-            vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
-        }
-
-        for (auto framebuffer : swapChainFramebuffers) {
-            vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
-        }
-
-        vkDestroyRenderPass(device.device(), renderPass, nullptr);
-
-        // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        // Attachments, framebuffers and the render pass can still be referenced by frames in
+        // flight (e.g. after a resize or MSAA change), so they are handed to the deletion queue
+        // instead of waiting for the device to go idle
+        device.deletionQueue().retire(
+            [device = device.device(),
+            swapChain = swapChain,
+            renderPass = renderPass,
+            resumeRenderPass = resumeRenderPass,
+            swapChainImageViews = std::move(swapChainImageViews),
+            swapChainFramebuffers = std::move(swapChainFramebuffers),
+            depthImages = std::move(depthImages),
+            depthImageMemorys = std::move(depthImageMemorys),
+            depthImageViews = std::move(depthImageViews),
+            colorImage = colorImage,
+            colorImageMemory = colorImageMemory,
+            colorImageView = colorImageView]() {
+                for (auto imageView : swapChainImageViews) {
+                    vkDestroyImageView(device, imageView, nullptr);
+                }
+
+                // Cleanup MSAA color image and view
+                if (colorImageView != VK_NULL_HANDLE) {
+                    vkDestroyImageView(device, colorImageView, nullptr);
+                }
+                if (colorImage != VK_NULL_HANDLE) {
+                    vkDestroyImage(device, colorImage, nullptr);
+                }
+                if (colorImageMemory != VK_NULL_HANDLE) {
+                    vkFreeMemory(device, colorImageMemory, nullptr);
+                }
+
+                if (swapChain != nullptr) {
+                    vkDestroySwapchainKHR(device, swapChain, nullptr);
+                }
+
+                for (int i = 0; i < depthImages.size(); i++) {
+                    vkDestroyImageView(device, depthImageViews[i], nullptr);
+                    vkDestroyImage(device, depthImages[i], nullptr);
+                    vkFreeMemory(device, depthImageMemorys[i], nullptr);
+                }
+
+                for (auto framebuffer : swapChainFramebuffers) {
+                    vkDestroyFramebuffer(device, framebuffer, nullptr);
+                }
+
+                vkDestroyRenderPass(device, renderPass, nullptr);
+                vkDestroyRenderPass(device, resumeRenderPass, nullptr);
+            });
+        swapChain = nullptr;
+
+        // cleanup synchronization objects (empty if a newer swap chain adopted them)
+        for (size_t i = 0; i < inFlightFences.size(); i++) {
             vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
             vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
             vkDestroyFence(device.device(), inFlightFences[i], nullptr);
@@ -267,7 +281,7 @@ namespace lve {
         colorAttachment.format = getSwapChainImageFormat();
         colorAttachment.samples = msaaSamples;
         colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // kept for the resume pass
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -289,7 +303,7 @@ namespace lve {
         depthAttachment.format = findDepthFormat();
         depthAttachment.samples = msaaSamples;
         depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // read by the depth pyramid, kept for the resume pass
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -338,6 +352,27 @@ namespace lve {
         if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
             throw std::runtime_error("failed to create render pass!");
         }
+
+        // Resume pass: same attachments, continuing from what the first pass stored. Compute work
+        // in between (depth pyramid, occlusion culling) synchronizes the depth image itself.
+        attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDependency resumeDependency{};
+        resumeDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        resumeDependency.dstSubpass = 0;
+        resumeDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        resumeDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        resumeDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        resumeDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        renderPassInfo.pDependencies = &resumeDependency;
+
+        if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &resumeRenderPass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create resume render pass!");
+        }
     }
 
     void LveSwapChain::createFramebuffers() {
@@ -390,7 +425,7 @@ namespace lve {
             imageInfo.format = depthFormat;
             imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
             imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT; // sampled for the depth pyramid
             imageInfo.samples = device.getMsaaSampleCount();
             imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
             imageInfo.flags = 0;
@@ -419,10 +454,24 @@ namespace lve {
     }
 
     void LveSwapChain::createSyncObjects() {
+        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+
+        // Keep the previous swap chain's fences so waiting on them still proves that the frames
+        // submitted before the recreation have finished (fresh fences start out signaled)
+        if (oldSwapChain != nullptr && oldSwapChain->inFlightFences.size() == MAX_FRAMES_IN_FLIGHT) {
+            imageAvailableSemaphores = std::move(oldSwapChain->imageAvailableSemaphores);
+            renderFinishedSemaphores = std::move(oldSwapChain->renderFinishedSemaphores);
+            inFlightFences = std::move(oldSwapChain->inFlightFences);
+            currentFrame = oldSwapChain->currentFrame;
+            oldSwapChain->imageAvailableSemaphores.clear();
+            oldSwapChain->renderFinishedSemaphores.clear();
+            oldSwapChain->inFlightFences.clear();
+            return;
+        }
+
         imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
         renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
         inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
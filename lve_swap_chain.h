@@ -12,6 +12,16 @@
 
 namespace lve {
 
+    // Depth attachment of one swap chain image, for compute passes that read the frame's depth
+    // between the render pass and its resumed continuation
+    struct LveDepthTarget {
+        VkImage image;
+        VkImageView view; // depth aspect only, can be sampled
+        VkFormat format;
+        VkExtent2D extent;
+        VkSampleCountFlagBits samples;
+    };
+
     class LveSwapChain {
     public:
         static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
@@ -27,6 +37,12 @@ namespace lve {
 
         VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
         VkRenderPass getRenderPass() { return renderPass; }
+        // Compatible with getRenderPass() (same framebuffers and pipelines), but loads the color
+        // and depth the previous pass stored instead of clearing them
+        VkRenderPass getResumeRenderPass() { return resumeRenderPass; }
+        LveDepthTarget getDepthTarget(int index) {
+            return { depthImages[index], depthImageViews[index], swapChainDepthFormat, swapChainExtent, device.getMsaaSampleCount() };
+        }
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
         size_t imageCount() { return swapChainImages.size(); }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
@@ -69,6 +85,7 @@ namespace lve {
 
         std::vector<VkFramebuffer> swapChainFramebuffers;
         VkRenderPass renderPass;
+        VkRenderPass resumeRenderPass;
 
         std::vector<VkImage> depthImages;
         std::vector<VkDeviceMemory> depthImageMemorys;
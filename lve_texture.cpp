@@ -14,26 +14,53 @@ namespace lve {
         return std::make_shared<LveTexture>(device, filepath);
     }
 
-    LveTexture::LveTexture(LveDevice& device, const std::string& filepath) : lveDevice{ device } {
-        createTextureImage(filepath);
+    LveTexture::LveTexture(LveDevice& device, const std::string& filepath, const std::string& alphaMaskFilepath)
+        : lveDevice{ device } {
+        createTextureImage(filepath, alphaMaskFilepath);
         createTextureImageView();
         createTextureSampler();
     }
 
     LveTexture::~LveTexture() {
-        vkDestroySampler(lveDevice.device(), sampler, nullptr);
-        vkDestroyImageView(lveDevice.device(), imageView, nullptr);
-        vkDestroyImage(lveDevice.device(), image, nullptr);
-        vkFreeMemory(lveDevice.device(), memory, nullptr);
+        lveDevice.deletionQueue().retire(
+            [device = lveDevice.device(), sampler = sampler, imageView = imageView, image = image, memory = memory]() {
+                vkDestroySampler(device, sampler, nullptr);
+                vkDestroyImageView(device, imageView, nullptr);
+                vkDestroyImage(device, image, nullptr);
+                vkFreeMemory(device, memory, nullptr);
+            });
     }
 
-    void LveTexture::createTextureImage(const std::string& filepath) {
+    void LveTexture::createTextureImage(const std::string& filepath, const std::string& alphaMaskFilepath) {
         stbi_uc* pixels = stbi_load(filepath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
         if (!pixels) {
             throw std::runtime_error("failed to load texture image: " + filepath);
         }
         VkDeviceSize imageSize = texWidth * texHeight * 4;
 
+        if (!alphaMaskFilepath.empty()) {
+            int maskWidth, maskHeight, maskChannels;
+            stbi_uc* mask = stbi_load(alphaMaskFilepath.c_str(), &maskWidth, &maskHeight, &maskChannels, STBI_grey);
+            if (!mask) {
+                stbi_image_free(pixels);
+                throw std::runtime_error("failed to load alpha mask: " + alphaMaskFilepath);
+            }
+            for (int y = 0; y < texHeight; y++) {
+                const int maskY = y * maskHeight / texHeight; // nearest texel
+                for (int x = 0; x < texWidth; x++) {
+                    pixels[(y * texWidth + x) * 4 + 3] = mask[maskY * maskWidth + x * maskWidth / texWidth];
+                }
+            }
+            stbi_image_free(mask);
+        }
+
+        uint32_t partialTexels = 0;
+        for (int i = 0; i < texWidth * texHeight; i++) {
+            const stbi_uc alpha = pixels[i * 4 + 3];
+            partialTexels += alpha > 8 && alpha < 247;
+        }
+        partialAlphaFraction = static_cast<float>(partialTexels) / static_cast<float>(texWidth * texHeight);
+
         // staging buffer
         LveBuffer stagingBuffer{
             lveDevice,
@@ -10,7 +10,9 @@ namespace lve {
 
     class LveTexture {
     public:
-        LveTexture(LveDevice& device, const std::string& filepath);
+        // With an alphaMaskFilepath the mask's intensity (e.g. an OBJ material's map_d) replaces the
+        // image's alpha, so masked materials still bind one texture. It is resampled if its size differs.
+        LveTexture(LveDevice& device, const std::string& filepath, const std::string& alphaMaskFilepath = "");
         ~LveTexture();
 
         LveTexture(const LveTexture&) = delete;
@@ -18,11 +20,14 @@ namespace lve {
 
         VkImageView getImageView() const { return imageView; }
         VkSampler getSampler() const { return sampler; }
+        // Share of texels whose alpha is neither (almost) 0 nor 1: soft edges and see-through
+        // surfaces rather than a cut-out mask
+        float getPartialAlphaFraction() const { return partialAlphaFraction; }
 
         static std::shared_ptr<LveTexture> createFromFile(LveDevice& device, const std::string& filepath);
 
     private:
-        void createTextureImage(const std::string& filepath);
+        void createTextureImage(const std::string& filepath, const std::string& alphaMaskFilepath);
         void createTextureImageView();
         void createTextureSampler();
 
@@ -33,6 +38,7 @@ namespace lve {
         VkImageView imageView{};
         VkSampler sampler{};
         int texWidth{}, texHeight{}, texChannels{};
+        float partialAlphaFraction = 0.f;
     };
 
 }  // namespace lve
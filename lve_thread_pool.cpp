@@ -0,0 +1,78 @@
+#include "lve_thread_pool.h"
+
+// std
+#include <algorithm>
+
+namespace lve {
+
+    LveThreadPool::LveThreadPool(uint32_t threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (uint32_t i = 1; i < threadCount; i++) {
+            workers.emplace_back(&LveThreadPool::workerLoop, this, i);
+        }
+    }
+
+    LveThreadPool::~LveThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            stopping = true;
+        }
+        wakeCondition.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void LveThreadPool::parallelFor(uint32_t count, const Job& job) {
+        if (workers.empty() || count <= 1) {
+            for (uint32_t i = 0; i < count; i++) {
+                job(i, 0);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            currentJob = &job;
+            jobCount = count;
+            nextIndex = 0;
+            activeWorkers = static_cast<uint32_t>(workers.size());
+            generation++;
+        }
+        wakeCondition.notify_all();
+
+        runJobs(0);
+
+        std::unique_lock<std::mutex> lock{ mutex };
+        doneCondition.wait(lock, [this]() { return activeWorkers == 0; });
+        currentJob = nullptr;
+    }
+
+    void LveThreadPool::workerLoop(uint32_t threadIndex) {
+        uint32_t seenGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock{ mutex };
+                wakeCondition.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+                if (stopping) return;
+                seenGeneration = generation;
+            }
+
+            runJobs(threadIndex);
+
+            std::lock_guard<std::mutex> lock{ mutex };
+            if (--activeWorkers == 0) {
+                doneCondition.notify_one();
+            }
+        }
+    }
+
+    void LveThreadPool::runJobs(uint32_t threadIndex) {
+        for (uint32_t i = nextIndex.fetch_add(1); i < jobCount; i = nextIndex.fetch_add(1)) {
+            (*currentJob)(i, threadIndex);
+        }
+    }
+
+}  // namespace lve
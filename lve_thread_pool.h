@@ -0,0 +1,52 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+    // Fixed set of worker threads for data parallel loops. parallelFor hands out indices one at a
+    // time, so uneven work (tiles, chunks) balances itself, and the calling thread works too.
+    // One loop at a time: parallelFor must not be called from inside a job or from two threads.
+    class LveThreadPool {
+    public:
+        using Job = std::function<void(uint32_t index, uint32_t threadIndex)>;
+
+        // threadCount includes the calling thread, 0 uses every hardware thread
+        explicit LveThreadPool(uint32_t threadCount = 0);
+        ~LveThreadPool();
+
+        LveThreadPool(const LveThreadPool&) = delete;
+        LveThreadPool& operator=(const LveThreadPool&) = delete;
+
+        // Runs job(index, threadIndex) for every index in [0, count) and returns when all are done.
+        // threadIndex is below getThreadCount() and unique among the jobs running at the same time,
+        // for per-thread scratch data.
+        void parallelFor(uint32_t count, const Job& job);
+
+        uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+
+    private:
+        void workerLoop(uint32_t threadIndex);
+        void runJobs(uint32_t threadIndex);
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wakeCondition;
+        std::condition_variable doneCondition;
+
+        const Job* currentJob = nullptr;
+        uint32_t jobCount = 0;
+        std::atomic<uint32_t> nextIndex{ 0 };
+        uint32_t generation = 0;    // bumped per loop, workers wait for it to change
+        uint32_t activeWorkers = 0; // workers that haven't finished the current loop
+        bool stopping = false;
+    };
+
+}  // namespace lve
@@ -0,0 +1,195 @@
+#include "lve_transform_store.h"
+
+// std
+#include <algorithm>
+#include <immintrin.h>
+
+namespace lve {
+
+    namespace {
+
+        constexpr uint32_t FREE_SLOT = 0; // sync frames start at 1
+
+        // sin and cos of 4 angles, Cephes' single precision polynomials on [-pi/4, pi/4] after
+        // reducing by multiples of pi/2 in three parts. Accurate to a few ulp for the angles a
+        // transform sees, larger ones lose precision in the reduction like any float sincos.
+        void sinCos4(__m128 x, __m128& sine, __m128& cosine) {
+            const __m128 twoOverPi = _mm_set1_ps(0.636619772367581343f);
+            const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, twoOverPi)); // round to nearest
+            const __m128 q = _mm_cvtepi32_ps(quadrant);
+
+            __m128 y = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(1.5703125f)));
+            y = _mm_sub_ps(y, _mm_mul_ps(q, _mm_set1_ps(4.837512969970703125e-4f)));
+            y = _mm_sub_ps(y, _mm_mul_ps(q, _mm_set1_ps(7.54978995489188216e-8f)));
+            const __m128 z = _mm_mul_ps(y, y);
+
+            __m128 sinPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), z), _mm_set1_ps(8.3321608736e-3f));
+            sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(-1.6666654611e-1f));
+            sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), y), y);
+
+            __m128 cosPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), z), _mm_set1_ps(-1.388731625493765e-3f));
+            cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(4.166664568298827e-2f));
+            cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+            cosPoly = _mm_add_ps(_mm_sub_ps(cosPoly, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.f));
+
+            // odd quadrants swap the two, sin is negative in quadrants 2 and 3, cos in 1 and 2
+            const __m128i one = _mm_set1_epi32(1);
+            const __m128i two = _mm_set1_epi32(2);
+            const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+            const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+            const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+
+            sine = _mm_or_ps(_mm_and_ps(swap, cosPoly), _mm_andnot_ps(swap, sinPoly));
+            cosine = _mm_or_ps(_mm_and_ps(swap, sinPoly), _mm_andnot_ps(swap, cosPoly));
+            sine = _mm_xor_ps(sine, sinSign);
+            cosine = _mm_xor_ps(cosine, cosSign);
+        }
+
+    }  // namespace
+
+    void LveTransformStore::sync(LveGameObject::Map& gameObjects) {
+        syncFrame++;
+        for (auto& kv : gameObjects) {
+            auto& obj = kv.second;
+            if (obj.model == nullptr) continue;
+
+            uint32_t slot = obj.transformSlot;
+            if (slot >= owners.size() || lastSync[slot] == FREE_SLOT || owners[slot] != obj.getId()) {
+                slot = obj.transformSlot = allocate();
+                owners[slot] = obj.getId();
+            }
+            lastSync[slot] = syncFrame;
+            set(slot, obj.transform);
+        }
+
+        for (uint32_t slot = 0; slot < lastSync.size(); slot++) {
+            if (lastSync[slot] != FREE_SLOT && lastSync[slot] != syncFrame) {
+                release(slot);
+            }
+        }
+        update();
+    }
+
+    uint32_t LveTransformStore::allocate() {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            slot = static_cast<uint32_t>(matrices.size());
+            for (auto* values : { &translationX, &translationY, &translationZ, &rotationX, &rotationY, &rotationZ,
+                &scaleX, &scaleY, &scaleZ }) {
+                values->push_back(0.f);
+            }
+            dirty.push_back(0);
+            matrices.emplace_back(1.f);
+            normalMatrices.emplace_back(1.f);
+            lastSync.push_back(FREE_SLOT);
+            owners.push_back(0);
+        }
+
+        lastSync[slot] = std::max(syncFrame, 1u);
+        if (!dirty[slot]) {
+            dirty[slot] = 1;
+            dirtySlots.push_back(slot);
+        }
+        return slot;
+    }
+
+    void LveTransformStore::release(uint32_t slot) {
+        assert(slot < lastSync.size() && lastSync[slot] != FREE_SLOT && "Releasing a free transform slot");
+        lastSync[slot] = FREE_SLOT;
+        freeSlots.push_back(slot);
+    }
+
+    void LveTransformStore::set(uint32_t slot, const TransformComponent& transform) {
+        assert(slot < matrices.size() && "Transform slot out of range");
+        if (!dirty[slot] &&
+            translationX[slot] == transform.translation.x && translationY[slot] == transform.translation.y &&
+            translationZ[slot] == transform.translation.z && rotationX[slot] == transform.rotation.x &&
+            rotationY[slot] == transform.rotation.y && rotationZ[slot] == transform.rotation.z &&
+            scaleX[slot] == transform.scale.x && scaleY[slot] == transform.scale.y && scaleZ[slot] == transform.scale.z) {
+            return;
+        }
+
+        translationX[slot] = transform.translation.x;
+        translationY[slot] = transform.translation.y;
+        translationZ[slot] = transform.translation.z;
+        rotationX[slot] = transform.rotation.x;
+        rotationY[slot] = transform.rotation.y;
+        rotationZ[slot] = transform.rotation.z;
+        scaleX[slot] = transform.scale.x;
+        scaleY[slot] = transform.scale.y;
+        scaleZ[slot] = transform.scale.z;
+        if (!dirty[slot]) {
+            dirty[slot] = 1;
+            dirtySlots.push_back(slot);
+        }
+    }
+
+    // Same matrices as TransformComponent::mat4 and normalMatrix, for 4 dirty slots at a time (the
+    // last batch repeats its last slot)
+    void LveTransformStore::update() {
+        updatedCount = static_cast<uint32_t>(dirtySlots.size());
+        for (size_t first = 0; first < dirtySlots.size(); first += 4) {
+            uint32_t slots[4];
+            for (size_t lane = 0; lane < 4; lane++) {
+                slots[lane] = dirtySlots[std::min(first + lane, dirtySlots.size() - 1)];
+            }
+            auto gather = [&slots](const std::vector<float>& values) {
+                return _mm_setr_ps(values[slots[0]], values[slots[1]], values[slots[2]], values[slots[3]]);
+            };
+
+            __m128 s1, c1, s2, c2, s3, c3;
+            sinCos4(gather(rotationY), s1, c1);
+            sinCos4(gather(rotationX), s2, c2);
+            sinCos4(gather(rotationZ), s3, c3);
+
+            // rotation Ry * Rx * Rz by columns
+            const __m128 s1s2 = _mm_mul_ps(s1, s2);
+            const __m128 c1s2 = _mm_mul_ps(c1, s2);
+            const __m128 rotation[9] = {
+                _mm_add_ps(_mm_mul_ps(c1, c3), _mm_mul_ps(s1s2, s3)),
+                _mm_mul_ps(c2, s3),
+                _mm_sub_ps(_mm_mul_ps(c1s2, s3), _mm_mul_ps(c3, s1)),
+                _mm_sub_ps(_mm_mul_ps(s1s2, c3), _mm_mul_ps(c1, s3)),
+                _mm_mul_ps(c2, c3),
+                _mm_add_ps(_mm_mul_ps(c1s2, c3), _mm_mul_ps(s1, s3)),
+                _mm_mul_ps(c2, s1),
+                _mm_sub_ps(_mm_setzero_ps(), s2),
+                _mm_mul_ps(c1, c2),
+            };
+            const __m128 one = _mm_set1_ps(1.f);
+            const __m128 scale[3] = { gather(scaleX), gather(scaleY), gather(scaleZ) };
+            const __m128 inverseScale[3] = { _mm_div_ps(one, scale[0]), _mm_div_ps(one, scale[1]), _mm_div_ps(one, scale[2]) };
+
+            alignas(16) float scaled[9][4];
+            alignas(16) float inverseScaled[9][4];
+            for (int i = 0; i < 9; i++) {
+                _mm_store_ps(scaled[i], _mm_mul_ps(rotation[i], scale[i / 3]));
+                _mm_store_ps(inverseScaled[i], _mm_mul_ps(rotation[i], inverseScale[i / 3]));
+            }
+
+            for (int lane = 0; lane < 4; lane++) {
+                const uint32_t slot = slots[lane];
+                glm::mat4& matrix = matrices[slot];
+                glm::mat3& normalMatrix = normalMatrices[slot];
+                for (int column = 0; column < 3; column++) {
+                    for (int row = 0; row < 3; row++) {
+                        matrix[column][row] = scaled[column * 3 + row][lane];
+                        normalMatrix[column][row] = inverseScaled[column * 3 + row][lane];
+                    }
+                    matrix[column][3] = 0.f;
+                }
+                matrix[3] = glm::vec4{ translationX[slot], translationY[slot], translationZ[slot], 1.f };
+            }
+        }
+
+        for (uint32_t slot : dirtySlots) {
+            dirty[slot] = 0;
+        }
+        dirtySlots.clear();
+    }
+
+}  // namespace lve
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "lve_game_object.h"
+
+//libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+    // World and normal matrices of the game objects, cached until their transform changes. The
+    // transform values are kept in SoA form: set() compares the new ones against them and flags
+    // the slot dirty when they differ, update() rebuilds the dirty matrices 4 at a time with SSE,
+    // sines and cosines included. A static object costs a compare per frame instead of six trig
+    // calls per use.
+    //
+    // Game objects stay the place transforms are written to; sync() copies them in every frame
+    // and gives each object a slot (LveGameObject::transformSlot) on first sight.
+    class LveTransformStore {
+    public:
+        static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+        // Sets every object with a model and recycles the slots of objects that are gone (or lost
+        // their model), then updates. A store is used either through sync() or slot by slot.
+        void sync(LveGameObject::Map& gameObjects);
+
+        // New slots are dirty until their first update()
+        uint32_t allocate();
+        void release(uint32_t slot);
+        void set(uint32_t slot, const TransformComponent& transform);
+        void update();
+
+        const glm::mat4& getMatrix(uint32_t slot) const {
+            assert(slot < matrices.size() && !dirty[slot] && "Transform slot is out of date");
+            return matrices[slot];
+        }
+        const glm::mat3& getNormalMatrix(uint32_t slot) const {
+            assert(slot < normalMatrices.size() && !dirty[slot] && "Transform slot is out of date");
+            return normalMatrices[slot];
+        }
+
+        uint32_t getSlotCount() const { return static_cast<uint32_t>(matrices.size()); }
+        // matrices rebuilt by the last update()
+        uint32_t getUpdatedCount() const { return updatedCount; }
+
+    private:
+        std::vector<float> translationX, translationY, translationZ;
+        std::vector<float> rotationX, rotationY, rotationZ;
+        std::vector<float> scaleX, scaleY, scaleZ;
+        std::vector<uint8_t> dirty;
+        std::vector<uint32_t> dirtySlots;
+        std::vector<glm::mat4> matrices;
+        std::vector<glm::mat3> normalMatrices;
+
+        std::vector<uint32_t> lastSync; // sync() frame that last saw the slot, FREE_SLOT when released
+        std::vector<LveGameObject::id_t> owners;
+        std::vector<uint32_t> freeSlots;
+        uint32_t syncFrame = 0;
+        uint32_t updatedCount = 0;
+    };
+
+}  // namespace lve